@@ -37,12 +37,20 @@
 #include <math.h>
 #include <float.h>
 #include <numpy/arrayobject.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <dynmat.h>
 #include <derivative_dynmat.h>
 #include <kgrid.h>
 #include <tetrahedron_method.h>
+#ifdef PHPY_LAPACK
+#include <phonon.h>
+#endif
 
 #define KB 8.6173382568083159E-05
+/* Number of atoms along a side of a tile of full fc */
+#define FC_TILE_SIZE 32
 
 /* PHPYCONST is defined in dynmat.h */
 
@@ -53,16 +61,28 @@ static PyObject *
 py_perm_trans_symmetrize_compact_fc(PyObject *self, PyObject *args);
 static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args);
 static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args);
+static PyObject * py_get_dynamical_matrices(PyObject *self, PyObject *args);
+#ifdef PHPY_LAPACK
+static PyObject * py_get_phonons_at_qpoints(PyObject *self, PyObject *args);
+static PyObject * py_get_group_velocities(PyObject *self, PyObject *args);
+#endif
 static PyObject * py_get_dipole_dipole(PyObject *self, PyObject *args);
 static PyObject * py_get_dipole_dipole_q0(PyObject *self, PyObject *args);
+static PyObject *
+py_set_dipole_dipole_workspace(PyObject *self, PyObject *args);
 static PyObject * py_get_derivative_dynmat(PyObject *self, PyObject *args);
+static PyObject * py_get_derivative_dynmats(PyObject *self, PyObject *args);
 static PyObject * py_get_thermal_properties(PyObject *self, PyObject *args);
 static PyObject *
+py_symmetrize_group_velocities(PyObject *self, PyObject *args);
+static PyObject *
 py_distribute_fc2_with_mappings(PyObject *self, PyObject *args);
 static PyObject * py_compute_permutation(PyObject *self, PyObject *args);
 static PyObject * py_gsv_copy_smallest_vectors(PyObject *self, PyObject *args);
 
 static void distribute_fc2_with_mappings(double (*fc2)[3][3],
+                                         double (*fc2_compact)[3][3],
+                                         const int * done_rows,
                                          const int * atom_list,
                                          const int len_atom_list,
                                          PHPYCONST double (*r_carts)[3][3],
@@ -71,6 +91,9 @@ static void distribute_fc2_with_mappings(double (*fc2)[3][3],
                                          const int * map_syms,
                                          const int num_rot,
                                          const int num_pos);
+static void add_rotated_fc2_elem(double fc2_todo[3][3],
+                                 PHPYCONST double r_cart[3][3],
+                                 PHPYCONST double fc2_done[3][3]);
 
 static int compute_permutation(int * rot_atom,
                                   PHPYCONST double lat[3][3],
@@ -95,19 +118,60 @@ static PyObject *
 py_thm_integration_weight(PyObject *self, PyObject *args);
 static PyObject *
 py_thm_integration_weight_at_omegas(PyObject *self, PyObject *args);
+static PyObject * py_get_tetrahedra_vertices(PyObject *self, PyObject *args);
 static PyObject * py_get_tetrahedra_frequenies(PyObject *self, PyObject *args);
 static PyObject * py_tetrahedron_method_dos(PyObject *self, PyObject *args);
-
-static double get_free_energy_omega(const double temperature,
-                                    const double omega);
-static double get_entropy_omega(const double temperature,
-                                const double omega);
-static double get_heat_capacity_omega(const double temperature,
-                                      const double omega);
+static PyObject *
+py_tetrahedron_method_dos_with_vertices(PyObject *self, PyObject *args);
+
+static void tetrahedron_method_dos(double *dos,
+                                   const double *freq_points,
+                                   const int num_freq_points,
+                                   const double *frequencies,
+                                   const int num_ir_gp,
+                                   const int num_band,
+                                   const double *coef,
+                                   const int num_coef,
+                                   const int *weights,
+                                   PHPYCONST int (*vertices)[24][4]);
+static void get_tetrahedra_vertices(int vertices[24][4],
+                                    const int gp,
+                                    const int mesh[3],
+                                    PHPYCONST int (*grid_address)[3],
+                                    const int *gp_ir_index,
+                                    PHPYCONST int (*relative_grid_address)[4][3]);
+static void add_thermal_properties_at_q(double *tp,
+                                        const double *temperatures,
+                                        const int num_temp,
+                                        const double *freqs,
+                                        const int num_bands,
+                                        const int weight);
+static void symmetrize_group_velocity_at_q(double (*gv)[3],
+                                           const int num_band,
+                                           const double q[3],
+                                           PHPYCONST int (*rotations)[3][3],
+                                           PHPYCONST double (*r_carts)[3][3],
+                                           const int num_rot,
+                                           const double symprec);
 static void set_index_permutation_symmetry_fc(double * fc,
                                               const int natom);
+static void set_index_permutation_symmetry_fc_tile(double * fc,
+                                                   const int natom,
+                                                   const int tile_i,
+                                                   const int tile_j);
 static void set_translational_symmetry_fc(double * fc,
                                           const int natom);
+static void set_index_permutation_symmetry_compact_fc(double * fc,
+                                                      const int p2s[],
+                                                      const int s2pp[],
+                                                      const int nsym_list[],
+                                                      const int perms[],
+                                                      const int n_satom,
+                                                      const int n_patom);
+static void set_translational_symmetry_compact_fc(double * fc,
+                                                  const int p2s[],
+                                                  const int n_satom,
+                                                  const int n_patom);
 /* static double get_energy_omega(double temperature, double omega); */
 static int nint(const double a);
 
@@ -142,14 +206,28 @@ static PyMethodDef _phonopy_methods[] = {
    "Dynamical matrix"},
   {"nac_dynamical_matrix", py_get_nac_dynamical_matrix, METH_VARARGS,
    "NAC dynamical matrix"},
+  {"dynamical_matrices", py_get_dynamical_matrices, METH_VARARGS,
+   "Dynamical matrices at q-points"},
+#ifdef PHPY_LAPACK
+  {"phonons_at_qpoints", py_get_phonons_at_qpoints, METH_VARARGS,
+   "Phonons at q-points by LAPACK zheev"},
+  {"group_velocities", py_get_group_velocities, METH_VARARGS,
+   "Group velocities at q-points from eigenvectors"},
+#endif
   {"dipole_dipole", py_get_dipole_dipole, METH_VARARGS,
    "Dipole-dipole interaction"},
   {"dipole_dipole_q0", py_get_dipole_dipole_q0, METH_VARARGS,
    "q=0 terms of Dipole-dipole interaction"},
+  {"dipole_dipole_workspace", py_set_dipole_dipole_workspace, METH_VARARGS,
+   "q-independent G-space terms of Dipole-dipole interaction"},
   {"derivative_dynmat", py_get_derivative_dynmat, METH_VARARGS,
    "Q derivative of dynamical matrix"},
+  {"derivative_dynmats", py_get_derivative_dynmats, METH_VARARGS,
+   "Q derivatives of dynamical matrices at q-points"},
   {"thermal_properties", py_get_thermal_properties, METH_VARARGS,
    "Thermal properties"},
+  {"symmetrize_group_velocities", py_symmetrize_group_velocities,
+   METH_VARARGS, "Symmetrize group velocities by little groups of q-points"},
   {"distribute_fc2_with_mappings", py_distribute_fc2_with_mappings,
    METH_VARARGS,
    "Distribute force constants for all atoms in atom_list using precomputed symmetry mappings."},
@@ -169,10 +247,15 @@ static PyMethodDef _phonopy_methods[] = {
   {"tetrahedra_integration_weight_at_omegas",
    py_thm_integration_weight_at_omegas,
    METH_VARARGS, "Integration weight for tetrahedron method at omegas"},
+  {"tetrahedra_vertices", py_get_tetrahedra_vertices,
+   METH_VARARGS, "Ir-grid-point indices of vertices of 24 tetrahedra"},
   {"get_tetrahedra_frequencies", py_get_tetrahedra_frequenies,
    METH_VARARGS, "Run tetrahedron method"},
   {"tetrahedron_method_dos", py_tetrahedron_method_dos,
    METH_VARARGS, "Run tetrahedron method"},
+  {"tetrahedron_method_dos_with_vertices",
+   py_tetrahedron_method_dos_with_vertices,
+   METH_VARARGS, "Run tetrahedron method with tetrahedra vertices"},
   {NULL, NULL, 0, NULL}
 };
 
@@ -242,6 +325,9 @@ static PyObject * py_transform_dynmat_to_fc(PyObject *self, PyObject *args)
   PyArrayObject* py_multiplicities;
   PyArrayObject* py_masses;
   PyArrayObject* py_s2pp_map;
+  PyArrayObject* py_lattice_points;
+  PyArrayObject* py_lattice_index;
+  PyArrayObject* py_positions;
 
   double* fc;
   double* dm;
@@ -252,15 +338,26 @@ static PyObject * py_transform_dynmat_to_fc(PyObject *self, PyObject *args)
   int* s2pp_map;
   int num_patom;
   int num_satom;
+  int (*lattice_points)[3];
+  int num_lattice_points;
+  int (*lattice_index)[27];
+  double (*pos)[3];
 
-  if (!PyArg_ParseTuple(args, "OOOOOOO",
+  py_lattice_points = NULL;
+  py_lattice_index = NULL;
+  py_positions = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOO|OOO",
                         &py_force_constants,
                         &py_dynamical_matrices,
                         &py_commensurate_points,
                         &py_shortest_vectors,
                         &py_multiplicities,
                         &py_masses,
-                        &py_s2pp_map)) {
+                        &py_s2pp_map,
+                        &py_lattice_points,
+                        &py_lattice_index,
+                        &py_positions)) {
     return NULL;
   }
 
@@ -274,6 +371,18 @@ static PyObject * py_transform_dynmat_to_fc(PyObject *self, PyObject *args)
   num_patom = PyArray_DIMS(py_multiplicities)[1];
   num_satom = PyArray_DIMS(py_multiplicities)[0];
 
+  if (py_lattice_points == NULL || (PyObject*)py_lattice_points == Py_None) {
+    lattice_points = NULL;
+    num_lattice_points = 0;
+    lattice_index = NULL;
+    pos = NULL;
+  } else {
+    lattice_points = (int(*)[3])PyArray_DATA(py_lattice_points);
+    num_lattice_points = PyArray_DIMS(py_lattice_points)[0];
+    lattice_index = (int(*)[27])PyArray_DATA(py_lattice_index);
+    pos = (double(*)[3])PyArray_DATA(py_positions);
+  }
+
   dym_transform_dynmat_to_fc(fc,
                              dm,
                              comm_points,
@@ -281,6 +390,10 @@ static PyObject * py_transform_dynmat_to_fc(PyObject *self, PyObject *args)
                              multiplicities,
                              masses,
                              s2pp_map,
+                             lattice_points,
+                             num_lattice_points,
+                             lattice_index,
+                             pos,
                              num_patom,
                              num_satom);
 
@@ -372,17 +485,21 @@ static PyObject * py_perm_trans_symmetrize_fc(PyObject *self, PyObject *args)
 {
   PyArrayObject* force_constants;
   double *fc;
-  int natom;
+  int natom, iteration, i;
+
+  iteration = 1;
 
-  if (!PyArg_ParseTuple(args, "O", &force_constants)) {
+  if (!PyArg_ParseTuple(args, "O|i", &force_constants, &iteration)) {
     return NULL;
   }
 
   fc = (double*)PyArray_DATA(force_constants);
   natom = PyArray_DIMS(force_constants)[0];
 
-  set_index_permutation_symmetry_fc(fc, natom);
-  set_translational_symmetry_fc(fc, natom);
+  for (i = 0; i < iteration; i++) {
+    set_index_permutation_symmetry_fc(fc, natom);
+    set_translational_symmetry_fc(fc, natom);
+  }
 
   Py_RETURN_NONE;
 }
@@ -394,25 +511,24 @@ py_perm_trans_symmetrize_compact_fc(PyObject *self, PyObject *args)
   PyArrayObject* py_permutations;
   PyArrayObject* py_s2p_map;
   PyArrayObject* py_p2s_map;
-  double sums[3][3];
   double *fc;
   int *s2p;
   int *p2s;
   int *perms;
-  int n_patom, n_satom, nsym, i_p, i, j, k, l, m, n, target;
+  int n_patom, n_satom, nsym, iteration, i, j;
   int *nsym_list;
   int *s2pp;
-  double *fc_tmp;
 
   nsym_list = NULL;
   s2pp = NULL;
-  fc_tmp = NULL;
+  iteration = 1;
 
-  if (!PyArg_ParseTuple(args, "OOOO",
+  if (!PyArg_ParseTuple(args, "OOOO|i",
                         &py_fc,
                         &py_permutations,
                         &py_s2p_map,
-                        &py_p2s_map)) {
+                        &py_p2s_map,
+                        &iteration)) {
     return NULL;
   }
 
@@ -424,92 +540,46 @@ py_perm_trans_symmetrize_compact_fc(PyObject *self, PyObject *args)
   n_satom = PyArray_DIMS(py_fc)[1];
   nsym = PyArray_DIMS(py_permutations)[0];
 
-  nsym_list = (int*) malloc(sizeof(int) * n_satom);
-  for (i = 0; i < n_satom; i++) {
-    nsym_list[i] = -1;
-  }
-
+  /* s2pp is made through the inverse map of p2s stored temporarily. */
   s2pp = (int*) malloc(sizeof(int) * n_satom);
   for (i = 0; i < n_satom; i++) {
     s2pp[i] = -1;
-    for (j = 0; j < n_patom; j++) {
-      if (p2s[j] == s2p[i]) {
-        s2pp[i] = j;
-        break;
-      }
-    }
   }
-
-  fc_tmp = (double*) malloc(sizeof(double) * n_patom * n_satom * 3 * 3);
-  for (i = 0; i < n_patom * n_satom * 3 * 3; i++) {
-    fc_tmp[i] = 0;
+  for (i = 0; i < n_patom; i++) {
+    s2pp[p2s[i]] = i;
   }
-
   for (i = 0; i < n_satom; i++) {
-    target = s2p[i];
-    for (j = 0; j < nsym; j++) {
-      if (perms[j * n_satom + i] == target) {
-        nsym_list[i] = j;
-        break;
-      }
-    }
+    s2pp[i] = s2pp[s2p[i]];
   }
 
-#pragma omp parallel for private(i_p, i, k, l, m, n)
-  for (j = 0; j < n_satom; j++) {
-    for (i_p = 0; i_p < n_patom; i_p++) {
-      i = p2s[i_p];
-      if (i == j) { /* diagnoal part */
-        for (k = 0; k < 3; k++) {
-          for (l = 0; l < 3; l++) {
-            m = i_p * n_satom * 9 + i * 9 + k * 3 + l;
-            n = i_p * n_satom * 9 + i * 9 + l * 3 + k;
-            fc_tmp[m] = (fc[m] + fc[n]) / 2;
-          }
-        }
-      } else { /* non diagonal part */
-        for (k = 0; k < 3; k++) {
-          for (l = 0; l < 3; l++) {
-            m = i_p * n_satom * 9 + j * 9 + k * 3 + l;
-            n = s2pp[j] * n_satom * 9 + perms[nsym_list[j] * n_satom + i] * 9 + l * 3 + k;
-            fc_tmp[m] = (fc[n] + fc[m]) / 2;
-          }
-        }
-      }
-    }
+  /* nsym_list[j]: translation that sends atom j to s2p[j] */
+  nsym_list = (int*) malloc(sizeof(int) * n_satom);
+  for (i = 0; i < n_satom; i++) {
+    nsym_list[i] = -1;
   }
-
-  for (i_p = 0; i_p < n_patom; i_p++) {
-    for (k = 0; k < 3; k++) {
-      for (l = 0; l < 3; l++) {
-        sums[k][l] = 0;
-        m = i_p * n_satom * 9 + k * 3 + l;
-        for (j = 0; j < n_satom; j++) {
-          if (p2s[i_p] != j) {
-            sums[k][l] += fc_tmp[m];
-          }
-          m += 9;
-        }
-      }
-    }
-    for (k = 0; k < 3; k++) {
-      for (l = 0; l < 3; l++) {
-        fc_tmp[i_p * n_satom * 9 + p2s[i_p] * 9 + k * 3 + l] =
-          -(sums[k][l] + sums[l][k]) / 2;
+  for (j = 0; j < nsym; j++) {
+    for (i = 0; i < n_satom; i++) {
+      if (nsym_list[i] < 0 && perms[j * n_satom + i] == s2p[i]) {
+        nsym_list[i] = j;
       }
     }
   }
 
-  for (i = 0; i < n_patom * n_satom * 3 * 3; i++) {
-    fc[i] = fc_tmp[i];
+  for (i = 0; i < iteration; i++) {
+    set_index_permutation_symmetry_compact_fc(fc,
+                                              p2s,
+                                              s2pp,
+                                              nsym_list,
+                                              perms,
+                                              n_satom,
+                                              n_patom);
+    set_translational_symmetry_compact_fc(fc, p2s, n_satom, n_patom);
   }
 
   free(nsym_list);
   nsym_list = NULL;
   free(s2pp);
   s2pp = NULL;
-  free(fc_tmp);
-  fc_tmp = NULL;
 
   Py_RETURN_NONE;
 }
@@ -524,6 +594,11 @@ static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args)
   PyArrayObject* py_masses;
   PyArrayObject* py_s2p_map;
   PyArrayObject* py_p2s_map;
+  PyArrayObject* py_lattice_points;
+  PyArrayObject* py_lattice_index;
+  PyArrayObject* py_positions;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
 
   double* dm;
   double* fc;
@@ -535,8 +610,20 @@ static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args)
   int* p2s_map;
   int num_patom;
   int num_satom;
+  int (*lattice_points)[3];
+  int num_lattice_points;
+  int (*lattice_index)[27];
+  double (*pos)[3];
+  int* pair_ptr;
+  int* pair_atoms;
 
-  if (!PyArg_ParseTuple(args, "OOOOOOOO",
+  py_lattice_points = NULL;
+  py_lattice_index = NULL;
+  py_positions = NULL;
+  py_pair_ptr = NULL;
+  py_pair_atoms = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOO|OOOOO",
                         &py_dynamical_matrix,
                         &py_force_constants,
                         &py_q,
@@ -544,7 +631,12 @@ static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args)
                         &py_multiplicities,
                         &py_masses,
                         &py_s2p_map,
-                        &py_p2s_map)) {
+                        &py_p2s_map,
+                        &py_lattice_points,
+                        &py_lattice_index,
+                        &py_positions,
+                        &py_pair_ptr,
+                        &py_pair_atoms)) {
     return NULL;
   }
 
@@ -559,6 +651,26 @@ static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args)
   num_patom = PyArray_DIMS(py_p2s_map)[0];
   num_satom = PyArray_DIMS(py_s2p_map)[0];
 
+  if (py_lattice_points == NULL || (PyObject*)py_lattice_points == Py_None) {
+    lattice_points = NULL;
+    num_lattice_points = 0;
+    lattice_index = NULL;
+    pos = NULL;
+  } else {
+    lattice_points = (int(*)[3])PyArray_DATA(py_lattice_points);
+    num_lattice_points = PyArray_DIMS(py_lattice_points)[0];
+    lattice_index = (int(*)[27])PyArray_DATA(py_lattice_index);
+    pos = (double(*)[3])PyArray_DATA(py_positions);
+  }
+
+  if (py_pair_ptr == NULL || (PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
+
   dym_get_dynamical_matrix_at_q(dm,
                                 num_patom,
                                 num_satom,
@@ -570,6 +682,12 @@ static PyObject * py_get_dynamical_matrix(PyObject *self, PyObject *args)
                                 s2p_map,
                                 p2s_map,
                                 NULL,
+                                lattice_points,
+                                num_lattice_points,
+                                lattice_index,
+                                pos,
+                                pair_ptr,
+                                pair_atoms,
                                 1);
 
   Py_RETURN_NONE;
@@ -588,6 +706,9 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
   PyArrayObject* py_s2p_map;
   PyArrayObject* py_p2s_map;
   PyArrayObject* py_born;
+  PyArrayObject* py_lattice_points;
+  PyArrayObject* py_lattice_index;
+  PyArrayObject* py_positions;
   double factor;
 
   double* dm;
@@ -603,10 +724,19 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
   int num_patom;
   int num_satom;
 
+  int (*lattice_points)[3];
+  int num_lattice_points;
+  int (*lattice_index)[27];
+  double (*pos)[3];
+
   int n;
   double (*charge_sum)[3][3];
 
-  if (!PyArg_ParseTuple(args, "OOOOOOOOOOd",
+  py_lattice_points = NULL;
+  py_lattice_index = NULL;
+  py_positions = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOOd|OOO",
                         &py_dynamical_matrix,
                         &py_force_constants,
                         &py_q,
@@ -617,7 +747,10 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
                         &py_p2s_map,
                         &py_q_cart,
                         &py_born,
-                        &factor))
+                        &factor,
+                        &py_lattice_points,
+                        &py_lattice_index,
+                        &py_positions))
     return NULL;
 
   dm = (double*)PyArray_DATA(py_dynamical_matrix);
@@ -633,6 +766,18 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
   num_patom = PyArray_DIMS(py_p2s_map)[0];
   num_satom = PyArray_DIMS(py_s2p_map)[0];
 
+  if (py_lattice_points == NULL || (PyObject*)py_lattice_points == Py_None) {
+    lattice_points = NULL;
+    num_lattice_points = 0;
+    lattice_index = NULL;
+    pos = NULL;
+  } else {
+    lattice_points = (int(*)[3])PyArray_DATA(py_lattice_points);
+    num_lattice_points = PyArray_DIMS(py_lattice_points)[0];
+    lattice_index = (int(*)[27])PyArray_DATA(py_lattice_index);
+    pos = (double(*)[3])PyArray_DATA(py_positions);
+  }
+
   charge_sum = (double(*)[3][3])
     malloc(sizeof(double[3][3]) * num_patom * num_patom);
   n = num_satom / num_patom;
@@ -649,6 +794,12 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
                                 s2p_map,
                                 p2s_map,
                                 charge_sum,
+                                lattice_points,
+                                num_lattice_points,
+                                lattice_index,
+                                pos,
+                                NULL,
+                                NULL,
                                 1);
 
   free(charge_sum);
@@ -656,172 +807,669 @@ static PyObject * py_get_nac_dynamical_matrix(PyObject *self, PyObject *args)
   Py_RETURN_NONE;
 }
 
-static PyObject * py_get_dipole_dipole(PyObject *self, PyObject *args)
+static PyObject * py_get_dynamical_matrices(PyObject *self, PyObject *args)
 {
-  PyArrayObject* py_dd;
-  PyArrayObject* py_dd_q0;
-  PyArrayObject* py_G_list;
+  PyArrayObject* py_dynamical_matrices;
+  PyArrayObject* py_force_constants;
+  PyArrayObject* py_shortest_vectors;
+  PyArrayObject* py_qpoints;
+  PyArrayObject* py_multiplicities;
+  PyArrayObject* py_masses;
+  PyArrayObject* py_s2p_map;
+  PyArrayObject* py_p2s_map;
+  PyArrayObject* py_lattice_points;
+  PyArrayObject* py_lattice_index;
+  PyArrayObject* py_positions;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
   PyArrayObject* py_q_cart;
-  PyArrayObject* py_q_direction;
   PyArrayObject* py_born;
-  PyArrayObject* py_dielectric;
-  PyArrayObject* py_positions;
-  double factor;
-  double lambda;
-  double tolerance;
+  PyArrayObject* py_nac_factors;
 
-  double* dd;
-  double* dd_q0;
-  double (*G_list)[3];
-  double* q_vector;
-  double* q_direction;
-  double (*born)[3][3];
-  double (*dielectric)[3];
+  double* dm;
+  double* fc;
+  double (*qpoints)[3];
+  double (*svecs)[27][3];
+  double* m;
+  int* multi;
+  int* s2p_map;
+  int* p2s_map;
+  int (*lattice_points)[3];
+  int num_lattice_points;
+  int (*lattice_index)[27];
   double (*pos)[3];
-  int num_patom, num_G;
+  int* pair_ptr;
+  int* pair_atoms;
+  double (*q_cart)[3];
+  double (*born)[3][3];
+  double* nac_factors;
+  int num_patom;
+  int num_satom;
+  int num_qpoints;
 
-  if (!PyArg_ParseTuple(args, "OOOOOOOOddd",
-                        &py_dd,
-                        &py_dd_q0,
-                        &py_G_list,
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOOOOOOOO",
+                        &py_dynamical_matrices,
+                        &py_force_constants,
+                        &py_qpoints,
+                        &py_shortest_vectors,
+                        &py_multiplicities,
+                        &py_masses,
+                        &py_s2p_map,
+                        &py_p2s_map,
+                        &py_lattice_points,
+                        &py_lattice_index,
+                        &py_positions,
+                        &py_pair_ptr,
+                        &py_pair_atoms,
                         &py_q_cart,
-                        &py_q_direction,
                         &py_born,
-                        &py_dielectric,
-                        &py_positions,
-                        &factor,
-                        &lambda,
-                        &tolerance))
+                        &py_nac_factors)) {
     return NULL;
+  }
 
+  dm = (double*)PyArray_DATA(py_dynamical_matrices);
+  fc = (double*)PyArray_DATA(py_force_constants);
+  qpoints = (double(*)[3])PyArray_DATA(py_qpoints);
+  num_qpoints = PyArray_DIMS(py_qpoints)[0];
+  svecs = (double(*)[27][3])PyArray_DATA(py_shortest_vectors);
+  m = (double*)PyArray_DATA(py_masses);
+  multi = (int*)PyArray_DATA(py_multiplicities);
+  s2p_map = (int*)PyArray_DATA(py_s2p_map);
+  p2s_map = (int*)PyArray_DATA(py_p2s_map);
+  num_patom = PyArray_DIMS(py_p2s_map)[0];
+  num_satom = PyArray_DIMS(py_s2p_map)[0];
 
-  dd = (double*)PyArray_DATA(py_dd);
-  dd_q0 = (double*)PyArray_DATA(py_dd_q0);
-  G_list = (double(*)[3])PyArray_DATA(py_G_list);
-  if ((PyObject*)py_q_direction == Py_None) {
-    q_direction = NULL;
+  if ((PyObject*)py_lattice_points == Py_None) {
+    lattice_points = NULL;
+    num_lattice_points = 0;
+    lattice_index = NULL;
+    pos = NULL;
   } else {
-    q_direction = (double*)PyArray_DATA(py_q_direction);
+    lattice_points = (int(*)[3])PyArray_DATA(py_lattice_points);
+    num_lattice_points = PyArray_DIMS(py_lattice_points)[0];
+    lattice_index = (int(*)[27])PyArray_DATA(py_lattice_index);
+    pos = (double(*)[3])PyArray_DATA(py_positions);
   }
-  q_vector = (double*)PyArray_DATA(py_q_cart);
-  born = (double(*)[3][3])PyArray_DATA(py_born);
-  dielectric = (double(*)[3])PyArray_DATA(py_dielectric);
-  pos = (double(*)[3])PyArray_DATA(py_positions);
-  num_G = PyArray_DIMS(py_G_list)[0];
-  num_patom = PyArray_DIMS(py_positions)[0];
-
-  dym_get_dipole_dipole(dd, /* [natom, 3, natom, 3, (real, imag)] */
-                        dd_q0, /* [natom, 3, 3, (real, imag)] */
-                        G_list, /* [num_kvec, 3] */
-                        num_G,
-                        num_patom,
-                        q_vector,
-                        q_direction,
-                        born,
-                        dielectric,
-                        pos, /* [natom, 3] */
-                        factor, /* 4pi/V*unit-conv */
-                        lambda, /* 4 * Lambda^2 */
-                        tolerance);
-
-  Py_RETURN_NONE;
-}
-
-static PyObject * py_get_dipole_dipole_q0(PyObject *self, PyObject *args)
-{
-  PyArrayObject* py_dd_q0;
-  PyArrayObject* py_G_list;
-  PyArrayObject* py_born;
-  PyArrayObject* py_dielectric;
-  PyArrayObject* py_positions;
-  double lambda;
-  double tolerance;
-
-  double* dd_q0;
-  double (*G_list)[3];
-  double (*born)[3][3];
-  double (*dielectric)[3];
-  double (*pos)[3];
-  int num_patom, num_G;
-
-  if (!PyArg_ParseTuple(args, "OOOOOdd",
-                        &py_dd_q0,
-                        &py_G_list,
-                        &py_born,
-                        &py_dielectric,
-                        &py_positions,
-                        &lambda,
-                        &tolerance))
-    return NULL;
 
+  if ((PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
 
-  dd_q0 = (double*)PyArray_DATA(py_dd_q0);
-  G_list = (double(*)[3])PyArray_DATA(py_G_list);
-  born = (double(*)[3][3])PyArray_DATA(py_born);
-  dielectric = (double(*)[3])PyArray_DATA(py_dielectric);
-  pos = (double(*)[3])PyArray_DATA(py_positions);
-  num_G = PyArray_DIMS(py_G_list)[0];
-  num_patom = PyArray_DIMS(py_positions)[0];
+  if ((PyObject*)py_born == Py_None) {
+    q_cart = NULL;
+    born = NULL;
+    nac_factors = NULL;
+  } else {
+    q_cart = (double(*)[3])PyArray_DATA(py_q_cart);
+    born = (double(*)[3][3])PyArray_DATA(py_born);
+    nac_factors = (double*)PyArray_DATA(py_nac_factors);
+  }
 
-  dym_get_dipole_dipole_q0(dd_q0, /* [natom, 3, 3, (real, imag)] */
-                           G_list, /* [num_kvec, 3] */
-                           num_G,
-                           num_patom,
-                           born,
-                           dielectric,
-                           pos, /* [natom, 3] */
-                           lambda, /* 4 * Lambda^2 */
-                           tolerance);
+  dym_get_dynamical_matrices_at_qpoints(dm,
+                                        num_qpoints,
+                                        qpoints,
+                                        num_patom,
+                                        num_satom,
+                                        fc,
+                                        svecs,
+                                        multi,
+                                        m,
+                                        s2p_map,
+                                        p2s_map,
+                                        lattice_points,
+                                        num_lattice_points,
+                                        lattice_index,
+                                        pos,
+                                        pair_ptr,
+                                        pair_atoms,
+                                        q_cart,
+                                        born,
+                                        nac_factors);
 
   Py_RETURN_NONE;
 }
 
-static PyObject * py_get_derivative_dynmat(PyObject *self, PyObject *args)
+#ifdef PHPY_LAPACK
+static PyObject * py_get_phonons_at_qpoints(PyObject *self, PyObject *args)
 {
-  PyArrayObject* derivative_dynmat;
+  PyArrayObject* py_frequencies;
+  PyArrayObject* py_eigenvectors;
+  PyArrayObject* py_dynamical_matrices;
   PyArrayObject* py_force_constants;
-  PyArrayObject* r_vector;
-  PyArrayObject* lattice;
-  PyArrayObject* q_vector;
+  PyArrayObject* py_shortest_vectors;
+  PyArrayObject* py_qpoints;
   PyArrayObject* py_multiplicities;
   PyArrayObject* py_masses;
   PyArrayObject* py_s2p_map;
   PyArrayObject* py_p2s_map;
+  PyArrayObject* py_lattice_points;
+  PyArrayObject* py_lattice_index;
+  PyArrayObject* py_positions;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
+  PyArrayObject* py_q_cart;
   PyArrayObject* py_born;
-  PyArrayObject* dielectric;
-  PyArrayObject* q_direction;
-  double nac_factor;
+  PyArrayObject* py_nac_factors;
+  double unit_conversion_factor;
+  char* uplo;
 
-  double* ddm;
+  double* freqs;
+  double* eigvecs;
+  double* dms;
   double* fc;
-  double* q;
-  double* lat;
-  double* r;
+  double (*qpoints)[3];
+  double (*svecs)[27][3];
   double* m;
   int* multi;
   int* s2p_map;
   int* p2s_map;
+  int (*lattice_points)[3];
+  int num_lattice_points;
+  int (*lattice_index)[27];
+  double (*pos)[3];
+  int* pair_ptr;
+  int* pair_atoms;
+  double (*q_cart)[3];
+  double (*born)[3][3];
+  double* nac_factors;
   int num_patom;
   int num_satom;
+  int num_qpoints;
+  int num_failed;
 
-  double *z;
-  double *epsilon;
-  double *q_dir;
-
-  if (!PyArg_ParseTuple(args, "OOOOOOOOOdOOO",
-                        &derivative_dynmat,
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOOOOOOOOOOds",
+                        &py_frequencies,
+                        &py_eigenvectors,
+                        &py_dynamical_matrices,
                         &py_force_constants,
-                        &q_vector,
-                        &lattice, /* column vectors */
-                        &r_vector,
+                        &py_qpoints,
+                        &py_shortest_vectors,
                         &py_multiplicities,
                         &py_masses,
                         &py_s2p_map,
                         &py_p2s_map,
-                        &nac_factor,
+                        &py_lattice_points,
+                        &py_lattice_index,
+                        &py_positions,
+                        &py_pair_ptr,
+                        &py_pair_atoms,
+                        &py_q_cart,
+                        &py_born,
+                        &py_nac_factors,
+                        &unit_conversion_factor,
+                        &uplo)) {
+    return NULL;
+  }
+
+  freqs = (double*)PyArray_DATA(py_frequencies);
+  num_qpoints = PyArray_DIMS(py_frequencies)[0];
+  num_patom = PyArray_DIMS(py_frequencies)[1] / 3;
+  if ((PyObject*)py_eigenvectors == Py_None) {
+    eigvecs = NULL;
+  } else {
+    eigvecs = (double*)PyArray_DATA(py_eigenvectors);
+  }
+
+  /* Either precomputed dynamical matrices or arguments to build them */
+  dms = NULL;
+  fc = NULL;
+  qpoints = NULL;
+  svecs = NULL;
+  m = NULL;
+  multi = NULL;
+  s2p_map = NULL;
+  p2s_map = NULL;
+  num_satom = 0;
+  if ((PyObject*)py_dynamical_matrices != Py_None) {
+    dms = (double*)PyArray_DATA(py_dynamical_matrices);
+  } else {
+    fc = (double*)PyArray_DATA(py_force_constants);
+    qpoints = (double(*)[3])PyArray_DATA(py_qpoints);
+    svecs = (double(*)[27][3])PyArray_DATA(py_shortest_vectors);
+    m = (double*)PyArray_DATA(py_masses);
+    multi = (int*)PyArray_DATA(py_multiplicities);
+    s2p_map = (int*)PyArray_DATA(py_s2p_map);
+    p2s_map = (int*)PyArray_DATA(py_p2s_map);
+    num_satom = PyArray_DIMS(py_s2p_map)[0];
+  }
+
+  if ((PyObject*)py_lattice_points == Py_None) {
+    lattice_points = NULL;
+    num_lattice_points = 0;
+    lattice_index = NULL;
+    pos = NULL;
+  } else {
+    lattice_points = (int(*)[3])PyArray_DATA(py_lattice_points);
+    num_lattice_points = PyArray_DIMS(py_lattice_points)[0];
+    lattice_index = (int(*)[27])PyArray_DATA(py_lattice_index);
+    pos = (double(*)[3])PyArray_DATA(py_positions);
+  }
+
+  if ((PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
+
+  if ((PyObject*)py_born == Py_None) {
+    q_cart = NULL;
+    born = NULL;
+    nac_factors = NULL;
+  } else {
+    q_cart = (double(*)[3])PyArray_DATA(py_q_cart);
+    born = (double(*)[3][3])PyArray_DATA(py_born);
+    nac_factors = (double*)PyArray_DATA(py_nac_factors);
+  }
+
+  num_failed = phn_get_phonons_at_qpoints(freqs,
+                                          eigvecs,
+                                          dms,
+                                          num_qpoints,
+                                          qpoints,
+                                          num_patom,
+                                          num_satom,
+                                          fc,
+                                          svecs,
+                                          multi,
+                                          m,
+                                          s2p_map,
+                                          p2s_map,
+                                          lattice_points,
+                                          num_lattice_points,
+                                          lattice_index,
+                                          pos,
+                                          pair_ptr,
+                                          pair_atoms,
+                                          q_cart,
+                                          born,
+                                          nac_factors,
+                                          unit_conversion_factor,
+                                          uplo[0]);
+
+  return Py_BuildValue("i", num_failed);
+}
+
+static PyObject * py_get_group_velocities(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_group_velocities;
+  PyArrayObject* py_frequencies;
+  PyArrayObject* py_eigenvectors;
+  PyArrayObject* py_qpoints;
+  PyArrayObject* py_perturbation;
+  PyArrayObject* py_force_constants;
+  PyArrayObject* py_lattice;
+  PyArrayObject* py_shortest_vectors;
+  PyArrayObject* py_multiplicities;
+  PyArrayObject* py_masses;
+  PyArrayObject* py_s2p_map;
+  PyArrayObject* py_p2s_map;
+  PyArrayObject* py_born;
+  PyArrayObject* py_dielectric;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
+  double nac_factor;
+  double unit_conversion_factor;
+  double cutoff_frequency;
+  double degenerate_cutoff;
+
+  double (*gv)[3];
+  double* freqs;
+  double* eigvecs;
+  double (*qpoints)[3];
+  double* perturbation;
+  double* fc;
+  double* lattice;
+  double (*svecs)[27][3];
+  int* multi;
+  double* m;
+  int* s2p_map;
+  int* p2s_map;
+  double* born;
+  double* dielectric;
+  int* pair_ptr;
+  int* pair_atoms;
+  int num_patom;
+  int num_satom;
+  int num_qpoints;
+  int num_failed;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOOOOdOOOOddd",
+                        &py_group_velocities,
+                        &py_frequencies,
+                        &py_eigenvectors,
+                        &py_qpoints,
+                        &py_perturbation,
+                        &py_force_constants,
+                        &py_lattice, /* column vectors */
+                        &py_shortest_vectors,
+                        &py_multiplicities,
+                        &py_masses,
+                        &py_s2p_map,
+                        &py_p2s_map,
+                        &nac_factor,
+                        &py_born,
+                        &py_dielectric,
+                        &py_pair_ptr,
+                        &py_pair_atoms,
+                        &unit_conversion_factor,
+                        &cutoff_frequency,
+                        &degenerate_cutoff)) {
+    return NULL;
+  }
+
+  gv = (double(*)[3])PyArray_DATA(py_group_velocities);
+  freqs = (double*)PyArray_DATA(py_frequencies);
+  eigvecs = (double*)PyArray_DATA(py_eigenvectors);
+  qpoints = (double(*)[3])PyArray_DATA(py_qpoints);
+  num_qpoints = PyArray_DIMS(py_qpoints)[0];
+  perturbation = (double*)PyArray_DATA(py_perturbation);
+  fc = (double*)PyArray_DATA(py_force_constants);
+  lattice = (double*)PyArray_DATA(py_lattice);
+  svecs = (double(*)[27][3])PyArray_DATA(py_shortest_vectors);
+  multi = (int*)PyArray_DATA(py_multiplicities);
+  m = (double*)PyArray_DATA(py_masses);
+  s2p_map = (int*)PyArray_DATA(py_s2p_map);
+  p2s_map = (int*)PyArray_DATA(py_p2s_map);
+  num_patom = PyArray_DIMS(py_p2s_map)[0];
+  num_satom = PyArray_DIMS(py_s2p_map)[0];
+
+  if ((PyObject*)py_born == Py_None) {
+    born = NULL;
+    dielectric = NULL;
+  } else {
+    born = (double*)PyArray_DATA(py_born);
+    dielectric = (double*)PyArray_DATA(py_dielectric);
+  }
+  if ((PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
+
+  num_failed = phn_get_group_velocities_at_qpoints(gv,
+                                                   freqs,
+                                                   eigvecs,
+                                                   num_qpoints,
+                                                   qpoints,
+                                                   perturbation,
+                                                   num_patom,
+                                                   num_satom,
+                                                   fc,
+                                                   lattice,
+                                                   svecs,
+                                                   multi,
+                                                   m,
+                                                   s2p_map,
+                                                   p2s_map,
+                                                   nac_factor,
+                                                   born,
+                                                   dielectric,
+                                                   pair_ptr,
+                                                   pair_atoms,
+                                                   unit_conversion_factor,
+                                                   cutoff_frequency,
+                                                   degenerate_cutoff);
+
+  return Py_BuildValue("i", num_failed);
+}
+#endif
+
+static PyObject * py_get_dipole_dipole(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_dd;
+  PyArrayObject* py_dd_q0;
+  PyArrayObject* py_G_list;
+  PyArrayObject* py_q_cart;
+  PyArrayObject* py_q_direction;
+  PyArrayObject* py_born;
+  PyArrayObject* py_dielectric;
+  PyArrayObject* py_positions;
+  PyArrayObject* py_dd_tmp;
+  PyArrayObject* py_G_phases;
+  PyArrayObject* py_eps_G;
+  PyArrayObject* py_G_eps_G;
+  PyArrayObject* py_G_norm2;
+  double factor;
+  double lambda;
+  double tolerance;
+
+  double* dd;
+  double* dd_q0;
+  double (*G_list)[3];
+  double* q_vector;
+  double* q_direction;
+  double (*born)[3][3];
+  double (*dielectric)[3];
+  double (*pos)[3];
+  int num_patom, num_G;
+  DipoleDipoleWorkspace ws;
+
+  py_dd_tmp = NULL;
+  py_G_phases = NULL;
+  py_eps_G = NULL;
+  py_G_eps_G = NULL;
+  py_G_norm2 = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOddd|OOOOO",
+                        &py_dd,
+                        &py_dd_q0,
+                        &py_G_list,
+                        &py_q_cart,
+                        &py_q_direction,
+                        &py_born,
+                        &py_dielectric,
+                        &py_positions,
+                        &factor,
+                        &lambda,
+                        &tolerance,
+                        &py_dd_tmp,
+                        &py_G_phases,
+                        &py_eps_G,
+                        &py_G_eps_G,
+                        &py_G_norm2))
+    return NULL;
+
+
+  dd = (double*)PyArray_DATA(py_dd);
+  dd_q0 = (double*)PyArray_DATA(py_dd_q0);
+  G_list = (double(*)[3])PyArray_DATA(py_G_list);
+  if ((PyObject*)py_q_direction == Py_None) {
+    q_direction = NULL;
+  } else {
+    q_direction = (double*)PyArray_DATA(py_q_direction);
+  }
+  q_vector = (double*)PyArray_DATA(py_q_cart);
+  born = (double(*)[3][3])PyArray_DATA(py_born);
+  dielectric = (double(*)[3])PyArray_DATA(py_dielectric);
+  pos = (double(*)[3])PyArray_DATA(py_positions);
+  num_G = PyArray_DIMS(py_G_list)[0];
+  num_patom = PyArray_DIMS(py_positions)[0];
+  if (py_G_norm2 != NULL) {
+    ws.dd_tmp = (double*)PyArray_DATA(py_dd_tmp);
+    ws.G_phases = (double(*)[2])PyArray_DATA(py_G_phases);
+    ws.eps_G = (double(*)[3])PyArray_DATA(py_eps_G);
+    ws.G_eps_G = (double*)PyArray_DATA(py_G_eps_G);
+    ws.G_norm2 = (double*)PyArray_DATA(py_G_norm2);
+  }
+
+  dym_get_dipole_dipole(dd, /* [natom, 3, natom, 3, (real, imag)] */
+                        dd_q0, /* [natom, 3, 3, (real, imag)] */
+                        G_list, /* [num_kvec, 3] */
+                        num_G,
+                        num_patom,
+                        q_vector,
+                        q_direction,
+                        born,
+                        dielectric,
+                        pos, /* [natom, 3] */
+                        factor, /* 4pi/V*unit-conv */
+                        lambda, /* 4 * Lambda^2 */
+                        tolerance,
+                        (py_G_norm2 == NULL) ? NULL : &ws);
+
+  Py_RETURN_NONE;
+}
+
+static PyObject *
+py_set_dipole_dipole_workspace(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_G_phases;
+  PyArrayObject* py_eps_G;
+  PyArrayObject* py_G_eps_G;
+  PyArrayObject* py_G_norm2;
+  PyArrayObject* py_G_list;
+  PyArrayObject* py_dielectric;
+  PyArrayObject* py_positions;
+
+  double (*G_list)[3];
+  double (*dielectric)[3];
+  double (*pos)[3];
+  int num_patom, num_G;
+  DipoleDipoleWorkspace ws;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOO",
+                        &py_G_phases,
+                        &py_eps_G,
+                        &py_G_eps_G,
+                        &py_G_norm2,
+                        &py_G_list,
+                        &py_dielectric,
+                        &py_positions))
+    return NULL;
+
+  ws.dd_tmp = NULL;
+  ws.G_phases = (double(*)[2])PyArray_DATA(py_G_phases);
+  ws.eps_G = (double(*)[3])PyArray_DATA(py_eps_G);
+  ws.G_eps_G = (double*)PyArray_DATA(py_G_eps_G);
+  ws.G_norm2 = (double*)PyArray_DATA(py_G_norm2);
+  G_list = (double(*)[3])PyArray_DATA(py_G_list);
+  dielectric = (double(*)[3])PyArray_DATA(py_dielectric);
+  pos = (double(*)[3])PyArray_DATA(py_positions);
+  num_G = PyArray_DIMS(py_G_list)[0];
+  num_patom = PyArray_DIMS(py_positions)[0];
+
+  dym_set_dipole_dipole_workspace(&ws,
+                                  G_list, /* [num_kvec, 3] */
+                                  num_G,
+                                  num_patom,
+                                  dielectric,
+                                  pos); /* [natom, 3] */
+
+  Py_RETURN_NONE;
+}
+
+static PyObject * py_get_dipole_dipole_q0(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_dd_q0;
+  PyArrayObject* py_G_list;
+  PyArrayObject* py_born;
+  PyArrayObject* py_dielectric;
+  PyArrayObject* py_positions;
+  double lambda;
+  double tolerance;
+
+  double* dd_q0;
+  double (*G_list)[3];
+  double (*born)[3][3];
+  double (*dielectric)[3];
+  double (*pos)[3];
+  int num_patom, num_G;
+
+  if (!PyArg_ParseTuple(args, "OOOOOdd",
+                        &py_dd_q0,
+                        &py_G_list,
+                        &py_born,
+                        &py_dielectric,
+                        &py_positions,
+                        &lambda,
+                        &tolerance))
+    return NULL;
+
+
+  dd_q0 = (double*)PyArray_DATA(py_dd_q0);
+  G_list = (double(*)[3])PyArray_DATA(py_G_list);
+  born = (double(*)[3][3])PyArray_DATA(py_born);
+  dielectric = (double(*)[3])PyArray_DATA(py_dielectric);
+  pos = (double(*)[3])PyArray_DATA(py_positions);
+  num_G = PyArray_DIMS(py_G_list)[0];
+  num_patom = PyArray_DIMS(py_positions)[0];
+
+  dym_get_dipole_dipole_q0(dd_q0, /* [natom, 3, 3, (real, imag)] */
+                           G_list, /* [num_kvec, 3] */
+                           num_G,
+                           num_patom,
+                           born,
+                           dielectric,
+                           pos, /* [natom, 3] */
+                           lambda, /* 4 * Lambda^2 */
+                           tolerance);
+
+  Py_RETURN_NONE;
+}
+
+static PyObject * py_get_derivative_dynmat(PyObject *self, PyObject *args)
+{
+  PyArrayObject* derivative_dynmat;
+  PyArrayObject* py_force_constants;
+  PyArrayObject* r_vector;
+  PyArrayObject* lattice;
+  PyArrayObject* q_vector;
+  PyArrayObject* py_multiplicities;
+  PyArrayObject* py_masses;
+  PyArrayObject* py_s2p_map;
+  PyArrayObject* py_p2s_map;
+  PyArrayObject* py_born;
+  PyArrayObject* dielectric;
+  PyArrayObject* q_direction;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
+  double nac_factor;
+
+  double* ddm;
+  double* fc;
+  double* q;
+  double* lat;
+  double* r;
+  double* m;
+  int* multi;
+  int* s2p_map;
+  int* p2s_map;
+  int num_patom;
+  int num_satom;
+
+  double *z;
+  double *epsilon;
+  double *q_dir;
+  int *pair_ptr;
+  int *pair_atoms;
+
+  py_pair_ptr = NULL;
+  py_pair_atoms = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOdOOO|OO",
+                        &derivative_dynmat,
+                        &py_force_constants,
+                        &q_vector,
+                        &lattice, /* column vectors */
+                        &r_vector,
+                        &py_multiplicities,
+                        &py_masses,
+                        &py_s2p_map,
+                        &py_p2s_map,
+                        &nac_factor,
                         &py_born,
                         &dielectric,
-                        &q_direction)) {
+                        &q_direction,
+                        &py_pair_ptr,
+                        &py_pair_atoms)) {
     return NULL;
   }
 
@@ -852,6 +1500,13 @@ static PyObject * py_get_derivative_dynmat(PyObject *self, PyObject *args)
   } else {
     q_dir = (double*)PyArray_DATA(q_direction);
   }
+  if (py_pair_ptr == NULL || (PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
 
   get_derivative_dynmat_at_q(ddm,
                              num_patom,
@@ -867,7 +1522,119 @@ static PyObject * py_get_derivative_dynmat(PyObject *self, PyObject *args)
                              nac_factor,
                              z,
                              epsilon,
-                             q_dir);
+                             q_dir,
+                             pair_ptr,
+                             pair_atoms);
+
+  Py_RETURN_NONE;
+}
+
+static PyObject * py_get_derivative_dynmats(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_derivative_dynmats;
+  PyArrayObject* py_force_constants;
+  PyArrayObject* py_qpoints;
+  PyArrayObject* py_lattice;
+  PyArrayObject* py_shortest_vectors;
+  PyArrayObject* py_multiplicities;
+  PyArrayObject* py_masses;
+  PyArrayObject* py_s2p_map;
+  PyArrayObject* py_p2s_map;
+  PyArrayObject* py_born;
+  PyArrayObject* py_dielectric;
+  PyArrayObject* py_q_direction;
+  PyArrayObject* py_pair_ptr;
+  PyArrayObject* py_pair_atoms;
+  double nac_factor;
+
+  double* ddms;
+  double* fc;
+  double* qpoints;
+  double* lat;
+  double* r;
+  int* multi;
+  double* m;
+  int* s2p_map;
+  int* p2s_map;
+  double* z;
+  double* epsilon;
+  double* q_dir;
+  int* pair_ptr;
+  int* pair_atoms;
+  int num_qpoints;
+  int num_patom;
+  int num_satom;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOdOOOOO",
+                        &py_derivative_dynmats,
+                        &py_force_constants,
+                        &py_qpoints,
+                        &py_lattice, /* column vectors */
+                        &py_shortest_vectors,
+                        &py_multiplicities,
+                        &py_masses,
+                        &py_s2p_map,
+                        &py_p2s_map,
+                        &nac_factor,
+                        &py_born,
+                        &py_dielectric,
+                        &py_q_direction,
+                        &py_pair_ptr,
+                        &py_pair_atoms)) {
+    return NULL;
+  }
+
+  ddms = (double*)PyArray_DATA(py_derivative_dynmats);
+  fc = (double*)PyArray_DATA(py_force_constants);
+  qpoints = (double*)PyArray_DATA(py_qpoints);
+  num_qpoints = PyArray_DIMS(py_qpoints)[0];
+  lat = (double*)PyArray_DATA(py_lattice);
+  r = (double*)PyArray_DATA(py_shortest_vectors);
+  multi = (int*)PyArray_DATA(py_multiplicities);
+  m = (double*)PyArray_DATA(py_masses);
+  s2p_map = (int*)PyArray_DATA(py_s2p_map);
+  p2s_map = (int*)PyArray_DATA(py_p2s_map);
+  num_patom = PyArray_DIMS(py_p2s_map)[0];
+  num_satom = PyArray_DIMS(py_s2p_map)[0];
+
+  if ((PyObject*)py_born == Py_None) {
+    z = NULL;
+    epsilon = NULL;
+  } else {
+    z = (double*)PyArray_DATA(py_born);
+    epsilon = (double*)PyArray_DATA(py_dielectric);
+  }
+  if ((PyObject*)py_q_direction == Py_None) {
+    q_dir = NULL;
+  } else {
+    q_dir = (double*)PyArray_DATA(py_q_direction);
+  }
+  if ((PyObject*)py_pair_ptr == Py_None) {
+    pair_ptr = NULL;
+    pair_atoms = NULL;
+  } else {
+    pair_ptr = (int*)PyArray_DATA(py_pair_ptr);
+    pair_atoms = (int*)PyArray_DATA(py_pair_atoms);
+  }
+
+  get_derivative_dynmats_at_qpoints(ddms,
+                                    num_qpoints,
+                                    qpoints,
+                                    num_patom,
+                                    num_satom,
+                                    fc,
+                                    lat,
+                                    r,
+                                    multi,
+                                    m,
+                                    s2p_map,
+                                    p2s_map,
+                                    nac_factor,
+                                    z,
+                                    epsilon,
+                                    q_dir,
+                                    pair_ptr,
+                                    pair_atoms);
 
   Py_RETURN_NONE;
 }
@@ -888,9 +1655,8 @@ static PyObject * py_get_thermal_properties(PyObject *self, PyObject *args)
   int num_bands;
   int num_temp;
 
-  int i, j, k;
+  int i, j, num_threads, thread_id;
   long sum_weights;
-  double omega;
   double *tp;
 
   if (!PyArg_ParseTuple(args, "OOOO",
@@ -909,39 +1675,47 @@ static PyObject * py_get_thermal_properties(PyObject *self, PyObject *args)
   w = (int*)PyArray_DATA(py_weights);
   num_bands = PyArray_DIMS(py_frequencies)[1];
 
-  for (i = 0; i < num_temp * 3; i++) {
-    thermal_props[i] = 0;
-  }
+#ifdef _OPENMP
+  num_threads = omp_get_max_threads();
+#else
+  num_threads = 1;
+#endif
 
-  tp = (double*)malloc(sizeof(double) * num_qpoints * num_temp * 3);
-  for (i = 0; i < num_qpoints * num_temp * 3; i++) {
+  /* Each thread accumulates over its q-points into its own [num_temp, 3] */
+  /* and they are summed in thread order to make results reproducible. */
+  tp = (double*)malloc(sizeof(double) * num_threads * num_temp * 3);
+  for (i = 0; i < num_threads * num_temp * 3; i++) {
     tp[i] = 0;
   }
 
-#pragma omp parallel for private(j, k, omega)
-  for (i = 0; i < num_qpoints; i++){
-    for (j = 0; j < num_temp; j++) {
-      for (k = 0; k < num_bands; k++){
-        omega = freqs[i * num_bands + k];
-        if (temperatures[j] > 0 && omega > 0.0) {
-          tp[i * num_temp * 3 + j * 3] +=
-            get_free_energy_omega(temperatures[j], omega) * w[i];
-          tp[i * num_temp * 3 + j * 3 + 1] +=
-            get_entropy_omega(temperatures[j], omega) * w[i];
-          tp[i * num_temp * 3 + j * 3 + 2] +=
-            get_heat_capacity_omega(temperatures[j], omega)* w[i];
-        }
-      }
+#pragma omp parallel private(thread_id) num_threads(num_threads)
+  {
+#ifdef _OPENMP
+    thread_id = omp_get_thread_num();
+#else
+    thread_id = 0;
+#endif
+
+#pragma omp for schedule(static)
+    for (i = 0; i < num_qpoints; i++) {
+      add_thermal_properties_at_q(tp + thread_id * num_temp * 3,
+                                  temperatures,
+                                  num_temp,
+                                  freqs + (long)i * num_bands,
+                                  num_bands,
+                                  w[i]);
     }
   }
 
   for (i = 0; i < num_temp * 3; i++) {
-    for (j = 0; j < num_qpoints; j++) {
+    thermal_props[i] = 0;
+    for (j = 0; j < num_threads; j++) {
       thermal_props[i] += tp[j * num_temp * 3 + i];
     }
   }
 
   free(tp);
+  tp = NULL;
 
   sum_weights = 0;
 #pragma omp parallel for reduction(+:sum_weights)
@@ -957,6 +1731,66 @@ static PyObject * py_get_thermal_properties(PyObject *self, PyObject *args)
   Py_RETURN_NONE;
 }
 
+static PyObject *
+py_symmetrize_group_velocities(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_group_velocities;
+  PyArrayObject* py_qpoints;
+  PyArrayObject* py_rotations;
+  PyArrayObject* py_rotations_cart;
+  double symprec;
+
+  double (*gv)[3];
+  double (*qpoints)[3];
+  int (*rotations)[3][3];
+  double (*r_carts)[3][3];
+  int num_qpoints, num_band, num_rot;
+
+  int i;
+
+  if (!PyArg_ParseTuple(args, "OOOOd",
+                        &py_group_velocities,
+                        &py_qpoints,
+                        &py_rotations,
+                        &py_rotations_cart,
+                        &symprec)) {
+    return NULL;
+  }
+
+  gv = (double(*)[3])PyArray_DATA(py_group_velocities);
+  num_band = PyArray_DIMS(py_group_velocities)[1];
+  qpoints = (double(*)[3])PyArray_DATA(py_qpoints);
+  num_qpoints = PyArray_DIMS(py_qpoints)[0];
+  rotations = (int(*)[3][3])PyArray_DATA(py_rotations);
+  num_rot = PyArray_DIMS(py_rotations)[0];
+  r_carts = (double(*)[3][3])PyArray_DATA(py_rotations_cart);
+
+  if (PyArray_DIMS(py_group_velocities)[0] != num_qpoints) {
+    PyErr_SetString(PyExc_ValueError,
+                    "group velocities and q-points are different length");
+    return NULL;
+  }
+
+  if (PyArray_DIMS(py_rotations_cart)[0] != num_rot) {
+    PyErr_SetString(PyExc_ValueError,
+                    "rotations and Cartesian rotations are different length");
+    return NULL;
+  }
+
+#pragma omp parallel for
+  for (i = 0; i < num_qpoints; i++) {
+    symmetrize_group_velocity_at_q(gv + (long)i * num_band,
+                                   num_band,
+                                   qpoints[i],
+                                   rotations,
+                                   r_carts,
+                                   num_rot,
+                                   symprec);
+  }
+
+  Py_RETURN_NONE;
+}
+
 static PyObject *
 py_distribute_fc2_with_mappings(PyObject *self, PyObject *args)
 {
@@ -966,22 +1800,31 @@ py_distribute_fc2_with_mappings(PyObject *self, PyObject *args)
   PyArrayObject* py_map_syms;
   PyArrayObject* py_atom_list;
   PyArrayObject* py_rotations_cart;
+  PyArrayObject* py_compact_force_constants;
+  PyArrayObject* py_done_rows;
 
   double (*r_carts)[3][3];
   double (*fc2)[3][3];
+  double (*fc2_compact)[3][3];
+  int *done_rows;
   int *permutations;
   int *map_atoms;
   int *map_syms;
   int *atom_list;
   int num_pos, num_rot, len_atom_list;
 
-  if (!PyArg_ParseTuple(args, "OOOOOO",
+  py_compact_force_constants = NULL;
+  py_done_rows = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOOOOO|OO",
                         &py_force_constants,
                         &py_atom_list,
                         &py_rotations_cart,
                         &py_permutations,
                         &py_map_atoms,
-                        &py_map_syms)) {
+                        &py_map_syms,
+                        &py_compact_force_constants,
+                        &py_done_rows)) {
     return NULL;
   }
 
@@ -1013,7 +1856,42 @@ py_distribute_fc2_with_mappings(PyObject *self, PyObject *args)
     return NULL;
   }
 
+  if (py_compact_force_constants == NULL ||
+      (PyObject*)py_compact_force_constants == Py_None) {
+    fc2_compact = NULL;
+  } else {
+    if (PyArray_DIMS(py_compact_force_constants)[0] != len_atom_list ||
+        PyArray_DIMS(py_compact_force_constants)[1] != num_pos) {
+      PyErr_SetString(PyExc_ValueError,
+                      "wrong shape for compact force constants");
+      return NULL;
+    }
+    fc2_compact = (double(*)[3][3])PyArray_DATA(py_compact_force_constants);
+  }
+
+  if (py_done_rows == NULL || (PyObject*)py_done_rows == Py_None) {
+    done_rows = NULL;
+  } else {
+    if (fc2_compact == NULL) {
+      PyErr_SetString(PyExc_ValueError,
+                      "done_rows requires compact force constants");
+      return NULL;
+    }
+    if (PyArray_NDIM(py_done_rows) != 1 ||
+        PyArray_DIMS(py_done_rows)[0] != num_pos) {
+      PyErr_SetString(PyExc_ValueError, "wrong shape for done_rows");
+      return NULL;
+    }
+    if (PyArray_DIMS(py_force_constants)[1] != num_pos) {
+      PyErr_SetString(PyExc_ValueError, "wrong shape for force constants");
+      return NULL;
+    }
+    done_rows = (int*)PyArray_DATA(py_done_rows);
+  }
+
   distribute_fc2_with_mappings(fc2,
+                               fc2_compact,
+                               done_rows,
                                atom_list,
                                len_atom_list,
                                r_carts,
@@ -1145,29 +2023,79 @@ py_thm_integration_weight_at_omegas(PyObject *self, PyObject *args)
   PyArrayObject* py_tetrahedra_omegas;
   char* function;
 
-  double *omegas;
-  double *iw;
-  int num_omegas;
-  double (*tetrahedra_omegas)[4];
+  double *omegas;
+  double *iw;
+  int num_omegas;
+  double (*tetrahedra_omegas)[4];
+
+  if (!PyArg_ParseTuple(args, "OOOs",
+                        &py_integration_weights,
+                        &py_omegas,
+                        &py_tetrahedra_omegas,
+                        &function)) {
+    return NULL;
+  }
+
+  omegas = (double*)PyArray_DATA(py_omegas);
+  iw = (double*)PyArray_DATA(py_integration_weights);
+  num_omegas = (int)PyArray_DIMS(py_omegas)[0];
+  tetrahedra_omegas = (double(*)[4])PyArray_DATA(py_tetrahedra_omegas);
+
+  thm_get_integration_weight_at_omegas(iw,
+                                       num_omegas,
+                                       omegas,
+                                       tetrahedra_omegas,
+                                       function[0]);
+
+  Py_RETURN_NONE;
+}
+
+static PyObject * py_get_tetrahedra_vertices(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_vertices;
+  PyArrayObject* py_grid_points;
+  PyArrayObject* py_mesh;
+  PyArrayObject* py_grid_address;
+  PyArrayObject* py_gp_ir_index;
+  PyArrayObject* py_relative_grid_address;
+
+  int (*vertices)[24][4];
+  int* grid_points;
+  int num_gp_in;
+  int* mesh;
+  int (*grid_address)[3];
+  int* gp_ir_index;
+  int (*relative_grid_address)[4][3];
+
+  int i;
 
-  if (!PyArg_ParseTuple(args, "OOOs",
-                        &py_integration_weights,
-                        &py_omegas,
-                        &py_tetrahedra_omegas,
-                        &function)) {
+  if (!PyArg_ParseTuple(args, "OOOOOO",
+                        &py_vertices,
+                        &py_grid_points,
+                        &py_mesh,
+                        &py_grid_address,
+                        &py_gp_ir_index,
+                        &py_relative_grid_address)) {
     return NULL;
   }
 
-  omegas = (double*)PyArray_DATA(py_omegas);
-  iw = (double*)PyArray_DATA(py_integration_weights);
-  num_omegas = (int)PyArray_DIMS(py_omegas)[0];
-  tetrahedra_omegas = (double(*)[4])PyArray_DATA(py_tetrahedra_omegas);
+  vertices = (int(*)[24][4])PyArray_DATA(py_vertices);
+  grid_points = (int*)PyArray_DATA(py_grid_points);
+  num_gp_in = (int)PyArray_DIMS(py_grid_points)[0];
+  mesh = (int*)PyArray_DATA(py_mesh);
+  grid_address = (int(*)[3])PyArray_DATA(py_grid_address);
+  gp_ir_index = (int*)PyArray_DATA(py_gp_ir_index);
+  relative_grid_address = (int(*)[4][3])PyArray_DATA(py_relative_grid_address);
 
-  thm_get_integration_weight_at_omegas(iw,
-                                       num_omegas,
-                                       omegas,
-                                       tetrahedra_omegas,
-                                       function[0]);
+#pragma omp parallel for
+  for (i = 0; i < num_gp_in; i++) {
+    get_tetrahedra_vertices(vertices[i],
+                            grid_points[i],
+                            mesh,
+                            grid_address,
+                            gp_ir_index,
+                            relative_grid_address);
+  }
 
   Py_RETURN_NONE;
 }
@@ -1188,14 +2116,12 @@ static PyObject * py_get_tetrahedra_frequenies(PyObject *self, PyObject *args)
   int* mesh;
   int (*grid_address)[3];
   int* gp_ir_index;
-  int (*relative_grid_address)[3];
+  int (*relative_grid_address)[4][3];
   double* frequencies;
   int num_band;
 
-  int is_shift[3] = {0, 0, 0};
-  int i, j, k, gp;
-  int g_addr[3];
-  int address_double[3];
+  int i, j, k, l;
+  int vertices[24][4];
 
   if (!PyArg_ParseTuple(args, "OOOOOOO",
                         &py_freq_tetras,
@@ -1214,24 +2140,26 @@ static PyObject * py_get_tetrahedra_frequenies(PyObject *self, PyObject *args)
   mesh = (int*)PyArray_DATA(py_mesh);
   grid_address = (int(*)[3])PyArray_DATA(py_grid_address);
   gp_ir_index = (int*)PyArray_DATA(py_gp_ir_index);
-  relative_grid_address = (int(*)[3])PyArray_DATA(py_relative_grid_address);
+  relative_grid_address = (int(*)[4][3])PyArray_DATA(py_relative_grid_address);
   frequencies = (double*)PyArray_DATA(py_frequencies);
   num_band = (int)PyArray_DIMS(py_frequencies)[1];
 
+  /* Vertices are shared by all bands. */
+#pragma omp parallel for private(j, k, l, vertices)
   for (i = 0; i < num_gp_in;  i++) {
-#pragma omp parallel for private(k, g_addr, gp, address_double)
-    for (j = 0; j < num_band * 96; j++) {
-      for (k = 0; k < 3; k++) {
-        g_addr[k] = grid_address[grid_points[i]][k] +
-          relative_grid_address[j % 96][k];
+    get_tetrahedra_vertices(vertices,
+                            grid_points[i],
+                            mesh,
+                            grid_address,
+                            gp_ir_index,
+                            relative_grid_address);
+    for (j = 0; j < num_band; j++) {
+      for (k = 0; k < 24; k++) {
+        for (l = 0; l < 4; l++) {
+          freq_tetras[i * num_band * 96 + j * 96 + k * 4 + l] =
+            frequencies[vertices[k][l] * num_band + j];
+        }
       }
-      kgd_get_grid_address_double_mesh(address_double,
-                                       g_addr,
-                                       mesh,
-                                       is_shift);
-      gp = kgd_get_grid_point_double_mesh(address_double, mesh);
-      freq_tetras[i * num_band * 96 + j] =
-        frequencies[gp_ir_index[gp] * num_band + j / 96];
     }
   }
 
@@ -1263,18 +2191,14 @@ static PyObject * py_tetrahedron_method_dos(PyObject *self, PyObject *args)
   int* grid_mapping_table;
   int (*relative_grid_address)[4][3];
 
-  int is_shift[3] = {0, 0, 0};
-  int i, j, k, l, m, q, r, count;
-  int g_addr[3];
-  int ir_gps[24][4];
-  double tetrahedra[24][4];
-  int address_double[3];
+  int i, count;
   int *gp2ir, *ir_grid_points, *weights;
-  double iw;
+  int (*vertices)[24][4];
 
   gp2ir = NULL;
   ir_grid_points = NULL;
   weights = NULL;
+  vertices = NULL;
 
   if (!PyArg_ParseTuple(args, "OOOOOOOO",
                         &py_dos,
@@ -1303,6 +2227,19 @@ static PyObject * py_tetrahedron_method_dos(PyObject *self, PyObject *args)
   grid_mapping_table = (int*)PyArray_DATA(py_grid_mapping_table);
   relative_grid_address = (int(*)[4][3])PyArray_DATA(py_relative_grid_address);
 
+  count = 0;
+  for (i = 0; i < num_gp; i++) {
+    if (grid_mapping_table[i] == i) {
+      count++;
+    }
+  }
+
+  if (num_ir_gp != count) {
+    PyErr_SetString(PyExc_ValueError,
+                    "frequencies and ir-grid-points are different length");
+    return NULL;
+  }
+
   gp2ir = (int*)malloc(sizeof(int) * num_gp);
   ir_grid_points = (int*)malloc(sizeof(int) * num_ir_gp);
   weights = (int*)malloc(sizeof(int) * num_ir_gp);
@@ -1320,85 +2257,286 @@ static PyObject * py_tetrahedron_method_dos(PyObject *self, PyObject *args)
     }
   }
 
-  if (num_ir_gp != count) {
-    printf("Something is wrong!\n");
-  }
+  vertices = (int(*)[24][4])malloc(sizeof(int[24][4]) * num_ir_gp);
 
-#pragma omp parallel for private(j, k, l, m, q, r, iw, ir_gps, g_addr, tetrahedra, address_double)
+#pragma omp parallel for
   for (i = 0; i < num_ir_gp; i++) {
-    /* set 24 tetrahedra */
-    for (l = 0; l < 24; l++) {
-      for (q = 0; q < 4; q++) {
-        for (r = 0; r < 3; r++) {
-          g_addr[r] = grid_address[ir_grid_points[i]][r] +
-            relative_grid_address[l][q][r];
-        }
-        kgd_get_grid_address_double_mesh(address_double,
-                                         g_addr,
-                                         mesh,
-                                         is_shift);
-        ir_gps[l][q] = gp2ir[kgd_get_grid_point_double_mesh(address_double, mesh)];
-      }
-    }
-
-    for (k = 0; k < num_band; k++) {
-      for (l = 0; l < 24; l++) {
-        for (q = 0; q < 4; q++) {
-          tetrahedra[l][q] = frequencies[ir_gps[l][q] * num_band + k];
-        }
-      }
-      for (j = 0; j < num_freq_points; j++) {
-        iw = thm_get_integration_weight(freq_points[j], tetrahedra, 'I') * weights[i];
-        for (m = 0; m < num_coef; m++) {
-          dos[i * num_band * num_freq_points * num_coef +
-              k * num_coef * num_freq_points + j * num_coef + m] +=
-            iw * coef[i * num_coef * num_band + m * num_band + k];
-        }
-      }
-    }
+    get_tetrahedra_vertices(vertices[i],
+                            ir_grid_points[i],
+                            mesh,
+                            grid_address,
+                            gp2ir,
+                            relative_grid_address);
   }
 
+  tetrahedron_method_dos(dos,
+                         freq_points,
+                         num_freq_points,
+                         frequencies,
+                         num_ir_gp,
+                         num_band,
+                         coef,
+                         num_coef,
+                         weights,
+                         vertices);
+
   free(gp2ir);
   gp2ir = NULL;
   free(ir_grid_points);
   ir_grid_points = NULL;
   free(weights);
   weights = NULL;
+  free(vertices);
+  vertices = NULL;
+
+  Py_RETURN_NONE;
+}
+
+static PyObject *
+py_tetrahedron_method_dos_with_vertices(PyObject *self, PyObject *args)
+{
+  PyArrayObject* py_dos;
+  PyArrayObject* py_freq_points;
+  PyArrayObject* py_frequencies;
+  PyArrayObject* py_coef;
+  PyArrayObject* py_weights;
+  PyArrayObject* py_vertices;
+
+  double *dos;
+  double* freq_points;
+  int num_freq_points;
+  double* frequencies;
+  double* coef;
+  int num_ir_gp;
+  int num_coef;
+  int num_band;
+  int *weights;
+  int (*vertices)[24][4];
+
+  if (!PyArg_ParseTuple(args, "OOOOOO",
+                        &py_dos,
+                        &py_freq_points,
+                        &py_frequencies,
+                        &py_coef,
+                        &py_weights,
+                        &py_vertices)) {
+    return NULL;
+  }
+
+  /* dos[num_ir_gp][num_band][num_freq_points][num_coef] */
+  dos = (double*)PyArray_DATA(py_dos);
+  freq_points = (double*)PyArray_DATA(py_freq_points);
+  num_freq_points = (int)PyArray_DIMS(py_freq_points)[0];
+  frequencies = (double*)PyArray_DATA(py_frequencies);
+  num_ir_gp = (int)PyArray_DIMS(py_frequencies)[0];
+  num_band = (int)PyArray_DIMS(py_frequencies)[1];
+  coef = (double*)PyArray_DATA(py_coef);
+  num_coef = (int)PyArray_DIMS(py_coef)[1];
+  weights = (int*)PyArray_DATA(py_weights);
+  /* vertices[num_ir_gp][24][4]: indices of ir-grid-points */
+  vertices = (int(*)[24][4])PyArray_DATA(py_vertices);
+
+  if (PyArray_DIMS(py_weights)[0] != num_ir_gp ||
+      PyArray_DIMS(py_vertices)[0] != num_ir_gp) {
+    PyErr_SetString(PyExc_ValueError,
+                    "frequencies, weights and vertices are different length");
+    return NULL;
+  }
+
+  tetrahedron_method_dos(dos,
+                         freq_points,
+                         num_freq_points,
+                         frequencies,
+                         num_ir_gp,
+                         num_band,
+                         coef,
+                         num_coef,
+                         weights,
+                         vertices);
 
   Py_RETURN_NONE;
 }
 
-static double get_free_energy_omega(const double temperature,
-                                    const double omega)
+static void tetrahedron_method_dos(double *dos,
+                                   const double *freq_points,
+                                   const int num_freq_points,
+                                   const double *frequencies,
+                                   const int num_ir_gp,
+                                   const int num_band,
+                                   const double *coef,
+                                   const int num_coef,
+                                   const int *weights,
+                                   PHPYCONST int (*vertices)[24][4])
+{
+  int i, j, k, l, m, q;
+  double tetrahedra[24][4];
+  double *iw;
+
+#pragma omp parallel private(j, k, l, m, q, iw, tetrahedra)
+  {
+    iw = (double*)malloc(sizeof(double) * num_freq_points);
+#pragma omp for
+    for (i = 0; i < num_ir_gp; i++) {
+      for (k = 0; k < num_band; k++) {
+        for (l = 0; l < 24; l++) {
+          for (q = 0; q < 4; q++) {
+            tetrahedra[l][q] = frequencies[vertices[i][l][q] * num_band + k];
+          }
+        }
+        thm_get_integration_weight_sweep(iw,
+                                         num_freq_points,
+                                         freq_points,
+                                         tetrahedra,
+                                         'I');
+        for (j = 0; j < num_freq_points; j++) {
+          if (iw[j] == 0) {
+            continue;
+          }
+          for (m = 0; m < num_coef; m++) {
+            dos[i * num_band * num_freq_points * num_coef +
+                k * num_coef * num_freq_points + j * num_coef + m] +=
+              iw[j] * weights[i] * coef[i * num_coef * num_band + m * num_band + k];
+          }
+        }
+      }
+    }
+    free(iw);
+    iw = NULL;
+  }
+}
+
+/* Indices of ir-grid-points at vertices of 24 tetrahedra around */
+/* grid point gp. */
+static void get_tetrahedra_vertices(int vertices[24][4],
+                                    const int gp,
+                                    const int mesh[3],
+                                    PHPYCONST int (*grid_address)[3],
+                                    const int *gp_ir_index,
+                                    PHPYCONST int (*relative_grid_address)[4][3])
 {
-  /* temperature is defined by T (K) */
-  /* omega must be normalized to eV. */
-  return KB * temperature * log(1 - exp(- omega / (KB * temperature)));
+  int is_shift[3] = {0, 0, 0};
+  int i, j, k;
+  int g_addr[3];
+  int address_double[3];
+
+  for (i = 0; i < 24; i++) {
+    for (j = 0; j < 4; j++) {
+      for (k = 0; k < 3; k++) {
+        g_addr[k] = grid_address[gp][k] + relative_grid_address[i][j][k];
+      }
+      kgd_get_grid_address_double_mesh(address_double,
+                                       g_addr,
+                                       mesh,
+                                       is_shift);
+      vertices[i][j] =
+        gp_ir_index[kgd_get_grid_point_double_mesh(address_double, mesh)];
+    }
+  }
 }
 
-static double get_entropy_omega(const double temperature,
-                                const double omega)
+/* Free energy, entropy, and heat capacity of modes at a q-point are */
+/* added to tp[num_temp, 3]. With x = omega / kT and e = exp(-x), */
+/*   F  = kT log(1 - e) */
+/*   S  = k (x e / (1 - e) - log(1 - e)) */
+/*   Cv = k x^2 e / (1 - e)^2 */
+/* where temperature is defined by T (K) and omega must be normalized */
+/* to eV. Only positive omega and temperature are counted. */
+static void add_thermal_properties_at_q(double *tp,
+                                        const double *temperatures,
+                                        const int num_temp,
+                                        const double *freqs,
+                                        const int num_bands,
+                                        const int weight)
 {
-  /* temperature is defined by T (K) */
-  /* omega must be normalized to eV. */
-  double val;
+  int j, k;
+  double kT, x, e, one_e, log_one_e, f_sum, s_sum, cv_sum;
 
-  val = omega / (2 * KB * temperature);
-  return 1 / (2 * temperature) * omega * cosh(val) / sinh(val) - KB * log(2 * sinh(val));
+  for (j = 0; j < num_temp; j++) {
+    if (!(temperatures[j] > 0)) {
+      continue;
+    }
+    kT = KB * temperatures[j];
+    f_sum = 0;
+    s_sum = 0;
+    cv_sum = 0;
+    for (k = 0; k < num_bands; k++) {
+      if (freqs[k] > 0.0) {
+        x = freqs[k] / kT;
+        e = exp(-x);
+        one_e = 1 - e;
+        log_one_e = log1p(-e);
+        f_sum += log_one_e;
+        s_sum += x * e / one_e - log_one_e;
+        cv_sum += x * x * e / (one_e * one_e);
+      }
+    }
+    tp[j * 3] += kT * f_sum * weight;
+    tp[j * 3 + 1] += KB * s_sum * weight;
+    tp[j * 3 + 2] += KB * cv_sum * weight;
+  }
 }
 
-static double get_heat_capacity_omega(const double temperature,
-                                      const double omega)
+/* Group velocities are averaged over the little group of q, i.e., */
+/* rotations R of reciprocal space with R q = q (not modulo G) after */
+/* q is brought close to Gamma by subtracting the nearest lattice point */
+/* with rint, i.e., in the same way as numpy.rint. */
+/* The average of the Cartesian rotations is accumulated first and */
+/* then applied once to the velocity of each band. */
+static void symmetrize_group_velocity_at_q(double (*gv)[3],
+                                           const int num_band,
+                                           const double q[3],
+                                           PHPYCONST int (*rotations)[3][3],
+                                           PHPYCONST double (*r_carts)[3][3],
+                                           const int num_rot,
+                                           const double symprec)
 {
-  /* temperature is defined by T (K) */
-  /* omega must be normalized to eV. */
-  /* If val is close to 1. Then expansion is used. */
-  double val, val1, val2;
-
-  val = omega / (KB * temperature);
-  val1 = exp(val);
-  val2 = (val) / (val1 - 1);
-  return KB * val1 * val2 * val2;
+  int i, j, k, num_little;
+  double q_in_BZ[3], rot_q, r_sum[3][3], v[3];
+
+  for (i = 0; i < 3; i++) {
+    q_in_BZ[i] = q[i] - rint(q[i]);
+    for (j = 0; j < 3; j++) {
+      r_sum[i][j] = 0;
+    }
+  }
+
+  num_little = 0;
+  for (i = 0; i < num_rot; i++) {
+    for (j = 0; j < 3; j++) {
+      rot_q = 0;
+      for (k = 0; k < 3; k++) {
+        rot_q += rotations[i][j][k] * q_in_BZ[k];
+      }
+      if (!(fabs(q_in_BZ[j] - rot_q) < symprec)) {
+        break;
+      }
+    }
+    if (j < 3) {
+      continue;
+    }
+    for (j = 0; j < 3; j++) {
+      for (k = 0; k < 3; k++) {
+        r_sum[j][k] += r_carts[i][j][k];
+      }
+    }
+    num_little++;
+  }
+
+  if (num_little == 0) {
+    return;
+  }
+
+  for (i = 0; i < num_band; i++) {
+    for (j = 0; j < 3; j++) {
+      v[j] = 0;
+      for (k = 0; k < 3; k++) {
+        v[j] += r_sum[j][k] * gv[i][k];
+      }
+    }
+    for (j = 0; j < 3; j++) {
+      gv[i][j] = v[j] / num_little;
+    }
+  }
 }
 
 /* static double get_energy_omega(double temperature, double omega){ */
@@ -1512,8 +2650,17 @@ static void gsv_copy_smallest_vectors(double (*shortest_vectors)[27][3],
 }
 
 /* Distributes all force constants using precomputed data about symmetry mappings. */
+/* Rows of atom_todo are written to disjoint parts of fc2 or fc2_compact */
+/* and only rows of atoms in the done list are read, so atom_list is */
+/* distributed over threads. */
+/* When fc2_compact is not NULL, fc2_compact[i] is set to the row of */
+/* atom_list[i] including those in the done list, and fc2 is only read. */
+/* When done_rows is also not NULL, fc2 holds only the rows of the done */
+/* list, and the row of atom_done is fc2[done_rows[atom_done]]. */
 static void
 distribute_fc2_with_mappings(double (*fc2)[3][3], /* shape[num_pos][num_pos] */
+                             double (*fc2_compact)[3][3], /* shape[len_atom_list][num_pos] */
+                             const int * done_rows, /* shape[num_pos] */
                              const int * atom_list,
                              const int len_atom_list,
                              PHPYCONST double (*r_carts)[3][3], /* shape[num_rot] */
@@ -1523,23 +2670,43 @@ distribute_fc2_with_mappings(double (*fc2)[3][3], /* shape[num_pos][num_pos] */
                              const int num_rot,
                              const int num_pos)
 {
-  int i, j, k, l, m;
+  int i, j, k;
   int atom_todo, atom_done, atom_other;
+  long row_done;
   int sym_index;
   double (*fc2_done)[3];
   double (*fc2_todo)[3];
   double (*r_cart)[3];
   const int * permutation;
 
+#pragma omp parallel for private(j, k, atom_todo, atom_done, atom_other, \
+                                 row_done, sym_index, fc2_done, fc2_todo, \
+                                 r_cart, permutation)
   for (i = 0; i < len_atom_list; i++) {
     /* look up how this atom maps into the done list. */
     atom_todo = atom_list[i];
     atom_done = map_atoms[atom_todo];
     sym_index = map_syms[atom_todo];
+    if (done_rows) {
+      row_done = done_rows[atom_done];
+    } else {
+      row_done = atom_done;
+    }
 
     /* skip the atoms in the done list, */
     /* which are easily identified because they map to themselves. */
     if (atom_todo == atom_done) {
+      if (fc2_compact) {
+        for (atom_other = 0; atom_other < num_pos; atom_other++) {
+          fc2_done = fc2[row_done * num_pos + atom_other];
+          fc2_todo = fc2_compact[(long)i * num_pos + atom_other];
+          for (j = 0; j < 3; j++) {
+            for (k = 0; k < 3; k++) {
+              fc2_todo[j][k] = fc2_done[j][k];
+            }
+          }
+        }
+      }
       continue;
     }
 
@@ -1549,35 +2716,108 @@ distribute_fc2_with_mappings(double (*fc2)[3][3], /* shape[num_pos][num_pos] */
 
     /* distribute terms from atom_done to atom_todo */
     for (atom_other = 0; atom_other < num_pos; atom_other++) {
-      fc2_done = fc2[atom_done * num_pos + permutation[atom_other]];
-      fc2_todo = fc2[atom_todo * num_pos + atom_other];
-      for (j = 0; j < 3; j++) {
-        for (k = 0; k < 3; k++) {
-          for (l = 0; l < 3; l++) {
-            for (m = 0; m < 3; m++) {
-              /* P' = R^-1 P R */
-              fc2_todo[j][k] += r_cart[l][j] * r_cart[m][k] * fc2_done[l][m];
-            }
+      fc2_done = fc2[row_done * num_pos + permutation[atom_other]];
+      if (fc2_compact) {
+        fc2_todo = fc2_compact[(long)i * num_pos + atom_other];
+        for (j = 0; j < 3; j++) {
+          for (k = 0; k < 3; k++) {
+            fc2_todo[j][k] = 0;
           }
         }
+      } else {
+        fc2_todo = fc2[(long)atom_todo * num_pos + atom_other];
       }
+      add_rotated_fc2_elem(fc2_todo, r_cart, fc2_done);
+    }
+  }
+}
+
+/* P' = R^-1 P R = R^T P R computed as R^T (P R). */
+static void add_rotated_fc2_elem(double fc2_todo[3][3],
+                                 PHPYCONST double r_cart[3][3],
+                                 PHPYCONST double fc2_done[3][3])
+{
+  int j, k;
+  double pr[3][3];
+
+  for (j = 0; j < 3; j++) {
+    for (k = 0; k < 3; k++) {
+      pr[j][k] = (fc2_done[j][0] * r_cart[0][k] +
+                  fc2_done[j][1] * r_cart[1][k] +
+                  fc2_done[j][2] * r_cart[2][k]);
+    }
+  }
+  for (j = 0; j < 3; j++) {
+    for (k = 0; k < 3; k++) {
+      fc2_todo[j][k] += (r_cart[0][j] * pr[0][k] +
+                         r_cart[1][j] * pr[1][k] +
+                         r_cart[2][j] * pr[2][k]);
     }
   }
 }
 
+/* fc[i, j] and fc[j, i]^T are averaged over pairs of tiles of */
+/* FC_TILE_SIZE x FC_TILE_SIZE atoms, (tile_i, tile_j) with */
+/* tile_i <= tile_j, so that each thread works on two small regions */
+/* of fc at a time. The tiles are distributed dynamically since those */
+/* on the diagonal contain half of the work. */
 static void set_index_permutation_symmetry_fc(double * fc,
                                               const int natom)
 {
-  int i, j, k, l, m, n;
+  int i, num_tile, num_pair;
+  int (*tile_pairs)[2];
+
+  num_tile = (natom + FC_TILE_SIZE - 1) / FC_TILE_SIZE;
+  num_pair = num_tile * (num_tile + 1) / 2;
+  tile_pairs = (int(*)[2])malloc(sizeof(int[2]) * num_pair);
+  num_pair = 0;
+  for (i = 0; i < num_tile * num_tile; i++) {
+    if (i / num_tile <= i % num_tile) {
+      tile_pairs[num_pair][0] = i / num_tile;
+      tile_pairs[num_pair][1] = i % num_tile;
+      num_pair++;
+    }
+  }
 
-#pragma omp parallel for private(j, k, l, m, n)
-  for (i = 0; i < natom; i++) {
+#pragma omp parallel for schedule(dynamic)
+  for (i = 0; i < num_pair; i++) {
+    set_index_permutation_symmetry_fc_tile(fc,
+                                           natom,
+                                           tile_pairs[i][0],
+                                           tile_pairs[i][1]);
+  }
+
+  free(tile_pairs);
+  tile_pairs = NULL;
+}
+
+static void set_index_permutation_symmetry_fc_tile(double * fc,
+                                                   const int natom,
+                                                   const int tile_i,
+                                                   const int tile_j)
+{
+  int i, j, k, l, i_end, j_end;
+  long m, n;
+
+  i_end = (tile_i + 1) * FC_TILE_SIZE;
+  if (i_end > natom) {
+    i_end = natom;
+  }
+  j_end = (tile_j + 1) * FC_TILE_SIZE;
+  if (j_end > natom) {
+    j_end = natom;
+  }
+
+  for (i = tile_i * FC_TILE_SIZE; i < i_end; i++) {
     /* non diagonal part */
-    for (j = i + 1; j < natom; j++) {
+    for (j = tile_j * FC_TILE_SIZE; j < j_end; j++) {
+      if (j <= i) {
+        continue;
+      }
       for (k = 0; k < 3; k++) {
         for (l = 0; l < 3; l++) {
-          m = i * natom * 9 + j * 9 + k * 3 + l;
-          n = j * natom * 9 + i * 9 + l * 3 + k;
+          m = (long)i * natom * 9 + j * 9 + k * 3 + l;
+          n = (long)j * natom * 9 + i * 9 + l * 3 + k;
           fc[m] += fc[n];
           fc[m] /= 2;
           fc[n] = fc[m];
@@ -1586,40 +2826,130 @@ static void set_index_permutation_symmetry_fc(double * fc,
     }
 
     /* diagnoal part */
-    for (k = 0; k < 2; k++) {
-      for (l = k + 1; l < 3; l++) {
-        m = i * natom * 9 + i * 9 + k * 3 + l;
-        n = i * natom * 9 + i * 9 + l * 3 + k;
-        fc[m] += fc[n];
-        fc[m] /= 2;
-        fc[n] = fc[m];
+    if (tile_i == tile_j) {
+      for (k = 0; k < 2; k++) {
+        for (l = k + 1; l < 3; l++) {
+          m = (long)i * natom * 9 + i * 9 + k * 3 + l;
+          n = (long)i * natom * 9 + i * 9 + l * 3 + k;
+          fc[m] += fc[n];
+          fc[m] /= 2;
+          fc[n] = fc[m];
+        }
       }
     }
   }
 }
 
+/* Each row of fc is read once with the nine sums accumulated together. */
 static void set_translational_symmetry_fc(double * fc,
                                           const int natom)
 {
-  int i, j, k, l, m;
+  int i, j, k, l;
+  long m;
   double sums[3][3];
 
+#pragma omp parallel for private(j, k, l, m, sums)
   for (i = 0; i < natom; i++) {
     for (k = 0; k < 3; k++) {
       for (l = 0; l < 3; l++) {
         sums[k][l] = 0;
-        m = i * natom * 9 + k * 3 + l;
-        for (j = 0; j < natom; j++) {
-          if (i != j) {
-            sums[k][l] += fc[m];
+      }
+    }
+    m = (long)i * natom * 9;
+    for (j = 0; j < natom; j++) {
+      if (i != j) {
+        for (k = 0; k < 3; k++) {
+          for (l = 0; l < 3; l++) {
+            sums[k][l] += fc[m + k * 3 + l];
+          }
+        }
+      }
+      m += 9;
+    }
+    for (k = 0; k < 3; k++) {
+      for (l = 0; l < 3; l++) {
+        fc[(long)i * natom * 9 + i * 9 + k * 3 + l] =
+          -(sums[k][l] + sums[l][k]) / 2;
+      }
+    }
+  }
+}
+
+/* fc[i_p, j] is paired with fc[s2pp[j], perms[nsym_list[j], p2s[i_p]]] */
+/* transposed, where the latter is the same element translated so that */
+/* its first atom is in the primitive cell. This pairing is an */
+/* involution, so the pairs are averaged in place by the member having */
+/* the smaller address. Elements paired with themselves, e.g., diagonal */
+/* ones, are symmetrized within the 3x3 block. */
+static void set_index_permutation_symmetry_compact_fc(double * fc,
+                                                      const int p2s[],
+                                                      const int s2pp[],
+                                                      const int nsym_list[],
+                                                      const int perms[],
+                                                      const int n_satom,
+                                                      const int n_patom)
+{
+  int i, j, k, l, i_p, j_p, i_trans;
+  long m, n, adrs, adrs_trans;
+
+#pragma omp parallel for private(i_p, j, k, l, j_p, i_trans, m, n, adrs, \
+                                 adrs_trans)
+  for (i = 0; i < n_patom * n_satom; i++) {
+    i_p = i / n_satom;
+    j = i % n_satom;
+    j_p = s2pp[j];
+    i_trans = perms[nsym_list[j] * n_satom + p2s[i_p]];
+    adrs = (long)i * 9;
+    adrs_trans = ((long)j_p * n_satom + i_trans) * 9;
+    if (adrs > adrs_trans) {
+      continue;
+    }
+    for (k = 0; k < 3; k++) {
+      for (l = 0; l < 3; l++) {
+        if (adrs == adrs_trans && k >= l) {
+          continue;
+        }
+        m = adrs + k * 3 + l;
+        n = adrs_trans + l * 3 + k;
+        fc[m] += fc[n];
+        fc[m] /= 2;
+        fc[n] = fc[m];
+      }
+    }
+  }
+}
+
+static void set_translational_symmetry_compact_fc(double * fc,
+                                                  const int p2s[],
+                                                  const int n_satom,
+                                                  const int n_patom)
+{
+  int j, k, l, i_p;
+  long m;
+  double sums[3][3];
+
+#pragma omp parallel for private(j, k, l, m, sums)
+  for (i_p = 0; i_p < n_patom; i_p++) {
+    for (k = 0; k < 3; k++) {
+      for (l = 0; l < 3; l++) {
+        sums[k][l] = 0;
+      }
+    }
+    m = (long)i_p * n_satom * 9;
+    for (j = 0; j < n_satom; j++) {
+      if (p2s[i_p] != j) {
+        for (k = 0; k < 3; k++) {
+          for (l = 0; l < 3; l++) {
+            sums[k][l] += fc[m + k * 3 + l];
           }
-          m += 9;
         }
       }
+      m += 9;
     }
     for (k = 0; k < 3; k++) {
       for (l = 0; l < 3; l++) {
-        fc[i * natom * 9 + i * 9 + k * 3 + l] = -(sums[k][l] + sums[l][k]) / 2;
+        fc[(long)i_p * n_satom * 9 + p2s[i_p] * 9 + k * 3 + l] =
+          -(sums[k][l] + sums[l][k]) / 2;
       }
     }
   }
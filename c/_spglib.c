@@ -45,6 +45,9 @@
 
 static PyObject * py_get_version(PyObject *self, PyObject *args);
 static PyObject * py_get_dataset(PyObject *self, PyObject *args);
+static PyObject * py_context_new(PyObject *self, PyObject *args);
+static PyObject * py_context_set_hint(PyObject *self, PyObject *args);
+static PyObject * py_context_get_dataset(PyObject *self, PyObject *args);
 static PyObject * py_get_spacegroup_type(PyObject *self, PyObject *args);
 static PyObject * py_get_pointgroup(PyObject *self, PyObject *args);
 static PyObject * py_standardize_cell(PyObject *self, PyObject *args);
@@ -52,6 +55,7 @@ static PyObject * py_refine_cell(PyObject *self, PyObject *args);
 static PyObject * py_get_symmetry(PyObject *self, PyObject *args);
 static PyObject *
 py_get_symmetry_with_collinear_spin(PyObject *self, PyObject *args);
+static PyObject * py_get_supercell_symmetry(PyObject *self, PyObject *args);
 static PyObject * py_find_primitive(PyObject *self, PyObject *args);
 static PyObject *
 py_get_grid_point_from_address(PyObject *self, PyObject *args);
@@ -68,6 +72,9 @@ static PyObject * py_delaunay_reduce(PyObject *self, PyObject *args);
 static PyObject * py_niggli_reduce(PyObject *self, PyObject *args);
 static PyObject * py_get_error_message(PyObject *self, PyObject *args);
 
+static PyObject * get_dataset_list(SPGCONST SpglibDataset *dataset);
+static void free_context(PyObject *capsule);
+
 struct module_state {
   PyObject *error;
 };
@@ -90,6 +97,12 @@ static PyMethodDef _spglib_methods[] = {
   {"error_out", (PyCFunction)error_out, METH_NOARGS, NULL},
   {"version", py_get_version, METH_VARARGS, "Spglib version"},
   {"dataset", py_get_dataset, METH_VARARGS, "Dataset for crystal symmetry"},
+  {"context_new", py_context_new, METH_VARARGS,
+   "Context of symmetry search reused for similar cells"},
+  {"context_set_hint", py_context_set_hint, METH_VARARGS,
+   "Set expected Hall number and primitive matrix to context"},
+  {"context_dataset", py_context_get_dataset, METH_VARARGS,
+   "Dataset for crystal symmetry searched with context"},
   {"spacegroup_type", py_get_spacegroup_type, METH_VARARGS, "Space-group type symbols"},
   {"symmetry_from_database", py_get_symmetry_from_database, METH_VARARGS,
    "Get symmetry operations from database"},
@@ -100,6 +113,8 @@ static PyMethodDef _spglib_methods[] = {
   {"symmetry", py_get_symmetry, METH_VARARGS, "Symmetry operations"},
   {"symmetry_with_collinear_spin", py_get_symmetry_with_collinear_spin,
    METH_VARARGS, "Symmetry operations with collinear spin magnetic moments"},
+  {"supercell_symmetry", py_get_supercell_symmetry, METH_VARARGS,
+   "Symmetry operations of supercell made from those of unit cell"},
   {"primitive", py_find_primitive, METH_VARARGS,
    "Find primitive cell in the input cell"},
   {"grid_point_from_address", py_get_grid_point_from_address, METH_VARARGS,
@@ -204,14 +219,12 @@ static PyObject * py_get_version(PyObject *self, PyObject *args)
 
 static PyObject * py_get_dataset(PyObject *self, PyObject *args)
 {
-  int i, j, k, n;
   double symprec, angle_tolerance;
   SpglibDataset *dataset;
   PyArrayObject* lattice;
   PyArrayObject* position;
   PyArrayObject* atom_type;
-  PyObject *array, *vec, *mat, *rot, *trans, *wyckoffs, *equiv_atoms;
-  PyObject *std_lattice, *std_types, *std_positions;
+  PyObject *array;
 
   double (*lat)[3];
   double (*pos)[3];
@@ -241,6 +254,121 @@ static PyObject * py_get_dataset(PyObject *self, PyObject *args)
     Py_RETURN_NONE;
   }
 
+  array = get_dataset_list(dataset);
+  spg_free_dataset(dataset);
+
+  return array;
+}
+
+static PyObject * py_context_new(PyObject *self, PyObject *args)
+{
+  double symprec, angle_tolerance;
+  SpglibContext *context;
+
+  if (!PyArg_ParseTuple(args, "dd",
+			&symprec,
+			&angle_tolerance)) {
+    return NULL;
+  }
+
+  if ((context = spg_context_new(symprec, angle_tolerance)) == NULL) {
+    Py_RETURN_NONE;
+  }
+
+  return PyCapsule_New(context, "spglib.context", free_context);
+}
+
+static PyObject * py_context_set_hint(PyObject *self, PyObject *args)
+{
+  int hall_number;
+  PyObject* py_context;
+  PyArrayObject* primitive_matrix;
+  SpglibContext *context;
+
+  if (!PyArg_ParseTuple(args, "OiO",
+			&py_context,
+			&hall_number,
+			&primitive_matrix)) {
+    return NULL;
+  }
+
+  if ((context = (SpglibContext*)PyCapsule_GetPointer(py_context,
+                                                      "spglib.context"))
+      == NULL) {
+    return NULL;
+  }
+
+  if ((PyObject*)primitive_matrix == Py_None) {
+    spg_context_set_hint(context, hall_number, NULL);
+  } else {
+    spg_context_set_hint(context,
+                         hall_number,
+                         (double(*)[3])PyArray_DATA(primitive_matrix));
+  }
+
+  Py_RETURN_NONE;
+}
+
+static PyObject * py_context_get_dataset(PyObject *self, PyObject *args)
+{
+  PyObject* py_context;
+  PyArrayObject* lattice;
+  PyArrayObject* position;
+  PyArrayObject* atom_type;
+  PyObject *array;
+  SpglibContext *context;
+  SpglibDataset *dataset;
+
+  double (*lat)[3];
+  double (*pos)[3];
+  int num_atom;
+  int* typat;
+
+  if (!PyArg_ParseTuple(args, "OOOO",
+			&py_context,
+			&lattice,
+			&position,
+			&atom_type)) {
+    return NULL;
+  }
+
+  if ((context = (SpglibContext*)PyCapsule_GetPointer(py_context,
+                                                      "spglib.context"))
+      == NULL) {
+    return NULL;
+  }
+
+  lat = (double(*)[3])PyArray_DATA(lattice);
+  pos = (double(*)[3])PyArray_DATA(position);
+  num_atom = PyArray_DIMS(position)[0];
+  typat = (int*)PyArray_DATA(atom_type);
+
+  if ((dataset = spg_context_get_dataset(context,
+                                         lat,
+                                         pos,
+                                         typat,
+                                         num_atom)) == NULL) {
+    Py_RETURN_NONE;
+  }
+
+  array = get_dataset_list(dataset);
+  spg_free_dataset(dataset);
+
+  return array;
+}
+
+static void free_context(PyObject *capsule)
+{
+  spg_context_free((SpglibContext*)PyCapsule_GetPointer(capsule,
+                                                        "spglib.context"));
+}
+
+static PyObject * get_dataset_list(SPGCONST SpglibDataset *dataset)
+{
+  int i, j, k, n;
+  PyObject *array, *vec, *mat, *rot, *trans, *wyckoffs, *equiv_atoms;
+  PyObject *std_lattice, *std_types, *std_positions;
+
   array = PyList_New(15);
   n = 0;
 
@@ -349,8 +477,6 @@ static PyObject * py_get_dataset(PyObject *self, PyObject *args)
   PyList_SetItem(array, n, PYUNICODE_FROMSTRING(dataset->pointgroup_symbol));
   n++;
 
-  spg_free_dataset(dataset);
-
   return array;
 }
 
@@ -692,6 +818,94 @@ static PyObject * py_get_symmetry_with_collinear_spin(PyObject *self,
   return PyLong_FromLong((long) num_sym);
 }
 
+static PyObject * py_get_supercell_symmetry(PyObject *self, PyObject *args)
+{
+  double symprec;
+  PyArrayObject* rotation;
+  PyArrayObject* translation;
+  PyArrayObject* equiv_atoms_py;
+  PyArrayObject* map_operations_py;
+  PyArrayObject* unit_rotation;
+  PyArrayObject* unit_translation;
+  PyArrayObject* unit_lattice;
+  PyArrayObject* unit_position;
+  PyArrayObject* unit_atom_type;
+  PyArrayObject* tmat_py;
+  PyArrayObject* position;
+  PyArrayObject* atom_type;
+
+  int (*rot)[3][3];
+  double (*trans)[3];
+  int *equiv_atoms;
+  int *map_operations;
+  int (*unit_rot)[3][3];
+  double (*unit_trans)[3];
+  int num_unit_sym;
+  double (*unit_lat)[3];
+  double (*unit_pos)[3];
+  int *unit_types;
+  int num_unit_atom;
+  int (*tmat)[3];
+  double (*pos)[3];
+  int *types;
+  int num_atom;
+  int num_sym_from_array_size;
+  int num_sym;
+
+  if (!PyArg_ParseTuple(args, "OOOOOOOOOOOOd",
+			&rotation,
+			&translation,
+			&equiv_atoms_py,
+			&map_operations_py,
+			&unit_rotation,
+			&unit_translation,
+			&unit_lattice,
+			&unit_position,
+			&unit_atom_type,
+			&tmat_py,
+			&position,
+			&atom_type,
+			&symprec)) {
+    return NULL;
+  }
+
+  rot = (int(*)[3][3])PyArray_DATA(rotation);
+  trans = (double(*)[3])PyArray_DATA(translation);
+  equiv_atoms = (int*)PyArray_DATA(equiv_atoms_py);
+  map_operations = (int*)PyArray_DATA(map_operations_py);
+  num_sym_from_array_size = PyArray_DIMS(rotation)[0];
+  unit_rot = (int(*)[3][3])PyArray_DATA(unit_rotation);
+  unit_trans = (double(*)[3])PyArray_DATA(unit_translation);
+  num_unit_sym = PyArray_DIMS(unit_rotation)[0];
+  unit_lat = (double(*)[3])PyArray_DATA(unit_lattice);
+  unit_pos = (double(*)[3])PyArray_DATA(unit_position);
+  unit_types = (int*)PyArray_DATA(unit_atom_type);
+  num_unit_atom = PyArray_DIMS(unit_position)[0];
+  tmat = (int(*)[3])PyArray_DATA(tmat_py);
+  pos = (double(*)[3])PyArray_DATA(position);
+  types = (int*)PyArray_DATA(atom_type);
+  num_atom = PyArray_DIMS(position)[0];
+
+  num_sym = spg_get_supercell_symmetry(rot,
+                                       trans,
+                                       equiv_atoms,
+                                       map_operations,
+                                       num_sym_from_array_size,
+                                       unit_rot,
+                                       unit_trans,
+                                       num_unit_sym,
+                                       unit_lat,
+                                       unit_pos,
+                                       unit_types,
+                                       num_unit_atom,
+                                       tmat,
+                                       pos,
+                                       types,
+                                       num_atom,
+                                       symprec);
+  return PyLong_FromLong((long) num_sym);
+}
+
 static PyObject * py_get_grid_point_from_address(PyObject *self, PyObject *args)
 {
   PyArrayObject* grid_address_py;
@@ -34,6 +34,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <derivative_dynmat.h>
 #define PI 3.14159265358979323846
 
 static void get_derivative_nac(double *ddnac,
@@ -76,14 +77,137 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
                                 const double nac_factor,
                                 const double *born,
                                 const double *dielectric,
-                                const double *q_direction)
+                                const double *q_direction,
+                                const int *pair_ptr,
+                                const int *pair_atoms)
 {
-  int i, j, k, l, m, n, adrs, adrsT, is_nac;
+  double *nac_buffer;
+
+  nac_buffer = NULL;
+  if (born) {
+    nac_buffer = (double*)malloc(sizeof(double) * num_patom * num_patom * 36);
+  }
+
+  get_derivative_dynmat_at_q_with_buffer(derivative_dynmat,
+                                         num_patom,
+                                         num_satom,
+                                         fc,
+                                         q,
+                                         lattice,
+                                         r,
+                                         multi,
+                                         mass,
+                                         s2p_map,
+                                         p2s_map,
+                                         nac_factor,
+                                         born,
+                                         dielectric,
+                                         q_direction,
+                                         pair_ptr,
+                                         pair_atoms,
+                                         nac_buffer);
+
+  if (nac_buffer) {
+    free(nac_buffer);
+    nac_buffer = NULL;
+  }
+}
+
+/* derivative_dynmats[num_qpoints, 3, num_band, num_band, (real,imag)] */
+/* is overwritten. Parallelized over q-points with one NAC buffer per */
+/* thread. */
+void get_derivative_dynmats_at_qpoints(double *derivative_dynmats,
+                                       const int num_qpoints,
+                                       const double *qpoints,
+                                       const int num_patom,
+                                       const int num_satom,
+                                       const double *fc,
+                                       const double *lattice,
+                                       const double *r,
+                                       const int *multi,
+                                       const double *mass,
+                                       const int *s2p_map,
+                                       const int *p2s_map,
+                                       const double nac_factor,
+                                       const double *born,
+                                       const double *dielectric,
+                                       const double *q_direction,
+                                       const int *pair_ptr,
+                                       const int *pair_atoms)
+{
+  int i, num_elem;
+  double *nac_buffer;
+
+  num_elem = num_patom * num_patom * 18;
+
+#pragma omp parallel private(nac_buffer)
+  {
+    nac_buffer = NULL;
+    if (born) {
+      nac_buffer = (double*)
+        malloc(sizeof(double) * num_patom * num_patom * 36);
+    }
+
+#pragma omp for
+    for (i = 0; i < num_qpoints; i++) {
+      get_derivative_dynmat_at_q_with_buffer(
+        derivative_dynmats + (long)i * num_elem * 3,
+        num_patom,
+        num_satom,
+        fc,
+        qpoints + i * 3,
+        lattice,
+        r,
+        multi,
+        mass,
+        s2p_map,
+        p2s_map,
+        nac_factor,
+        born,
+        dielectric,
+        q_direction,
+        pair_ptr,
+        pair_atoms,
+        nac_buffer);
+    }
+
+    if (nac_buffer) {
+      free(nac_buffer);
+      nac_buffer = NULL;
+    }
+  }
+}
+
+/* derivative_dynmat is overwritten. nac_buffer needs */
+/* num_patom * num_patom * 36 elements when born is given. */
+void get_derivative_dynmat_at_q_with_buffer(double *derivative_dynmat,
+                                            const int num_patom,
+                                            const int num_satom,
+                                            const double *fc,
+                                            const double *q,
+                                            const double *lattice,
+                                            const double *r,
+                                            const int *multi,
+                                            const double *mass,
+                                            const int *s2p_map,
+                                            const int *p2s_map,
+                                            const double nac_factor,
+                                            const double *born,
+                                            const double *dielectric,
+                                            const double *q_direction,
+                                            const int *pair_ptr,
+                                            const int *pair_atoms,
+                                            double *nac_buffer)
+{
+  int i, j, k, l, m, n, adrs, adrsT, is_nac, num_k, k_index;
   double coef[3], real_coef[3], imag_coef[3];
   double c, s, phase, mass_sqrt, fc_elem, factor, real_phase, imag_phase;
   double ddm_real[3][3][3], ddm_imag[3][3][3];
   double *ddnac, *dnac;
 
+  ddnac = NULL;
+  dnac = NULL;
+
   if (born) {
     is_nac = 1;
     if (q_direction) {
@@ -104,8 +228,8 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
   }
 
   if (is_nac) {
-    ddnac = (double*) malloc(sizeof(double) * num_patom * num_patom * 27);
-    dnac = (double*) malloc(sizeof(double) * num_patom * num_patom * 9);
+    ddnac = nac_buffer;
+    dnac = nac_buffer + num_patom * num_patom * 27;
     factor = nac_factor * num_patom / num_satom;
     get_derivative_nac(ddnac,
                        dnac,
@@ -132,9 +256,22 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
         }
       }
 
-      for (k = 0; k < num_satom; k++) { /* Lattice points of right index of fc */
-        if (s2p_map[k] != p2s_map[j]) {
-          continue;
+      /* With NAC, every supercell atom has to be visited since dnac and */
+      /* ddnac are added irrespective of fc. */
+      if (pair_ptr && !is_nac) {
+        num_k = pair_ptr[i * num_patom + j + 1] - pair_ptr[i * num_patom + j];
+      } else {
+        num_k = num_satom;
+      }
+
+      for (k_index = 0; k_index < num_k; k_index++) {
+        if (pair_ptr && !is_nac) {
+          k = pair_atoms[pair_ptr[i * num_patom + j] + k_index];
+        } else {
+          k = k_index; /* Lattice points of right index of fc */
+          if (s2p_map[k] != p2s_map[j]) {
+            continue;
+          }
         }
 
         real_phase = 0;
@@ -204,8 +341,8 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
           for (m = 0; m < 3; m++) {
             adrs = (k * num_patom * num_patom * 18 +
                     (i * 3 + l) * num_patom * 6 + j * 6 + m * 2);
-            derivative_dynmat[adrs] += ddm_real[k][l][m];
-            derivative_dynmat[adrs + 1] += ddm_imag[k][l][m];
+            derivative_dynmat[adrs] = ddm_real[k][l][m];
+            derivative_dynmat[adrs + 1] = ddm_imag[k][l][m];
           }
         }
       }
@@ -227,12 +364,6 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
       }
     }
   }
-
-
-  if (is_nac) {
-    free(ddnac);
-    free(dnac);
-  }
 }
 
 /* D_nac = a * AB/C */
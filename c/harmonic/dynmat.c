@@ -48,6 +48,11 @@ static void get_dynmat_ij(double *dynamical_matrix,
                           const int *s2p_map,
                           const int *p2s_map,
                           PHPYCONST double (*charge_sum)[3][3],
+                          PHPYCONST double (*lattice_phases)[2],
+                          PHPYCONST int (*lattice_index)[27],
+                          PHPYCONST double (*pos)[3],
+                          const int *pair_ptr,
+                          const int *pair_atoms,
                           const int i,
                           const int j);
 static void get_dm(double dm_real[3][3],
@@ -60,9 +65,16 @@ static void get_dm(double dm_real[3][3],
                    const int *multi,
                    const int *p2s_map,
                    PHPYCONST double (*charge_sum)[3][3],
+                   PHPYCONST double (*lattice_phases)[2],
+                   PHPYCONST int (*lattice_index)[27],
                    const int i,
                    const int j,
                    const int k);
+static void get_lattice_phases(double (*lattice_phases)[2],
+                               const double q[3],
+                               PHPYCONST int (*lattice_points)[3],
+                               const int num_lattice_points,
+                               const int with_openmp);
 static double get_dielectric_part(const double q_cart[3],
                                   PHPYCONST double dielectric[3][3]);
 static void get_KK(double *dd_part, /* [natom, 3, natom, 3, (real,imag)] */
@@ -74,13 +86,23 @@ static void get_KK(double *dd_part, /* [natom, 3, natom, 3, (real,imag)] */
                    PHPYCONST double dielectric[3][3],
                    PHPYCONST double (*pos)[3], /* [num_patom, 3] */
                    const double lambda,
-                   const double tolerance);
+                   const double tolerance,
+                   const DipoleDipoleWorkspace *ws);
 static void make_Hermitian(double *mat, const int num_band);
 static void multiply_borns(double *dd,
                            const double *dd_in,
                            const int num_patom,
                            PHPYCONST double (*born)[3][3]);
 
+/* When lattice_points is not NULL, phase factors are taken from the */
+/* table of exp(2pi i q.R) of the lattice points R, where */
+/* svecs[k * num_patom + i][l] = pos[j] - pos[i] + */
+/*                              lattice_points[lattice_index[k * num_patom + i][l]] */
+/* and j is the primitive atom that the supercell atom k belongs to. */
+/* When pair_ptr is not NULL, only the supercell atoms */
+/* pair_atoms[pair_ptr[i * num_patom + j]:pair_ptr[i * num_patom + j + 1]] */
+/* are summed up for the atom pair (i, j), e.g., those with non-zero fc. */
+/* This is ignored with charge_sum since it is added to every fc element. */
 int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                                   const int num_patom,
                                   const int num_satom,
@@ -92,9 +114,27 @@ int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                                   const int *s2p_map,
                                   const int *p2s_map,
                                   PHPYCONST double (*charge_sum)[3][3],
+                                  PHPYCONST int (*lattice_points)[3],
+                                  const int num_lattice_points,
+                                  PHPYCONST int (*lattice_index)[27],
+                                  PHPYCONST double (*pos)[3],
+                                  const int *pair_ptr,
+                                  const int *pair_atoms,
                                   const int with_openmp)
 {
   int i, j, ij;
+  double (*lattice_phases)[2];
+
+  lattice_phases = NULL;
+  if (lattice_points) {
+    lattice_phases = (double(*)[2])
+      malloc(sizeof(double[2]) * num_lattice_points);
+    get_lattice_phases(lattice_phases,
+                       q,
+                       lattice_points,
+                       num_lattice_points,
+                       with_openmp);
+  }
 
   if (with_openmp) {
 #pragma omp parallel for
@@ -110,6 +150,11 @@ int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                     s2p_map,
                     p2s_map,
                     charge_sum,
+                    lattice_phases,
+                    lattice_index,
+                    pos,
+                    pair_ptr,
+                    pair_atoms,
                     ij / num_patom,  /* i */
                     ij % num_patom); /* j */
     }
@@ -127,6 +172,11 @@ int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                       s2p_map,
                       p2s_map,
                       charge_sum,
+                      lattice_phases,
+                      lattice_index,
+                      pos,
+                      pair_ptr,
+                      pair_atoms,
                       i,
                       j);
       }
@@ -135,6 +185,88 @@ int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
 
   make_Hermitian(dynamical_matrix, num_patom * 3);
 
+  if (lattice_phases) {
+    free(lattice_phases);
+    lattice_phases = NULL;
+  }
+
+  return 0;
+}
+
+/* dynamical_matrices[num_qpoints, num_patom * 3, num_patom * 3, (real,imag)] */
+/* When born is not NULL, charge_sum is computed at each q-point with */
+/* q_cart[i] and nac_factors[i], where nac_factors has to contain */
+/* 4pi/V*unit-conv/(q.eps.q) divided by num_satom / num_patom. */
+int dym_get_dynamical_matrices_at_qpoints(double *dynamical_matrices,
+                                          const int num_qpoints,
+                                          PHPYCONST double (*qpoints)[3],
+                                          const int num_patom,
+                                          const int num_satom,
+                                          const double *fc,
+                                          PHPYCONST double (*svecs)[27][3],
+                                          const int *multi,
+                                          const double *mass,
+                                          const int *s2p_map,
+                                          const int *p2s_map,
+                                          PHPYCONST int (*lattice_points)[3],
+                                          const int num_lattice_points,
+                                          PHPYCONST int (*lattice_index)[27],
+                                          PHPYCONST double (*pos)[3],
+                                          const int *pair_ptr,
+                                          const int *pair_atoms,
+                                          PHPYCONST double (*q_cart)[3],
+                                          PHPYCONST double (*born)[3][3],
+                                          const double *nac_factors)
+{
+  int i, num_elem;
+  double (*charge_sum)[3][3];
+
+  num_elem = num_patom * num_patom * 18;
+
+  /* Parallelized over q-points, therefore not over atom pairs inside. */
+#pragma omp parallel private(charge_sum)
+  {
+    charge_sum = NULL;
+    if (born) {
+      charge_sum = (double(*)[3][3])
+        malloc(sizeof(double[3][3]) * num_patom * num_patom);
+    }
+
+#pragma omp for
+    for (i = 0; i < num_qpoints; i++) {
+      if (born) {
+        dym_get_charge_sum(charge_sum,
+                           num_patom,
+                           nac_factors[i],
+                           q_cart[i],
+                           born);
+      }
+      dym_get_dynamical_matrix_at_q(dynamical_matrices + (long)i * num_elem,
+                                    num_patom,
+                                    num_satom,
+                                    fc,
+                                    qpoints[i],
+                                    svecs,
+                                    multi,
+                                    mass,
+                                    s2p_map,
+                                    p2s_map,
+                                    charge_sum,
+                                    lattice_points,
+                                    num_lattice_points,
+                                    lattice_index,
+                                    pos,
+                                    pair_ptr,
+                                    pair_atoms,
+                                    0);
+    }
+
+    if (charge_sum) {
+      free(charge_sum);
+      charge_sum = NULL;
+    }
+  }
+
   return 0;
 }
 
@@ -150,13 +282,18 @@ void dym_get_dipole_dipole(double *dd, /* [natom, 3, natom, 3, (real,imag)] */
                            PHPYCONST double (*pos)[3], /* [num_patom, 3] */
                            const double factor, /* 4pi/V*unit-conv */
                            const double lambda,
-                           const double tolerance)
+                           const double tolerance,
+                           DipoleDipoleWorkspace *ws)
 {
   int i, k, l, adrs, adrs_sum;
   double *dd_tmp;
 
   dd_tmp = NULL;
-  dd_tmp = (double*) malloc(sizeof(double) * num_patom * num_patom * 18);
+  if (ws) {
+    dd_tmp = ws->dd_tmp;
+  } else {
+    dd_tmp = (double*) malloc(sizeof(double) * num_patom * num_patom * 18);
+  }
 
   for (i = 0; i < num_patom * num_patom * 18; i++) {
     dd[i] = 0;
@@ -172,7 +309,8 @@ void dym_get_dipole_dipole(double *dd, /* [natom, 3, natom, 3, (real,imag)] */
          dielectric,
          pos,
          lambda,
-         tolerance);
+         tolerance,
+         ws);
 
   multiply_borns(dd, dd_tmp, num_patom, born);
 
@@ -194,10 +332,49 @@ void dym_get_dipole_dipole(double *dd, /* [natom, 3, natom, 3, (real,imag)] */
   /* This may not be necessary. */
   make_Hermitian(dd, num_patom * 3);
 
-  free(dd_tmp);
+  if (!ws) {
+    free(dd_tmp);
+  }
   dd_tmp = NULL;
 }
 
+/* Set q-independent part of G-space sum to workspace. */
+/* Arrays in ws have to be allocated by caller. */
+void dym_set_dipole_dipole_workspace(DipoleDipoleWorkspace *ws,
+                                     PHPYCONST double (*G_list)[3], /* [num_G, 3] */
+                                     const int num_G,
+                                     const int num_patom,
+                                     PHPYCONST double dielectric[3][3],
+                                     PHPYCONST double (*pos)[3]) /* [num_patom, 3] */
+{
+  int g, i, j, k, adrs;
+  double phase;
+
+#pragma omp parallel for private(i, j, k, adrs, phase)
+  for (g = 0; g < num_G; g++) {
+    ws->G_norm2[g] = 0;
+    for (i = 0; i < 3; i++) {
+      ws->G_norm2[g] += G_list[g][i] * G_list[g][i];
+      ws->eps_G[g][i] = 0;
+      for (j = 0; j < 3; j++) {
+        ws->eps_G[g][i] += (dielectric[i][j] + dielectric[j][i]) * G_list[g][j];
+      }
+    }
+    ws->G_eps_G[g] = get_dielectric_part(G_list[g], dielectric);
+
+    for (i = 0; i < num_patom; i++) {
+      phase = 0;
+      for (k = 0; k < 3; k++) {
+        phase += pos[i][k] * G_list[g][k];
+      }
+      phase *= 2 * PI;
+      adrs = g * num_patom + i;
+      ws->G_phases[adrs][0] = cos(phase);
+      ws->G_phases[adrs][1] = sin(phase);
+    }
+  }
+}
+
 void dym_get_dipole_dipole_q0(double *dd_q0, /* [natom, 3, 3, (real,imag)] */
                               PHPYCONST double (*G_list)[3], /* [num_G, 3] */
                               const int num_G,
@@ -235,7 +412,8 @@ void dym_get_dipole_dipole_q0(double *dd_q0, /* [natom, 3, 3, (real,imag)] */
          dielectric,
          pos,
          lambda,
-         tolerance);
+         tolerance,
+         NULL);
 
   multiply_borns(dd_tmp2, dd_tmp1, num_patom, born);
 
@@ -321,6 +499,12 @@ void dym_get_charge_sum(double (*charge_sum)[3][3],
 /* comm_points[num_satom, num_patom, 27, 3] */
 /* shortest_vectors[num_satom, num_patom, 27, 3] */
 /* multiplicities[num_satom, num_patom] */
+/* Force constants of each pair (i, j) are summed over commensurate */
+/* points from the 3x3 blocks of dm that are copied beforehand to be */
+/* contiguous along commensurate points. Phase factors are tabulated */
+/* for all commensurate points before the sum. When lattice_points is */
+/* not NULL, they are tabulated for atom positions and lattice points */
+/* separately as in dym_get_dynamical_matrix_at_q. */
 void dym_transform_dynmat_to_fc(double *fc,
                                 const double *dm,
                                 PHPYCONST double (*comm_points)[3],
@@ -328,46 +512,149 @@ void dym_transform_dynmat_to_fc(double *fc,
                                 const int *multiplicities,
                                 const double *masses,
                                 const int *s2pp_map,
+                                PHPYCONST int (*lattice_points)[3],
+                                const int num_lattice_points,
+                                PHPYCONST int (*lattice_index)[27],
+                                PHPYCONST double (*pos)[3],
                                 const int num_patom,
                                 const int num_satom)
 {
-  int i, j, k, l, m, N, adrs, multi;
-  double coef, phase, cos_phase, sin_phase;
+  int i, j, k, l, m, N, ij, ip, multi;
+  long adrs, adrs_t;
+  double coef, phase, cos_phase, sin_phase, real, imag;
+  double *dm_t, *phases;
+  double (*atom_phases)[2], (*lattice_phases)[2];
+  const double *dm_ip;
 
   N = num_satom / num_patom;
-  for (i = 0; i < num_patom * num_satom * 9; i++) {
-    fc[i] = 0;
+
+  /* dm_t[num_patom, num_patom, N, 3, 3, (real,imag)] */
+  dm_t = (double*)malloc(sizeof(double) * N * num_patom * num_patom * 18);
+#pragma omp parallel for private(k, l, m, adrs, adrs_t)
+  for (ip = 0; ip < num_patom * num_patom; ip++) {
+    for (k = 0; k < N; k++) {
+      for (l = 0; l < 3; l++) {
+        adrs = (long)k * num_patom * num_patom * 18 +
+          (ip / num_patom) * num_patom * 18 + l * num_patom * 6 +
+          (ip % num_patom) * 6;
+        adrs_t = ((long)ip * N + k) * 18 + l * 6;
+        for (m = 0; m < 6; m++) {
+          dm_t[adrs_t + m] = dm[adrs + m];
+        }
+      }
+    }
   }
 
-  for (i = 0; i < num_patom; i++) {
-    for (j = 0; j < num_satom; j++) {
-      coef = sqrt(masses[i] * masses[s2pp_map[j]]) / N;
+  atom_phases = NULL;
+  lattice_phases = NULL;
+  if (lattice_points) {
+    atom_phases = (double(*)[2])
+      malloc(sizeof(double[2]) * num_patom * num_patom * N);
+    lattice_phases = (double(*)[2])
+      malloc(sizeof(double[2]) * num_lattice_points * N);
+#pragma omp parallel for private(k, m, phase)
+    for (ip = 0; ip < num_patom * num_patom; ip++) {
+      for (k = 0; k < N; k++) {
+        phase = 0;
+        for (m = 0; m < 3; m++) {
+          phase -= comm_points[k][m] *
+            (pos[ip % num_patom][m] - pos[ip / num_patom][m]);
+        }
+        atom_phases[ip * N + k][0] = cos(phase * 2 * PI);
+        atom_phases[ip * N + k][1] = sin(phase * 2 * PI);
+      }
+    }
+#pragma omp parallel for private(k, phase)
+    for (l = 0; l < num_lattice_points; l++) {
       for (k = 0; k < N; k++) {
-        cos_phase = 0;
-        sin_phase = 0;
-        multi = multiplicities[j * num_patom + i];
+        phase = -(comm_points[k][0] * lattice_points[l][0] +
+                  comm_points[k][1] * lattice_points[l][1] +
+                  comm_points[k][2] * lattice_points[l][2]);
+        lattice_phases[(long)l * N + k][0] = cos(phase * 2 * PI);
+        lattice_phases[(long)l * N + k][1] = sin(phase * 2 * PI);
+      }
+    }
+  }
+
+#pragma omp parallel private(i, j, k, l, m, ip, multi, adrs, coef, phase, \
+                             cos_phase, sin_phase, real, imag, phases, dm_ip)
+  {
+    /* phases[N, (real,imag)] */
+    phases = (double*)malloc(sizeof(double) * N * 2);
+
+#pragma omp for
+    for (ij = 0; ij < num_patom * num_satom; ij++) {
+      i = ij / num_satom;
+      j = ij % num_satom;
+      ip = i * num_patom + s2pp_map[j];
+      multi = multiplicities[j * num_patom + i];
+      coef = sqrt(masses[i] * masses[s2pp_map[j]]) / N;
+
+      for (k = 0; k < N * 2; k++) {
+        phases[k] = 0;
+      }
+      if (lattice_phases) {
         for (l = 0; l < multi; l++) {
-          phase = 0;
-          for (m = 0; m < 3; m++) {
-            phase -= comm_points[k][m] *
-              shortest_vectors[j * num_patom + i][l][m];
+          adrs = (long)lattice_index[j * num_patom + i][l] * N;
+          for (k = 0; k < N; k++) {
+            phases[k * 2] += lattice_phases[adrs + k][0];
+            phases[k * 2 + 1] += lattice_phases[adrs + k][1];
           }
-          cos_phase += cos(phase * 2 * PI);
-          sin_phase += sin(phase * 2 * PI);
         }
-        cos_phase /=  multi;
-        sin_phase /=  multi;
-        for (l = 0; l < 3; l++) {
-          for (m = 0; m < 3; m++) {
-            adrs = k * num_patom * num_patom * 18 + i * num_patom * 18 +
-              l * num_patom * 6 + s2pp_map[j] * 6 + m * 2;
-            fc[i * num_satom * 9 + j * 9 + l * 3 + m] +=
-              (dm[adrs] * cos_phase - dm[adrs + 1] * sin_phase) * coef;
+        for (k = 0; k < N; k++) {
+          real = phases[k * 2];
+          imag = phases[k * 2 + 1];
+          phases[k * 2] = (real * atom_phases[ip * N + k][0] -
+                           imag * atom_phases[ip * N + k][1]) / multi;
+          phases[k * 2 + 1] = (real * atom_phases[ip * N + k][1] +
+                               imag * atom_phases[ip * N + k][0]) / multi;
+        }
+      } else {
+        for (k = 0; k < N; k++) {
+          cos_phase = 0;
+          sin_phase = 0;
+          for (l = 0; l < multi; l++) {
+            phase = 0;
+            for (m = 0; m < 3; m++) {
+              phase -= comm_points[k][m] *
+                shortest_vectors[j * num_patom + i][l][m];
+            }
+            cos_phase += cos(phase * 2 * PI);
+            sin_phase += sin(phase * 2 * PI);
           }
+          phases[k * 2] = cos_phase / multi;
+          phases[k * 2 + 1] = sin_phase / multi;
         }
       }
+
+      for (l = 0; l < 9; l++) {
+        fc[(long)ij * 9 + l] = 0;
+      }
+      dm_ip = dm_t + (long)ip * N * 18;
+      for (k = 0; k < N; k++) {
+        for (l = 0; l < 9; l++) {
+          fc[(long)ij * 9 + l] += (dm_ip[k * 18 + l * 2] * phases[k * 2] -
+                                   dm_ip[k * 18 + l * 2 + 1] *
+                                   phases[k * 2 + 1]);
+        }
+      }
+      for (l = 0; l < 9; l++) {
+        fc[(long)ij * 9 + l] *= coef;
+      }
     }
+
+    free(phases);
+    phases = NULL;
   }
+
+  if (lattice_phases) {
+    free(atom_phases);
+    atom_phases = NULL;
+    free(lattice_phases);
+    lattice_phases = NULL;
+  }
+  free(dm_t);
+  dm_t = NULL;
 }
 
 
@@ -382,11 +669,16 @@ static void get_dynmat_ij(double *dynamical_matrix,
                           const int *s2p_map,
                           const int *p2s_map,
                           PHPYCONST double (*charge_sum)[3][3],
+                          PHPYCONST double (*lattice_phases)[2],
+                          PHPYCONST int (*lattice_index)[27],
+                          PHPYCONST double (*pos)[3],
+                          const int *pair_ptr,
+                          const int *pair_atoms,
                           const int i,
                           const int j)
 {
-  int k, l, adrs;
-  double mass_sqrt;
+  int k, l, m, adrs;
+  double mass_sqrt, phase, cos_phase, sin_phase, real, imag;
   double dm_real[3][3], dm_imag[3][3];
 
   mass_sqrt = sqrt(mass[i] * mass[j]);
@@ -398,23 +690,65 @@ static void get_dynmat_ij(double *dynamical_matrix,
     }
   }
 
-  for (k = 0; k < num_satom; k++) { /* Lattice points of right index of fc */
-    if (s2p_map[k] != p2s_map[j]) {
-      continue;
+  if (pair_ptr && !charge_sum) {
+    for (m = pair_ptr[i * num_patom + j];
+         m < pair_ptr[i * num_patom + j + 1];
+         m++) {
+      get_dm(dm_real,
+             dm_imag,
+             num_patom,
+             num_satom,
+             fc,
+             q,
+             svecs,
+             multi,
+             p2s_map,
+             charge_sum,
+             lattice_phases,
+             lattice_index,
+             i,
+             j,
+             pair_atoms[m]);
+    }
+  } else {
+    for (k = 0; k < num_satom; k++) { /* Lattice points of right index of fc */
+      if (s2p_map[k] != p2s_map[j]) {
+        continue;
+      }
+      get_dm(dm_real,
+             dm_imag,
+             num_patom,
+             num_satom,
+             fc,
+             q,
+             svecs,
+             multi,
+             p2s_map,
+             charge_sum,
+             lattice_phases,
+             lattice_index,
+             i,
+             j,
+             k);
+    }
+  }
+
+  /* Phase of pos[j] - pos[i] is common to all lattice points. */
+  if (lattice_phases) {
+    phase = 0;
+    for (k = 0; k < 3; k++) {
+      phase += q[k] * (pos[j][k] - pos[i][k]);
+    }
+    cos_phase = cos(phase * 2 * PI);
+    sin_phase = sin(phase * 2 * PI);
+    for (k = 0; k < 3; k++) {
+      for (l = 0; l < 3; l++) {
+        real = dm_real[k][l];
+        imag = dm_imag[k][l];
+        dm_real[k][l] = real * cos_phase - imag * sin_phase;
+        dm_imag[k][l] = real * sin_phase + imag * cos_phase;
+      }
     }
-    get_dm(dm_real,
-           dm_imag,
-           num_patom,
-           num_satom,
-           fc,
-           q,
-           svecs,
-           multi,
-           p2s_map,
-           charge_sum,
-           i,
-           j,
-           k);
   }
 
   for (k = 0; k < 3; k++) {
@@ -436,6 +770,8 @@ static void get_dm(double dm_real[3][3],
                    const int *multi,
                    const int *p2s_map,
                    PHPYCONST double (*charge_sum)[3][3],
+                   PHPYCONST double (*lattice_phases)[2],
+                   PHPYCONST int (*lattice_index)[27],
                    const int i,
                    const int j,
                    const int k)
@@ -446,13 +782,23 @@ static void get_dm(double dm_real[3][3],
   cos_phase = 0;
   sin_phase = 0;
 
-  for (l = 0; l < multi[k * num_patom + i]; l++) {
-    phase = 0;
-    for (m = 0; m < 3; m++) {
-      phase += q[m] * svecs[k * num_patom + i][l][m];
+  if (lattice_phases) {
+    for (l = 0; l < multi[k * num_patom + i]; l++) {
+      m = lattice_index[k * num_patom + i][l];
+      cos_phase += lattice_phases[m][0];
+      sin_phase += lattice_phases[m][1];
+    }
+    cos_phase /= multi[k * num_patom + i];
+    sin_phase /= multi[k * num_patom + i];
+  } else {
+    for (l = 0; l < multi[k * num_patom + i]; l++) {
+      phase = 0;
+      for (m = 0; m < 3; m++) {
+        phase += q[m] * svecs[k * num_patom + i][l][m];
+      }
+      cos_phase += cos(phase * 2 * PI) / multi[k * num_patom + i];
+      sin_phase += sin(phase * 2 * PI) / multi[k * num_patom + i];
     }
-    cos_phase += cos(phase * 2 * PI) / multi[k * num_patom + i];
-    sin_phase += sin(phase * 2 * PI) / multi[k * num_patom + i];
   }
 
   for (l = 0; l < 3; l++) {
@@ -469,6 +815,35 @@ static void get_dm(double dm_real[3][3],
   }
 }
 
+static void get_lattice_phases(double (*lattice_phases)[2],
+                               const double q[3],
+                               PHPYCONST int (*lattice_points)[3],
+                               const int num_lattice_points,
+                               const int with_openmp)
+{
+  int i;
+  double phase;
+
+  if (with_openmp) {
+#pragma omp parallel for private(phase)
+    for (i = 0; i < num_lattice_points; i++) {
+      phase = (q[0] * lattice_points[i][0] +
+               q[1] * lattice_points[i][1] +
+               q[2] * lattice_points[i][2]) * 2 * PI;
+      lattice_phases[i][0] = cos(phase);
+      lattice_phases[i][1] = sin(phase);
+    }
+  } else {
+    for (i = 0; i < num_lattice_points; i++) {
+      phase = (q[0] * lattice_points[i][0] +
+               q[1] * lattice_points[i][1] +
+               q[2] * lattice_points[i][2]) * 2 * PI;
+      lattice_phases[i][0] = cos(phase);
+      lattice_phases[i][1] = sin(phase);
+    }
+  }
+}
+
 static double get_dielectric_part(const double q_cart[3],
                                   PHPYCONST double dielectric[3][3])
 {
@@ -500,23 +875,53 @@ static void get_KK(double *dd_part, /* [natom, 3, natom, 3, (real,imag)] */
                    PHPYCONST double dielectric[3][3],
                    PHPYCONST double (*pos)[3], /* [num_patom, 3] */
                    const double lambda,
-                   const double tolerance)
+                   const double tolerance,
+                   const DipoleDipoleWorkspace *ws)
 {
   int i, j, k, l, g, adrs;
   double q_K[3];
   double norm, cos_phase, sin_phase, phase, dielectric_part, exp_damp, L2;
+  double q_norm2, q_eps_q;
   double KK[3][3];
+  double (*atom_phases)[2];
+  double (*G_phases)[2];
+
+  atom_phases = NULL;
+  G_phases = NULL;
+
+  /* exp(2pi i G.(r_i - r_j)) = exp(2pi i G.r_i) * conj(exp(2pi i G.r_j)) */
+  /* Only per-atom phases are needed at each G. */
+  if (!ws) {
+    atom_phases = (double(*)[2]) malloc(sizeof(double[2]) * num_patom);
+  }
 
   L2 = 4 * lambda * lambda;
 
+  q_norm2 = 0;
+  for (i = 0; i < 3; i++) {
+    q_norm2 += q_cart[i] * q_cart[i];
+  }
+  q_eps_q = get_dielectric_part(q_cart, dielectric);
+
   /* sum over K = G + q and over G (i.e. q=0) */
   /* q_direction has values for summation over K at Gamma point. */
   /* q_direction is NULL for summation over G */
   for (g = 0; g < num_G; g++) {
-    norm = 0;
     for (i = 0; i < 3; i++) {
       q_K[i] = G_list[g][i] + q_cart[i];
-      norm += q_K[i] * q_K[i];
+    }
+
+    /* |K|^2 and K.eps.K are expanded by G-only parts in workspace. */
+    if (ws) {
+      norm = ws->G_norm2[g] + q_norm2;
+      for (i = 0; i < 3; i++) {
+        norm += 2 * G_list[g][i] * q_cart[i];
+      }
+    } else {
+      norm = 0;
+      for (i = 0; i < 3; i++) {
+        norm += q_K[i] * q_K[i];
+      }
     }
 
     if (sqrt(norm) < tolerance) {
@@ -532,7 +937,14 @@ static void get_KK(double *dd_part, /* [natom, 3, natom, 3, (real,imag)] */
         }
       }
     } else {
-      dielectric_part = get_dielectric_part(q_K, dielectric);
+      if (ws) {
+        dielectric_part = ws->G_eps_G[g] + q_eps_q;
+        for (i = 0; i < 3; i++) {
+          dielectric_part += ws->eps_G[g][i] * q_cart[i];
+        }
+      } else {
+        dielectric_part = get_dielectric_part(q_K, dielectric);
+      }
       exp_damp = exp(-dielectric_part / L2);
       for (i = 0; i < 3; i++) {
         for (j = 0; j < 3; j++) {
@@ -541,28 +953,46 @@ static void get_KK(double *dd_part, /* [natom, 3, natom, 3, (real,imag)] */
       }
     }
 
-    for (i = 0; i < num_patom; i++) {
-      for (j = 0; j < num_patom; j++) {
+    if (ws) {
+      G_phases = ws->G_phases + g * num_patom;
+    } else {
+      /* For D-type dynamical matrix, G_list[g] is replaced by q_K. */
+      /* For C-type dynamical matrix */
+      for (i = 0; i < num_patom; i++) {
         phase = 0;
         for (k = 0; k < 3; k++) {
-          /* For D-type dynamical matrix */
-          /* phase += (pos[i][k] - pos[j][k]) * q_K[k]; */
-          /* For C-type dynamical matrix */
-          phase += (pos[i][k] - pos[j][k]) * G_list[g][k];
+          phase += pos[i][k] * G_list[g][k];
         }
         phase *= 2 * PI;
-        cos_phase = cos(phase);
-        sin_phase = sin(phase);
-        for (k = 0; k < 3; k++) {
+        atom_phases[i][0] = cos(phase);
+        atom_phases[i][1] = sin(phase);
+      }
+      G_phases = atom_phases;
+    }
+
+    /* Rank-1 update: dd_part[i, k, j, l] += KK[k][l] * e_i * conj(e_j) */
+    for (i = 0; i < num_patom; i++) {
+      for (k = 0; k < 3; k++) {
+        for (j = 0; j < num_patom; j++) {
+          cos_phase = (G_phases[i][0] * G_phases[j][0] +
+                       G_phases[i][1] * G_phases[j][1]);
+          sin_phase = (G_phases[i][1] * G_phases[j][0] -
+                       G_phases[i][0] * G_phases[j][1]);
+          adrs = i * num_patom * 9 + k * num_patom * 3 + j * 3;
           for (l = 0; l < 3; l++) {
-            adrs = i * num_patom * 9 + k * num_patom * 3 + j * 3 + l;
-            dd_part[adrs * 2] += KK[k][l] * cos_phase;
-            dd_part[adrs * 2 + 1] += KK[k][l] * sin_phase;
+            dd_part[(adrs + l) * 2] += KK[k][l] * cos_phase;
+            dd_part[(adrs + l) * 2 + 1] += KK[k][l] * sin_phase;
           }
         }
       }
     }
   }
+
+  if (!ws) {
+    free(atom_phases);
+  }
+  atom_phases = NULL;
+  G_phases = NULL;
 }
 
 static void make_Hermitian(double *mat, const int num_band)
@@ -0,0 +1,140 @@
+/* Copyright (C) 2018 Atsushi Togo */
+/* All rights reserved. */
+
+/* This file is part of phonopy. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions */
+/* are met: */
+
+/* * Redistributions of source code must retain the above copyright */
+/*   notice, this list of conditions and the following disclaimer. */
+
+/* * Redistributions in binary form must reproduce the above copyright */
+/*   notice, this list of conditions and the following disclaimer in */
+/*   the documentation and/or other materials provided with the */
+/*   distribution. */
+
+/* * Neither the name of the phonopy project nor the names of its */
+/*   contributors may be used to endorse or promote products derived */
+/*   from this software without specific prior written permission. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS */
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT */
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS */
+/* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE */
+/* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, */
+/* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, */
+/* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; */
+/* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT */
+/* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN */
+/* ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE */
+/* POSSIBILITY OF SUCH DAMAGE. */
+
+#include <stdlib.h>
+#include <lapack_wrapper.h>
+
+/* Fortran interface of LAPACK is used since LAPACKE is not */
+/* necessarily installed along with LAPACK. */
+extern void zheev_(const char *jobz,
+                   const char *uplo,
+                   const int *n,
+                   double *a,
+                   const int *lda,
+                   double *w,
+                   double *work,
+                   const int *lwork,
+                   double *rwork,
+                   int *info);
+
+static void transpose_conjugate(double *a, const int n);
+
+int phpy_zheev(double *w,
+               double *a,
+               const int n,
+               const char uplo)
+{
+  int info, lwork;
+  double *work, *rwork;
+
+  work = NULL;
+  rwork = NULL;
+
+  lwork = phpy_get_zheev_lwork(n);
+  work = (double*)malloc(sizeof(double) * 2 * lwork);
+  rwork = (double*)malloc(sizeof(double) * (3 * n - 2 > 1 ? 3 * n - 2 : 1));
+  info = phpy_zheev_with_work(w, a, n, uplo, work, lwork, rwork);
+  free(rwork);
+  rwork = NULL;
+  free(work);
+  work = NULL;
+
+  return info;
+}
+
+int phpy_zheev_with_work(double *w,
+                         double *a,
+                         const int n,
+                         const char uplo,
+                         double *work,
+                         const int lwork,
+                         double *rwork)
+{
+  int info;
+  char jobz, uplo_f;
+
+  /* Row-major a is seen as its transpose, i.e., conj(a) by Fortran, */
+  /* therefore upper and lower are swapped. */
+  jobz = 'V';
+  if (uplo == 'L' || uplo == 'l') {
+    uplo_f = 'U';
+  } else {
+    uplo_f = 'L';
+  }
+
+  zheev_(&jobz, &uplo_f, &n, a, &n, w, work, &lwork, rwork, &info);
+
+  /* Eigenvectors of conj(a) are rows of a. Column vectors of a */
+  /* are made to be eigenvectors of a. */
+  transpose_conjugate(a, n);
+
+  return info;
+}
+
+int phpy_get_zheev_lwork(const int n)
+{
+  int info, lwork;
+  char jobz, uplo_f;
+  double a_dummy[2], w_dummy[1], rwork_dummy[1], work_query[2];
+
+  /* Only work size is queried. Matrix is not referenced. */
+  jobz = 'V';
+  uplo_f = 'U';
+  lwork = -1;
+  zheev_(&jobz, &uplo_f, &n, a_dummy, &n, w_dummy, work_query, &lwork,
+         rwork_dummy, &info);
+
+  return (int)work_query[0];
+}
+
+static void transpose_conjugate(double *a, const int n)
+{
+  int i, j, ij, ji;
+  double re, im;
+
+  for (i = 0; i < n; i++) {
+    ij = i * n + i;
+    a[ij * 2 + 1] = -a[ij * 2 + 1];
+    for (j = i + 1; j < n; j++) {
+      ij = i * n + j;
+      ji = j * n + i;
+      re = a[ij * 2];
+      im = a[ij * 2 + 1];
+      a[ij * 2] = a[ji * 2];
+      a[ij * 2 + 1] = -a[ji * 2 + 1];
+      a[ji * 2] = re;
+      a[ji * 2 + 1] = -im;
+    }
+  }
+}
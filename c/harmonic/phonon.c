@@ -0,0 +1,417 @@
+/* Copyright (C) 2018 Atsushi Togo */
+/* All rights reserved. */
+
+/* This file is part of phonopy. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions */
+/* are met: */
+
+/* * Redistributions of source code must retain the above copyright */
+/*   notice, this list of conditions and the following disclaimer. */
+
+/* * Redistributions in binary form must reproduce the above copyright */
+/*   notice, this list of conditions and the following disclaimer in */
+/*   the documentation and/or other materials provided with the */
+/*   distribution. */
+
+/* * Neither the name of the phonopy project nor the names of its */
+/*   contributors may be used to endorse or promote products derived */
+/*   from this software without specific prior written permission. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS */
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT */
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS */
+/* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE */
+/* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, */
+/* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, */
+/* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; */
+/* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT */
+/* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN */
+/* ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE */
+/* POSSIBILITY OF SUCH DAMAGE. */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dynmat.h>
+#include <derivative_dynmat.h>
+#include <lapack_wrapper.h>
+#include <phonon.h>
+
+#define PHN_ALIGNMENT 64
+
+static int get_aligned_size(const int size);
+static double * get_aligned_pointer(double *buffer);
+static int get_group_velocities_in_subspace(double (*gv)[3],
+                                            double *w,
+                                            double *work,
+                                            const double *ddm,
+                                            const double *eigvecs,
+                                            const int num_band,
+                                            const int pos,
+                                            const int num_deg,
+                                            const double perturbation[3]);
+
+/* Dynamical matrices are built and diagonalized in one loop over */
+/* q-points to avoid storing all dynamical matrices when only */
+/* frequencies are needed. Number of failed diagonalizations is returned. */
+int phn_get_phonons_at_qpoints(double *frequencies,
+                               double *eigenvectors,
+                               const double *dynamical_matrices,
+                               const int num_qpoints,
+                               PHPYCONST double (*qpoints)[3],
+                               const int num_patom,
+                               const int num_satom,
+                               const double *fc,
+                               PHPYCONST double (*svecs)[27][3],
+                               const int *multi,
+                               const double *mass,
+                               const int *s2p_map,
+                               const int *p2s_map,
+                               PHPYCONST int (*lattice_points)[3],
+                               const int num_lattice_points,
+                               PHPYCONST int (*lattice_index)[27],
+                               PHPYCONST double (*pos)[3],
+                               const int *pair_ptr,
+                               const int *pair_atoms,
+                               PHPYCONST double (*q_cart)[3],
+                               PHPYCONST double (*born)[3][3],
+                               const double *nac_factors,
+                               const double unit_conversion_factor,
+                               const char uplo)
+{
+  int i, j, num_band, num_elem, num_failed, lwork, size_a, size_work;
+  int size_rwork, size_w;
+  double *buffer, *dm, *w, *work, *rwork;
+  double (*charge_sum)[3][3];
+
+  num_band = num_patom * 3;
+  num_elem = num_band * num_band * 2;
+  num_failed = 0;
+  lwork = phpy_get_zheev_lwork(num_band);
+  size_a = get_aligned_size(num_elem);
+  size_work = get_aligned_size(lwork * 2);
+  size_rwork = get_aligned_size(num_band * 3 - 2 > 1 ? num_band * 3 - 2 : 1);
+  size_w = get_aligned_size(num_band);
+
+#pragma omp parallel private(j, buffer, dm, w, work, rwork, charge_sum) reduction(+:num_failed)
+  {
+    /* Dynamical matrix and LAPACK workspace are placed at the same */
+    /* alignment for every q-point, so that results at a q-point don't */
+    /* depend on the other q-points solved together. */
+    buffer = (double*)malloc(sizeof(double) *
+                             (size_a + size_work + size_rwork + size_w +
+                              PHN_ALIGNMENT / sizeof(double)));
+    dm = get_aligned_pointer(buffer);
+    work = dm + size_a;
+    rwork = work + size_work;
+    w = rwork + size_rwork;
+    charge_sum = NULL;
+    if (born && !dynamical_matrices) {
+      charge_sum = (double(*)[3][3])
+        malloc(sizeof(double[3][3]) * num_patom * num_patom);
+    }
+
+#pragma omp for
+    for (i = 0; i < num_qpoints; i++) {
+      if (dynamical_matrices) {
+        memcpy(dm,
+               dynamical_matrices + (long)i * num_elem,
+               sizeof(double) * num_elem);
+      } else {
+        if (charge_sum) {
+          dym_get_charge_sum(charge_sum,
+                             num_patom,
+                             nac_factors[i],
+                             q_cart[i],
+                             born);
+        }
+        dym_get_dynamical_matrix_at_q(dm,
+                                      num_patom,
+                                      num_satom,
+                                      fc,
+                                      qpoints[i],
+                                      svecs,
+                                      multi,
+                                      mass,
+                                      s2p_map,
+                                      p2s_map,
+                                      charge_sum,
+                                      lattice_points,
+                                      num_lattice_points,
+                                      lattice_index,
+                                      pos,
+                                      pair_ptr,
+                                      pair_atoms,
+                                      0);
+      }
+
+      if (phpy_zheev_with_work(w, dm, num_band, uplo, work, lwork, rwork)) {
+        num_failed++;
+      }
+
+      for (j = 0; j < num_band; j++) {
+        frequencies[(long)i * num_band + j] =
+          (w[j] < 0 ? -sqrt(-w[j]) : sqrt(w[j])) * unit_conversion_factor;
+      }
+      if (eigenvectors) {
+        memcpy(eigenvectors + (long)i * num_elem,
+               dm,
+               sizeof(double) * num_elem);
+      }
+    }
+
+    if (charge_sum) {
+      free(charge_sum);
+      charge_sum = NULL;
+    }
+    free(buffer);
+    buffer = NULL;
+    dm = NULL;
+    work = NULL;
+    rwork = NULL;
+    w = NULL;
+  }
+
+  return num_failed;
+}
+
+/* Group velocities are given by <e|dD/dq|e> / (2 omega). In a */
+/* degenerate subspace, eigenvectors are rotated to diagonalize dD/dq */
+/* along perturbation before taking expectation values. Bands whose */
+/* frequencies differ by less than degenerate_cutoff from the */
+/* neighbours are treated as degenerate, which assumes frequencies in */
+/* ascending order. Number of failed diagonalizations is returned. */
+int phn_get_group_velocities_at_qpoints(double (*gv)[3],
+                                        const double *frequencies,
+                                        const double *eigenvectors,
+                                        const int num_qpoints,
+                                        PHPYCONST double (*qpoints)[3],
+                                        const double perturbation[3],
+                                        const int num_patom,
+                                        const int num_satom,
+                                        const double *fc,
+                                        const double *lattice,
+                                        PHPYCONST double (*svecs)[27][3],
+                                        const int *multi,
+                                        const double *mass,
+                                        const int *s2p_map,
+                                        const int *p2s_map,
+                                        const double nac_factor,
+                                        const double *born,
+                                        const double *dielectric,
+                                        const int *pair_ptr,
+                                        const int *pair_atoms,
+                                        const double unit_conversion_factor,
+                                        const double cutoff_frequency,
+                                        const double degenerate_cutoff)
+{
+  int i, j, k, num_band, num_elem, num_deg, num_failed;
+  double f;
+  double *ddm, *w, *work, *nac_buffer;
+  const double *freqs;
+
+  num_band = num_patom * 3;
+  num_elem = num_band * num_band * 2;
+  num_failed = 0;
+
+#pragma omp parallel private(j, k, num_deg, f, freqs, ddm, w, work, nac_buffer) reduction(+:num_failed)
+  {
+    ddm = (double*)malloc(sizeof(double) * num_elem * 3);
+    w = (double*)malloc(sizeof(double) * num_band);
+    work = (double*)malloc(sizeof(double) * num_elem * 7);
+    nac_buffer = NULL;
+    if (born) {
+      nac_buffer = (double*)
+        malloc(sizeof(double) * num_patom * num_patom * 36);
+    }
+
+#pragma omp for
+    for (i = 0; i < num_qpoints; i++) {
+      get_derivative_dynmat_at_q_with_buffer(ddm,
+                                             num_patom,
+                                             num_satom,
+                                             fc,
+                                             qpoints[i],
+                                             lattice,
+                                             (double*)svecs,
+                                             multi,
+                                             mass,
+                                             s2p_map,
+                                             p2s_map,
+                                             nac_factor,
+                                             born,
+                                             dielectric,
+                                             NULL,
+                                             pair_ptr,
+                                             pair_atoms,
+                                             nac_buffer);
+
+      freqs = frequencies + (long)i * num_band;
+      j = 0;
+      while (j < num_band) {
+        num_deg = 1;
+        while (j + num_deg < num_band &&
+               fabs(freqs[j + num_deg] - freqs[j + num_deg - 1])
+               < degenerate_cutoff) {
+          num_deg++;
+        }
+        if (get_group_velocities_in_subspace(gv + (long)i * num_band,
+                                             w,
+                                             work,
+                                             ddm,
+                                             eigenvectors + (long)i * num_elem,
+                                             num_band,
+                                             j,
+                                             num_deg,
+                                             perturbation)) {
+          num_failed++;
+        }
+        j += num_deg;
+      }
+
+      for (j = 0; j < num_band; j++) {
+        f = freqs[j];
+        for (k = 0; k < 3; k++) {
+          if (f > cutoff_frequency) {
+            gv[(long)i * num_band + j][k] *=
+              unit_conversion_factor * unit_conversion_factor / f / 2;
+          } else {
+            gv[(long)i * num_band + j][k] = 0;
+          }
+        }
+      }
+    }
+
+    if (nac_buffer) {
+      free(nac_buffer);
+      nac_buffer = NULL;
+    }
+    free(work);
+    work = NULL;
+    free(w);
+    w = NULL;
+    free(ddm);
+    ddm = NULL;
+  }
+
+  return num_failed;
+}
+
+/* gv[pos:pos + num_deg] = Re diag(U^H E^H (dD/dq) E U) where E are */
+/* eigenvectors of the subspace and U diagonalizes E^H (dD/dq) E along */
+/* perturbation. work has to have num_band * num_band * 14 elements. */
+static int get_group_velocities_in_subspace(double (*gv)[3],
+                                            double *w,
+                                            double *work,
+                                            const double *ddm,
+                                            const double *eigvecs,
+                                            const int num_band,
+                                            const int pos,
+                                            const int num_deg,
+                                            const double perturbation[3])
+{
+  int i, j, k, l, info;
+  long adrs;
+  double re, im, er, ei;
+  double *de, *ede, *u;
+
+  de = work;                                  /* [3][num_band][num_deg] */
+  ede = de + num_band * num_band * 6;         /* [3][num_deg][num_deg] */
+  u = ede + num_band * num_band * 6;          /* [num_deg][num_deg] */
+
+  /* de = dD/dq E */
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < num_band; j++) {
+      for (k = 0; k < num_deg; k++) {
+        re = 0;
+        im = 0;
+        for (l = 0; l < num_band; l++) {
+          adrs = ((long)i * num_band * num_band + j * num_band + l) * 2;
+          er = eigvecs[(l * num_band + pos + k) * 2];
+          ei = eigvecs[(l * num_band + pos + k) * 2 + 1];
+          re += ddm[adrs] * er - ddm[adrs + 1] * ei;
+          im += ddm[adrs] * ei + ddm[adrs + 1] * er;
+        }
+        de[((i * num_band + j) * num_deg + k) * 2] = re;
+        de[((i * num_band + j) * num_deg + k) * 2 + 1] = im;
+      }
+    }
+  }
+
+  /* ede = E^H de */
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < num_deg; j++) {
+      for (k = 0; k < num_deg; k++) {
+        re = 0;
+        im = 0;
+        for (l = 0; l < num_band; l++) {
+          er = eigvecs[(l * num_band + pos + j) * 2];
+          ei = -eigvecs[(l * num_band + pos + j) * 2 + 1];
+          adrs = ((i * num_band + l) * num_deg + k) * 2;
+          re += er * de[adrs] - ei * de[adrs + 1];
+          im += er * de[adrs + 1] + ei * de[adrs];
+        }
+        ede[((i * num_deg + j) * num_deg + k) * 2] = re;
+        ede[((i * num_deg + j) * num_deg + k) * 2 + 1] = im;
+      }
+    }
+  }
+
+  if (num_deg == 1) {
+    for (i = 0; i < 3; i++) {
+      gv[pos][i] = ede[i * 2];
+    }
+    return 0;
+  }
+
+  for (i = 0; i < num_deg * num_deg * 2; i++) {
+    u[i] = 0;
+    for (j = 0; j < 3; j++) {
+      u[i] += perturbation[j] * ede[j * num_deg * num_deg * 2 + i];
+    }
+  }
+  info = phpy_zheev(w, u, num_deg, 'L');
+
+  /* gv = Re diag(U^H ede U) */
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < num_deg; j++) {
+      re = 0;
+      for (k = 0; k < num_deg; k++) {
+        for (l = 0; l < num_deg; l++) {
+          adrs = ((i * num_deg + k) * num_deg + l) * 2;
+          /* conj(u[k][j]) * ede[k][l] * u[l][j] */
+          er = (u[(k * num_deg + j) * 2] * ede[adrs] +
+                u[(k * num_deg + j) * 2 + 1] * ede[adrs + 1]);
+          ei = (u[(k * num_deg + j) * 2] * ede[adrs + 1] -
+                u[(k * num_deg + j) * 2 + 1] * ede[adrs]);
+          re += (er * u[(l * num_deg + j) * 2] -
+                 ei * u[(l * num_deg + j) * 2 + 1]);
+        }
+      }
+      gv[pos + j][i] = re;
+    }
+  }
+
+  return info;
+}
+
+/* Number of doubles rounded up to multiple of PHN_ALIGNMENT bytes */
+static int get_aligned_size(const int size)
+{
+  int n;
+
+  n = PHN_ALIGNMENT / sizeof(double);
+  return ((size + n - 1) / n) * n;
+}
+
+static double * get_aligned_pointer(double *buffer)
+{
+  size_t adrs;
+
+  adrs = (size_t)buffer;
+  adrs = (adrs + PHN_ALIGNMENT - 1) / PHN_ALIGNMENT * PHN_ALIGNMENT;
+  return (double*)adrs;
+}
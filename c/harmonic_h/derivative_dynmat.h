@@ -49,6 +49,44 @@ void get_derivative_dynmat_at_q(double *derivative_dynmat,
                                 const double nac_factor,
                                 const double *born,
                                 const double *dielectric,
-                                const double *q_direction);
+                                const double *q_direction,
+                                const int *pair_ptr,
+                                const int *pair_atoms);
+void get_derivative_dynmats_at_qpoints(double *derivative_dynmats,
+                                       const int num_qpoints,
+                                       const double *qpoints,
+                                       const int num_patom,
+                                       const int num_satom,
+                                       const double *fc,
+                                       const double *lattice,
+                                       const double *r,
+                                       const int *multi,
+                                       const double *mass,
+                                       const int *s2p_map,
+                                       const int *p2s_map,
+                                       const double nac_factor,
+                                       const double *born,
+                                       const double *dielectric,
+                                       const double *q_direction,
+                                       const int *pair_ptr,
+                                       const int *pair_atoms);
+void get_derivative_dynmat_at_q_with_buffer(double *derivative_dynmat,
+                                            const int num_patom,
+                                            const int num_satom,
+                                            const double *fc,
+                                            const double *q,
+                                            const double *lattice,
+                                            const double *r,
+                                            const int *multi,
+                                            const double *mass,
+                                            const int *s2p_map,
+                                            const int *p2s_map,
+                                            const double nac_factor,
+                                            const double *born,
+                                            const double *dielectric,
+                                            const double *q_direction,
+                                            const int *pair_ptr,
+                                            const int *pair_atoms,
+                                            double *nac_buffer);
 
 #endif
@@ -37,6 +37,16 @@
 
 #define PHPYCONST
 
+/* Workspace of dipole-dipole interaction (Gonze-NAC) kept alive */
+/* across q-points. G-only parts of the G-space sum are stored. */
+typedef struct {
+  double *dd_tmp; /* [natom, 3, natom, 3, (real,imag)] */
+  double (*G_phases)[2]; /* [num_G, natom], exp(2pi i G.r_i) */
+  double (*eps_G)[3]; /* [num_G, 3], (eps + eps^T).G */
+  double *G_eps_G; /* [num_G], G.eps.G */
+  double *G_norm2; /* [num_G], |G|^2 */
+} DipoleDipoleWorkspace;
+
 int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                                   const int num_patom,
                                   const int num_satom,
@@ -48,7 +58,33 @@ int dym_get_dynamical_matrix_at_q(double *dynamical_matrix,
                                   const int *s2p_map,
                                   const int *p2s_map,
                                   PHPYCONST double (*charge_sum)[3][3],
+                                  PHPYCONST int (*lattice_points)[3],
+                                  const int num_lattice_points,
+                                  PHPYCONST int (*lattice_index)[27],
+                                  PHPYCONST double (*pos)[3],
+                                  const int *pair_ptr,
+                                  const int *pair_atoms,
                                   const int with_openmp);
+int dym_get_dynamical_matrices_at_qpoints(double *dynamical_matrices,
+                                          const int num_qpoints,
+                                          PHPYCONST double (*qpoints)[3],
+                                          const int num_patom,
+                                          const int num_satom,
+                                          const double *fc,
+                                          PHPYCONST double (*svecs)[27][3],
+                                          const int *multi,
+                                          const double *mass,
+                                          const int *s2p_map,
+                                          const int *p2s_map,
+                                          PHPYCONST int (*lattice_points)[3],
+                                          const int num_lattice_points,
+                                          PHPYCONST int (*lattice_index)[27],
+                                          PHPYCONST double (*pos)[3],
+                                          const int *pair_ptr,
+                                          const int *pair_atoms,
+                                          PHPYCONST double (*q_cart)[3],
+                                          PHPYCONST double (*born)[3][3],
+                                          const double *nac_factors);
 void dym_get_dipole_dipole(double *dd, /* [natom, 3, natom, 3, (real,imag)] */
                            const double *dd_q0, /* [natom, 3, 3, (real,imag)] */
                            PHPYCONST double (*G_list)[3], /* [num_G, 3] */
@@ -61,7 +97,14 @@ void dym_get_dipole_dipole(double *dd, /* [natom, 3, natom, 3, (real,imag)] */
                            PHPYCONST double (*pos)[3], /* [num_patom, 3] */
                            const double factor, /* 4pi/V*unit-conv */
                            const double lambda,
-                           const double tolerance);
+                           const double tolerance,
+                           DipoleDipoleWorkspace *ws); /* NULL is allowed */
+void dym_set_dipole_dipole_workspace(DipoleDipoleWorkspace *ws,
+                                     PHPYCONST double (*G_list)[3], /* [num_G, 3] */
+                                     const int num_G,
+                                     const int num_patom,
+                                     PHPYCONST double dielectric[3][3],
+                                     PHPYCONST double (*pos)[3]); /* [natom, 3] */
 void dym_get_dipole_dipole_q0(double *dd_q0, /* [natom, 3, 3, (real,imag)] */
                               PHPYCONST double (*G_list)[3], /* [num_G, 3] */
                               const int num_G,
@@ -81,6 +124,8 @@ void dym_get_charge_sum(double (*charge_sum)[3][3],
 /* comm_points[num_satom, num_patom, 27, 3] */
 /* shortest_vectors[num_satom, num_patom, 27, 3] */
 /* multiplicities[num_satom, num_patom] */
+/* lattice_points, lattice_index and pos as dym_get_dynamical_matrix_at_q */
+/* lattice_points can be NULL. */
 void dym_transform_dynmat_to_fc(double *fc,
                                 const double *dm,
                                 PHPYCONST double (*comm_points)[3],
@@ -88,6 +133,10 @@ void dym_transform_dynmat_to_fc(double *fc,
                                 const int *multiplicities,
                                 const double *masses,
                                 const int *s2pp_map,
+                                PHPYCONST int (*lattice_points)[3],
+                                const int num_lattice_points,
+                                PHPYCONST int (*lattice_index)[27],
+                                PHPYCONST double (*pos)[3],
                                 const int num_patom,
                                 const int num_satom);
 
@@ -0,0 +1,57 @@
+/* Copyright (C) 2018 Atsushi Togo */
+/* All rights reserved. */
+
+/* This file is part of phonopy. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions */
+/* are met: */
+
+/* * Redistributions of source code must retain the above copyright */
+/*   notice, this list of conditions and the following disclaimer. */
+
+/* * Redistributions in binary form must reproduce the above copyright */
+/*   notice, this list of conditions and the following disclaimer in */
+/*   the documentation and/or other materials provided with the */
+/*   distribution. */
+
+/* * Neither the name of the phonopy project nor the names of its */
+/*   contributors may be used to endorse or promote products derived */
+/*   from this software without specific prior written permission. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS */
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT */
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS */
+/* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE */
+/* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, */
+/* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, */
+/* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; */
+/* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT */
+/* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN */
+/* ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE */
+/* POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef __lapack_wrapper_H__
+#define __lapack_wrapper_H__
+
+/* Diagonalize Hermitian matrix a[n, n, (real,imag)] in row-major. */
+/* Eigenvalues are stored in w[n] in ascending order and */
+/* eigenvectors overwrite a as column vectors, i.e., same as */
+/* numpy.linalg.eigh. Info of LAPACK zheev is returned. */
+int phpy_zheev(double *w,
+               double *a,
+               const int n,
+               const char uplo);
+/* Same as phpy_zheev with work[2 * lwork] and rwork[max(1, 3n - 2)] */
+/* given by caller, where lwork is obtained by phpy_get_zheev_lwork. */
+int phpy_zheev_with_work(double *w,
+                         double *a,
+                         const int n,
+                         const char uplo,
+                         double *work,
+                         const int lwork,
+                         double *rwork);
+int phpy_get_zheev_lwork(const int n);
+
+#endif
@@ -0,0 +1,98 @@
+/* Copyright (C) 2018 Atsushi Togo */
+/* All rights reserved. */
+
+/* This file is part of phonopy. */
+
+/* Redistribution and use in source and binary forms, with or without */
+/* modification, are permitted provided that the following conditions */
+/* are met: */
+
+/* * Redistributions of source code must retain the above copyright */
+/*   notice, this list of conditions and the following disclaimer. */
+
+/* * Redistributions in binary form must reproduce the above copyright */
+/*   notice, this list of conditions and the following disclaimer in */
+/*   the documentation and/or other materials provided with the */
+/*   distribution. */
+
+/* * Neither the name of the phonopy project nor the names of its */
+/*   contributors may be used to endorse or promote products derived */
+/*   from this software without specific prior written permission. */
+
+/* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS */
+/* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT */
+/* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS */
+/* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE */
+/* COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, */
+/* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, */
+/* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; */
+/* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER */
+/* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT */
+/* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN */
+/* ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE */
+/* POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef __phonon_H__
+#define __phonon_H__
+
+#include <dynmat.h>
+
+/* frequencies[num_qpoints, num_band] */
+/* eigenvectors[num_qpoints, num_band, num_band, (real,imag)] */
+/* or NULL when eigenvectors are unnecessary. */
+/* When dynamical_matrices are given, those are diagonalized and */
+/* arguments to build dynamical matrices are unused. */
+int phn_get_phonons_at_qpoints(double *frequencies,
+                               double *eigenvectors,
+                               const double *dynamical_matrices,
+                               const int num_qpoints,
+                               PHPYCONST double (*qpoints)[3],
+                               const int num_patom,
+                               const int num_satom,
+                               const double *fc,
+                               PHPYCONST double (*svecs)[27][3],
+                               const int *multi,
+                               const double *mass,
+                               const int *s2p_map,
+                               const int *p2s_map,
+                               PHPYCONST int (*lattice_points)[3],
+                               const int num_lattice_points,
+                               PHPYCONST int (*lattice_index)[27],
+                               PHPYCONST double (*pos)[3],
+                               const int *pair_ptr,
+                               const int *pair_atoms,
+                               PHPYCONST double (*q_cart)[3],
+                               PHPYCONST double (*born)[3][3],
+                               const double *nac_factors,
+                               const double unit_conversion_factor,
+                               const char uplo);
+
+/* gv[num_qpoints, num_band, 3] from frequencies[num_qpoints, num_band] */
+/* and eigenvectors[num_qpoints, num_band, num_band, (real,imag)] that */
+/* are obtained by phn_get_phonons_at_qpoints. perturbation is a */
+/* normalized Cartesian direction used to resolve degeneracy. */
+int phn_get_group_velocities_at_qpoints(double (*gv)[3],
+                                        const double *frequencies,
+                                        const double *eigenvectors,
+                                        const int num_qpoints,
+                                        PHPYCONST double (*qpoints)[3],
+                                        const double perturbation[3],
+                                        const int num_patom,
+                                        const int num_satom,
+                                        const double *fc,
+                                        const double *lattice,
+                                        PHPYCONST double (*svecs)[27][3],
+                                        const int *multi,
+                                        const double *mass,
+                                        const int *s2p_map,
+                                        const int *p2s_map,
+                                        const double nac_factor,
+                                        const double *born,
+                                        const double *dielectric,
+                                        const int *pair_ptr,
+                                        const int *pair_atoms,
+                                        const double unit_conversion_factor,
+                                        const double cutoff_frequency,
+                                        const double degenerate_cutoff);
+
+#endif
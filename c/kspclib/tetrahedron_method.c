@@ -198,6 +198,18 @@ get_integration_weight(const double omega,
 				    const int,
 				    const double,
 				    const double[4]));
+static void
+get_integration_weight_sweep(double *integration_weights,
+			     const int num_omegas,
+			     const double *omegas,
+			     THMCONST double tetrahedra_omegas[24][4],
+			     double (*gn)(const int,
+					  const double,
+					  const double[4]),
+			     double (*IJ)(const int,
+					  const int,
+					  const double,
+					  const double[4]));
 static int get_main_diagonal(THMCONST double rec_lattice[3][3]);
 static int sort_omegas(double v[4]);
 static double norm_squared_d3(const double a[3]);
@@ -362,6 +374,33 @@ thm_get_integration_weight_at_omegas(double *integration_weights,
   }
 }
 
+/* Vertices of each tetrahedron are sorted only once and omegas are */
+/* swept through the case intervals. Omegas in ascending order are the */
+/* cheapest, but any order gives the same weights as */
+/* thm_get_integration_weight_at_omegas. Not parallelized, so that */
+/* this can be called inside a loop over grid points and bands. */
+void
+thm_get_integration_weight_sweep(double *integration_weights,
+				 const int num_omegas,
+				 const double *omegas,
+				 THMCONST double tetrahedra_omegas[24][4],
+				 const char function)
+{
+  if (function == 'I') {
+    get_integration_weight_sweep(integration_weights,
+				 num_omegas,
+				 omegas,
+				 tetrahedra_omegas,
+				 _g, _I);
+  } else {
+    get_integration_weight_sweep(integration_weights,
+				 num_omegas,
+				 omegas,
+				 tetrahedra_omegas,
+				 _n, _J);
+  }
+}
+
 void thm_get_neighboring_grid_points(int neighboring_grid_points[],
 				     const int grid_point,
 				     THMCONST int relative_grid_address[][3],
@@ -459,6 +498,55 @@ get_integration_weight(const double omega,
   return sum / 6;
 }
 
+static void
+get_integration_weight_sweep(double *integration_weights,
+			     const int num_omegas,
+			     const double *omegas,
+			     THMCONST double tetrahedra_omegas[24][4],
+			     double (*gn)(const int,
+					  const double,
+					  const double[4]),
+			     double (*IJ)(const int,
+					  const int,
+					  const double,
+					  const double[4]))
+{
+  int i, j, k, ci;
+  double omega;
+  double v[4];
+
+  for (i = 0; i < num_omegas; i++) {
+    integration_weights[i] = 0;
+  }
+
+  for (i = 0; i < 24; i++) {
+    for (j = 0; j < 4; j++) {
+      v[j] = tetrahedra_omegas[i][j];
+    }
+    ci = sort_omegas(v);
+    /* k is the number of vertices below omega, i.e., the case index. */
+    k = 0;
+    for (j = 0; j < num_omegas; j++) {
+      omega = omegas[j];
+      while (k > 0 && !(v[k - 1] < omega)) {
+	k--;
+      }
+      while (k < 4 && v[k] < omega) {
+	k++;
+      }
+      /* omega on a vertex does not contribute. */
+      if (k < 4 && !(omega < v[k])) {
+	continue;
+      }
+      integration_weights[j] += IJ(k, ci, omega, v) * gn(k, omega, v);
+    }
+  }
+
+  for (i = 0; i < num_omegas; i++) {
+    integration_weights[i] /= 6;
+  }
+}
+
 static int sort_omegas(double v[4])
 {
   int i;
@@ -51,6 +51,12 @@ thm_get_integration_weight_at_omegas(double *integration_weights,
 				     const double *omegas,
 				     THMCONST double tetrahedra_omegas[24][4],
 				     const char function);
+void
+thm_get_integration_weight_sweep(double *integration_weights,
+				 const int num_omegas,
+				 const double *omegas,
+				 THMCONST double tetrahedra_omegas[24][4],
+				 const char function);
 void thm_get_neighboring_grid_points(int neighboring_grid_points[],
 				     const int grid_point,
 				     THMCONST int relative_grid_address[][3],
@@ -113,6 +113,79 @@ found:
   return container;
 }
 
+/* Same as det_determine_all but the primitive lattice and the Hall */
+/* number expected in advance are tried. prim_lattice can be NULL and */
+/* hall_number can be 0 when they are unknown. Unlike */
+/* det_determine_all, hall_number is not imposed; the full search is */
+/* made when the space group is not of hall_number. NULL is returned */
+/* if failed with the given tolerance. */
+DataContainer * det_determine_all_with_hint(const Cell * cell,
+                                            SPGCONST double prim_lattice[3][3],
+                                            const int hall_number,
+                                            const double symprec,
+                                            const double angle_tolerance)
+{
+  DataContainer *container;
+
+  container = NULL;
+
+  if (hall_number < 0 || hall_number > 530) {
+    return NULL;
+  }
+
+  if ((container = (DataContainer*) malloc(sizeof(DataContainer))) == NULL) {
+    warning_print("spglib: Memory could not be allocated.");
+    return NULL;
+  }
+
+  container->primitive = NULL;
+  container->spacegroup = NULL;
+  container->exact_structure = NULL;
+
+  if ((container->spacegroup = (Spacegroup*) malloc(sizeof(Spacegroup)))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated.");
+    goto err;
+  }
+
+  if (prim_lattice == NULL) {
+    container->primitive = prm_get_primitive(cell, symprec, angle_tolerance);
+  } else {
+    container->primitive = prm_get_primitive_with_lattice(cell,
+                                                          prim_lattice,
+                                                          symprec,
+                                                          angle_tolerance);
+  }
+  if (container->primitive == NULL) {
+    goto err;
+  }
+
+  *(container->spacegroup) = spa_search_spacegroup_with_hint(
+    container->primitive->cell,
+    hall_number,
+    container->primitive->tolerance,
+    container->primitive->angle_tolerance);
+  if (container->spacegroup->number == 0) {
+    goto err;
+  }
+
+  if ((container->exact_structure = ref_get_exact_structure_and_symmetry(
+         container->primitive->cell,
+         cell,
+         container->spacegroup,
+         container->primitive->mapping_table,
+         container->primitive->tolerance)) == NULL) {
+    goto err;
+  }
+
+  return container;
+
+ err:
+  det_free_container(container);
+  container = NULL;
+  return NULL;
+}
+
 /* NULL is returned if failed */
 static int get_spacegroup_and_primitive(DataContainer * container,
                                         const Cell * cell,
@@ -203,6 +203,19 @@ static int relocate_BZ_grid_address(int bz_grid_address[][3],
 				    const int mesh[3],
 				    SPGCONST double rec_lattice[3][3],
 				    const int is_shift[3]);
+static int get_BZ_distances(double distance[KPT_NUM_BZ_SEARCH_SPACE],
+			    const int address[3],
+			    const int mesh[3],
+			    SPGCONST double rec_lattice[3][3],
+			    const int is_shift[3]);
+static void set_BZ_grid_address(int bz_grid_address[][3],
+				int bz_map[],
+				const int gp,
+				const int address[3],
+				const int search_index,
+				const int mesh[3],
+				const int bzmesh[3],
+				const int is_shift[3]);
 static double get_tolerance_for_BZ_reduction(SPGCONST double rec_lattice[3][3],
 					     const int mesh[3]);
 static int check_mesh_symmetry(const int mesh[3],
@@ -640,6 +653,10 @@ static int get_num_ir(int ir_mapping_table[], const int mesh[3])
 /* Relocate grid addresses to first Brillouin zone */
 /* bz_grid_address[prod(mesh + 1)][3] */
 /* bz_map[prod(mesh * 2)] */
+/* Grid points on BZ boundary are stored after the first prod(mesh) */
+/* points in the order of grid points. Their positions are given by */
+/* prefix sum of the numbers of equivalent points counted in the */
+/* first pass, which makes the result independent of threads. */
 static int relocate_BZ_grid_address(int bz_grid_address[][3],
 				    int bz_map[],
 				    SPGCONST int grid_address[][3],
@@ -648,67 +665,163 @@ static int relocate_BZ_grid_address(int bz_grid_address[][3],
 				    const int is_shift[3])
 {
   double tolerance, min_distance;
-  double q_vector[3], distance[KPT_NUM_BZ_SEARCH_SPACE];
-  int bzmesh[3], bz_address_double[3];
-  int i, j, k, min_index, boundary_num_gp, total_num_gp, bzgp, gp;
+  double distance[KPT_NUM_BZ_SEARCH_SPACE];
+  int bzmesh[3];
+  int i, j, min_index, num_bzmesh, boundary_num_gp, total_num_gp, gp;
+  int *num_boundary;
+
+  num_boundary = NULL;
 
   tolerance = get_tolerance_for_BZ_reduction(rec_lattice, mesh);
   for (i = 0; i < 3; i++) {
     bzmesh[i] = mesh[i] * 2;
   }
-  for (i = 0; i < bzmesh[0] * bzmesh[1] * bzmesh[2]; i++) {
+  num_bzmesh = bzmesh[0] * bzmesh[1] * bzmesh[2];
+  total_num_gp = mesh[0] * mesh[1] * mesh[2];
+
+  if ((num_boundary = (int*)malloc(sizeof(int) * total_num_gp)) == NULL) {
+    warning_print("spglib: Memory could not be allocated.");
+    return 0;
+  }
+
+#pragma omp parallel for
+  for (i = 0; i < num_bzmesh; i++) {
     bz_map[i] = -1;
   }
-  
-  boundary_num_gp = 0;
-  total_num_gp = mesh[0] * mesh[1] * mesh[2];
 
-  /* Multithreading doesn't work for this loop since gp calculated */
-  /* with boundary_num_gp is unstable to store bz_grid_address. */
+  /* Shortest ones are stored at their grid points. Grid points of */
+  /* different grid addresses never meet in bz_map. */
+#pragma omp parallel for private(j, min_index, min_distance, distance)
   for (i = 0; i < total_num_gp; i++) {
+    min_index = get_BZ_distances(distance,
+				 grid_address[i],
+				 mesh,
+				 rec_lattice,
+				 is_shift);
+    min_distance = distance[min_index];
+    num_boundary[i] = 0;
     for (j = 0; j < KPT_NUM_BZ_SEARCH_SPACE; j++) {
-      for (k = 0; k < 3; k++) {
-	q_vector[k] = 
-	  ((grid_address[i][k] + bz_search_space[j][k] * mesh[k]) * 2 +
-	   is_shift[k]) / ((double)mesh[k]) / 2;
-      }
-      mat_multiply_matrix_vector_d3(q_vector, rec_lattice, q_vector);
-      distance[j] = mat_norm_squared_d3(q_vector);
-    }
-    min_distance = distance[0];
-    min_index = 0;
-    for (j = 1; j < KPT_NUM_BZ_SEARCH_SPACE; j++) {
-      if (distance[j] < min_distance) {
-	min_distance = distance[j];
-	min_index = j;
+      if (distance[j] < min_distance + tolerance && j != min_index) {
+	num_boundary[i]++;
       }
     }
+    set_BZ_grid_address(bz_grid_address,
+			bz_map,
+			i,
+			grid_address[i],
+			min_index,
+			mesh,
+			bzmesh,
+			is_shift);
+  }
+
+  /* Prefix sum */
+  boundary_num_gp = 0;
+  for (i = 0; i < total_num_gp; i++) {
+    j = num_boundary[i];
+    num_boundary[i] = boundary_num_gp;
+    boundary_num_gp += j;
+  }
 
+  /* For grid points on BZ boundary, all equivalent points are written */
+  /* in the order of search space so that the last one wins in bz_map */
+  /* as in a serial loop. */
+#pragma omp parallel for private(j, gp, min_index, min_distance, distance)
+  for (i = 0; i < total_num_gp; i++) {
+    if ((i + 1 < total_num_gp ?
+	 num_boundary[i + 1] : boundary_num_gp) == num_boundary[i]) {
+      continue;
+    }
+    min_index = get_BZ_distances(distance,
+				 grid_address[i],
+				 mesh,
+				 rec_lattice,
+				 is_shift);
+    min_distance = distance[min_index];
+    gp = num_boundary[i] + total_num_gp;
     for (j = 0; j < KPT_NUM_BZ_SEARCH_SPACE; j++) {
       if (distance[j] < min_distance + tolerance) {
 	if (j == min_index) {
-	  gp = i;
+	  set_BZ_grid_address(bz_grid_address,
+			      bz_map,
+			      i,
+			      grid_address[i],
+			      j,
+			      mesh,
+			      bzmesh,
+			      is_shift);
 	} else {
-	  gp = boundary_num_gp + total_num_gp;
-	}
-	
-	for (k = 0; k < 3; k++) {
-	  bz_grid_address[gp][k] = 
-	    grid_address[i][k] + bz_search_space[j][k] * mesh[k];
-	  bz_address_double[k] = bz_grid_address[gp][k] * 2 + is_shift[k];
-	}
-	bzgp = kgd_get_grid_point_double_mesh(bz_address_double, bzmesh);
-	bz_map[bzgp] = gp;
-	if (j != min_index) {
-	  boundary_num_gp++;
+	  set_BZ_grid_address(bz_grid_address,
+			      bz_map,
+			      gp,
+			      grid_address[i],
+			      j,
+			      mesh,
+			      bzmesh,
+			      is_shift);
+	  gp++;
 	}
       }
     }
   }
 
+  free(num_boundary);
+  num_boundary = NULL;
+
   return boundary_num_gp + total_num_gp;
 }
 
+/* Squared lengths of q-vectors translated by bz_search_space */
+/* Return the index of the shortest one. */
+static int get_BZ_distances(double distance[KPT_NUM_BZ_SEARCH_SPACE],
+			    const int address[3],
+			    const int mesh[3],
+			    SPGCONST double rec_lattice[3][3],
+			    const int is_shift[3])
+{
+  int i, j, min_index;
+  double q_vector[3];
+
+  for (i = 0; i < KPT_NUM_BZ_SEARCH_SPACE; i++) {
+    for (j = 0; j < 3; j++) {
+      q_vector[j] =
+	((address[j] + bz_search_space[i][j] * mesh[j]) * 2 +
+	 is_shift[j]) / ((double)mesh[j]) / 2;
+    }
+    mat_multiply_matrix_vector_d3(q_vector, rec_lattice, q_vector);
+    distance[i] = mat_norm_squared_d3(q_vector);
+  }
+
+  min_index = 0;
+  for (i = 1; i < KPT_NUM_BZ_SEARCH_SPACE; i++) {
+    if (distance[i] < distance[min_index]) {
+      min_index = i;
+    }
+  }
+
+  return min_index;
+}
+
+static void set_BZ_grid_address(int bz_grid_address[][3],
+				int bz_map[],
+				const int gp,
+				const int address[3],
+				const int search_index,
+				const int mesh[3],
+				const int bzmesh[3],
+				const int is_shift[3])
+{
+  int i;
+  int bz_address_double[3];
+
+  for (i = 0; i < 3; i++) {
+    bz_grid_address[gp][i] =
+      address[i] + bz_search_space[search_index][i] * mesh[i];
+    bz_address_double[i] = bz_grid_address[gp][i] * 2 + is_shift[i];
+  }
+  bz_map[kgd_get_grid_point_double_mesh(bz_address_double, bzmesh)] = gp;
+}
+
 static double get_tolerance_for_BZ_reduction(SPGCONST double rec_lattice[3][3],
 					     const int mesh[3])
 {
@@ -76,10 +76,22 @@ static int perm_argsort(int *perm,
                         void *provided_work,
                         const int n);
 
-static int check_possible_overlap(OverlapChecker *checker,
-                                  const double test_trans[3],
-                                  SPGCONST int rot[3][3],
-                                  const double symprec);
+static int build_hash(OverlapChecker *checker, const double symprec);
+
+static int get_type_rank(const OverlapChecker *checker, const int type);
+
+static int find_overlap_in_hash(const OverlapChecker *checker,
+                                int * found,
+                                const double pos[3],
+                                const int type,
+                                const double symprec);
+
+static int check_total_overlap(const OverlapChecker *checker,
+                               int * found,
+                               const double test_trans[3],
+                               int rot[3][3],
+                               const double symprec,
+                               const int is_identity);
 
 static int argsort_by_lattice_point_distance(int * perm,
                                              SPGCONST double lattice[3][3],
@@ -91,14 +103,6 @@ static int argsort_by_lattice_point_distance(int * perm,
 
 static OverlapChecker* overlap_checker_alloc(int size);
 
-static int check_total_overlap_for_sorted(SPGCONST double lattice[3][3],
-                                          SPGCONST double (*pos_original)[3],
-                                          SPGCONST double (*pos_rotated)[3],
-                                          const int types_original[],
-                                          const int types_rotated[],
-                                          const int num_pos,
-                                          const double symprec);
-
 /* ------------------------------------- */
 /*          arg-sorting                  */
 
@@ -121,12 +125,21 @@ void ovl_overlap_checker_free(OverlapChecker *checker)
       free(checker->blob);
       checker->blob = NULL;
     }
+    if (checker->hash_start != NULL) {
+      free(checker->hash_start);
+      checker->hash_start = NULL;
+    }
+    if (checker->hash_atoms != NULL) {
+      free(checker->hash_atoms);
+      checker->hash_atoms = NULL;
+    }
     free(checker);
   }
 }
 
 OverlapChecker* ovl_overlap_checker_init(const Cell *cell)
 {
+  int i;
   OverlapChecker * checker;
   checker = NULL;
 
@@ -161,12 +174,23 @@ OverlapChecker* ovl_overlap_checker_init(const Cell *cell)
               checker->perm_temp,
               cell->size);
 
+  /* Types are sorted in ascending order. */
+  checker->num_types = 0;
+  for (i = 0; i < cell->size; i++) {
+    if (i == 0 || checker->types_sorted[i] != checker->types_sorted[i - 1]) {
+      checker->distinct_types[checker->num_types] = checker->types_sorted[i];
+      checker->num_types++;
+    }
+  }
+
   return checker;
 }
 
 /* Uses a OverlapChecker to efficiently--but thoroughly--confirm that a given symmetry operator */
 /* is a symmetry of the cell. If you need to test many symmetry operators on the same cell, */
 /* you can create one OverlapChecker from the Cell and call this function many times. */
+/* Each transformed position is looked up in the cell list of the original positions, */
+/* so the check costs O(size) and stops at the first position not found. */
 /* -1: Error.  0:  Not a symmetry.   1. Is a symmetry. */
 int ovl_check_total_overlap(OverlapChecker *checker,
                             const double test_trans[3],
@@ -174,65 +198,92 @@ int ovl_check_total_overlap(OverlapChecker *checker,
                             const double symprec,
                             const int is_identity)
 {
-  int i, k, check;
-
-  /* Check a few atoms by brute force before continuing. */
-  /* For bad translations, this can be much cheaper than sorting. */
-  if (!check_possible_overlap(checker,
-                              test_trans,
-                              rot,
-                              symprec)) {
-    return 0;
+  if (!ovl_overlap_checker_set_symprec(checker, symprec)) {
+    return -1;
+  }
+
+  return check_total_overlap(checker,
+                             checker->found_temp,
+                             test_trans,
+                             rot,
+                             symprec,
+                             is_identity);
+}
+
+/* Builds the cell list for symprec unless it is already built. */
+/* Returns 0 on failure. */
+int ovl_overlap_checker_set_symprec(OverlapChecker *checker,
+                                    const double symprec)
+{
+  if (checker->hash_start == NULL || checker->hash_symprec != symprec) {
+    return build_hash(checker, symprec);
+  }
+  return 1;
+}
+
+/* Same as ovl_check_total_overlap but checker is only read, so that */
+/* it can be shared among threads. found_work has to have checker->size */
+/* elements and be owned by the calling thread. The cell list has to be */
+/* built for symprec in advance by ovl_overlap_checker_set_symprec. */
+/* -1: Error.  0:  Not a symmetry.   1. Is a symmetry. */
+int ovl_check_total_overlap_with_work(const OverlapChecker *checker,
+                                      int * found_work,
+                                      const double test_trans[3],
+                                      int rot[3][3],
+                                      const double symprec,
+                                      const int is_identity)
+{
+  if (checker->hash_start == NULL || checker->hash_symprec != symprec) {
+    return -1;
+  }
+
+  return check_total_overlap(checker,
+                             found_work,
+                             test_trans,
+                             rot,
+                             symprec,
+                             is_identity);
+}
+
+static int check_total_overlap(const OverlapChecker *checker,
+                               int * found,
+                               const double test_trans[3],
+                               int rot[3][3],
+                               const double symprec,
+                               const int is_identity)
+{
+  int i, k;
+  double pos[3];
+
+  for (i = 0; i < checker->size; i++) {
+    found[i] = 0;
   }
 
-  /* Write rotated positions to 'pos_temp_1' */
   for (i = 0; i < checker->size; i++) {
     if (is_identity) {
       for (k = 0; k < 3; k++) {
-        checker->pos_temp_1[i][k] = checker->pos_sorted[i][k];
+        pos[k] = checker->pos_sorted[i][k];
       }
     } else {
-      mat_multiply_matrix_vector_id3(checker->pos_temp_1[i],
-                                     rot,
-                                     checker->pos_sorted[i]);
+      mat_multiply_matrix_vector_id3(pos, rot, checker->pos_sorted[i]);
     }
 
     for (k = 0; k < 3; k++) {
-      checker->pos_temp_1[i][k] += test_trans[k];
+      pos[k] += test_trans[k];
     }
-  }
 
-  /* Get permutation that sorts these positions. */
-  if (!argsort_by_lattice_point_distance(checker->perm_temp,
-                                         checker->lattice,
-                                         checker->pos_temp_1,
-                                         checker->types_sorted,
-                                         checker->distance_temp,
-                                         checker->argsort_work,
-                                         checker->size)) {
-    return -1;
-  }
-
-  /* Use the permutation to sort them. Write to 'pos_temp_2'. */
-  permute_double_3(checker->pos_temp_2,
-                   checker->pos_temp_1,
-                   checker->perm_temp,
-                   checker->size);
-
-  /* Do optimized check for overlap between sorted coordinates. */
-  check = check_total_overlap_for_sorted(checker->lattice,
-                                         checker->pos_sorted, /* pos_original */
-                                         checker->pos_temp_2, /* pos_rotated */
-                                         checker->types_sorted, /* types_original */
-                                         checker->types_sorted, /* types_original */
-                                         checker->size,
-                                         symprec);
-  if (check == -1) {
-    /* Error! */
-    return -1;
+    /* Failure; the transformed position is not in the structure. */
+    if (find_overlap_in_hash(checker,
+                             found,
+                             pos,
+                             checker->types_sorted[i],
+                             symprec) < 0) {
+      return 0;
+    }
   }
 
-  return check;
+  /* Success */
+  return 1;
 }
 
 static int ValueWithIndex_comparator(const void *pa, const void *pb)
@@ -354,8 +405,9 @@ static void permute_double_3(double (*data_out)[3],
 
 static OverlapChecker* overlap_checker_alloc(int size)
 {
-  int offset_pos_temp_1, offset_pos_temp_2, offset_distance_temp;
+  int offset_distance_temp, offset_found_temp;
   int offset_perm_temp, offset_pos_sorted, offset_types_sorted, offset_lattice;
+  int offset_distinct_types;
   int offset, blob_size;
   char * chr_blob;
   OverlapChecker * checker;
@@ -366,13 +418,13 @@ static OverlapChecker* overlap_checker_alloc(int size)
   /* checker->blob is going to contain lots of things. */
   /* Compute its total size and the number of bytes before each thing. */
   offset = 0;
-  offset_pos_temp_1 = SPG_POST_INCREMENT(offset, size * sizeof(double[3]));
-  offset_pos_temp_2 = SPG_POST_INCREMENT(offset, size * sizeof(double[3]));
   offset_distance_temp = SPG_POST_INCREMENT(offset, size * sizeof(double));
   offset_perm_temp = SPG_POST_INCREMENT(offset, size * sizeof(int));
+  offset_found_temp = SPG_POST_INCREMENT(offset, size * sizeof(int));
   offset_lattice = SPG_POST_INCREMENT(offset, 9 * sizeof(double));
   offset_pos_sorted = SPG_POST_INCREMENT(offset, size * sizeof(double[3]));
   offset_types_sorted =  SPG_POST_INCREMENT(offset, size * sizeof(int));
+  offset_distinct_types =  SPG_POST_INCREMENT(offset, size * sizeof(int));
   blob_size = offset;
 
   if ((checker = (OverlapChecker*)malloc(sizeof(OverlapChecker))) == NULL) {
@@ -396,18 +448,22 @@ static OverlapChecker* overlap_checker_alloc(int size)
   }
 
   checker->size = size;
+  checker->hash_symprec = 0;
+  checker->num_types = 0;
+  checker->hash_start = NULL;
+  checker->hash_atoms = NULL;
 
   /* Create the pointers to the things contained in checker->blob. */
   /* The C spec doesn't allow arithmetic directly on 'void *', */
   /* so a 'char *' is used. */
   chr_blob = (char *)checker->blob;
-  checker->pos_temp_1 = (double (*)[3])(chr_blob + offset_pos_temp_1);
-  checker->pos_temp_2 = (double (*)[3])(chr_blob + offset_pos_temp_2);
   checker->distance_temp = (double *)(chr_blob + offset_distance_temp);
   checker->perm_temp = (int *)(chr_blob + offset_perm_temp);
+  checker->found_temp = (int *)(chr_blob + offset_found_temp);
   checker->lattice = (double (*)[3])(chr_blob + offset_lattice);
   checker->pos_sorted  = (double (*)[3])(chr_blob + offset_pos_sorted);
   checker->types_sorted = (int *)(chr_blob + offset_types_sorted);
+  checker->distinct_types = (int *)(chr_blob + offset_distinct_types);
 
   return checker;
 }
@@ -444,124 +500,211 @@ static int argsort_by_lattice_point_distance(int * perm,
                       size);
 }
 
-/* Tests if an operator COULD be a symmetry of the cell, */
-/* without the cost of sorting the rotated positions. */
-/* It only inspects a few atoms. */
-/* 0:  Not a symmetry.   1. Possible symmetry. */
-static int check_possible_overlap(OverlapChecker *checker,
-                                  const double test_trans[3],
-                                  SPGCONST int rot[3][3],
-                                  const double symprec)
+/* ***************************************** */
+/*             Cell list                     */
+
+/* Fractional coordinate is reduced to [0, 1) and its cell index */
+/* along an axis having n cells is returned. */
+static int get_cell_index(const double x, const int n)
 {
-  double pos_rot[3];
-  int i, i_test, k, max_search_num, search_num;
-  int type_rot, is_found;
+  int i;
+  double y;
 
-  max_search_num = 3;
-  search_num = checker->size <= max_search_num ? checker->size
-                                                : max_search_num;
+  y = x - floor(x);
+  i = (int)(y * n);
+  if (i >= n) {
+    i = n - 1;
+  }
+  if (i < 0) {
+    i = 0;
+  }
+  return i;
+}
 
-  /* Check a few rotated positions. */
-  /* (this could be optimized by focusing on the min_atom_type) */
-  for (i_test = 0; i_test < search_num; i_test++) {
+/* Two positions overlap only if |diff_k| < symprec * |row k of L^-1| */
+/* for each fractional component k, where L has the basis vectors in */
+/* columns. The cells are made wider than this bound so that overlapping */
+/* positions are always found in the same or neighboring cells. The */
+/* number of cells is also limited to about the number of atoms. */
+/* Returns 0 on failure. */
+static int build_hash(OverlapChecker *checker, const double symprec)
+{
+  int i, k, num_cells, max_mesh, key;
+  int cell[3];
+  double inv_lattice[3][3];
+  double tolerance;
+
+  if (checker->hash_start != NULL) {
+    free(checker->hash_start);
+    checker->hash_start = NULL;
+  }
+  if (checker->hash_atoms != NULL) {
+    free(checker->hash_atoms);
+    checker->hash_atoms = NULL;
+  }
+
+  max_mesh = (int)cbrt((double)checker->size);
+  if (max_mesh < 1) {
+    max_mesh = 1;
+  }
 
-    type_rot = checker->types_sorted[i_test];
-    mat_multiply_matrix_vector_id3(pos_rot, rot, checker->pos_sorted[i_test]);
+  if (!mat_inverse_matrix_d3(inv_lattice, checker->lattice, 0)) {
     for (k = 0; k < 3; k++) {
-      pos_rot[k] += test_trans[k];
+      checker->hash_mesh[k] = 1;
+      checker->hash_tolerance[k] = 1;
     }
-
-    /* Brute-force search for the rotated position. */
-    /* (this could be optimized by saving the sorted ValueWithIndex data */
-    /*  for the original Cell and using it to binary search for lower and */
-    /*  upper bounds on 'i'. For now though, brute force is good enough) */
-    is_found = 0;
-    for (i = 0; i < checker->size; i++) {
-      if (cel_is_overlap_with_same_type(pos_rot,
-                                        checker->pos_sorted[i],
-                                        type_rot,
-                                        checker->types_sorted[i],
-                                        checker->lattice,
-                                        symprec)) {
-        is_found = 1;
-        break;
+  } else {
+    for (k = 0; k < 3; k++) {
+      tolerance = symprec * sqrt(inv_lattice[k][0] * inv_lattice[k][0] +
+                                 inv_lattice[k][1] * inv_lattice[k][1] +
+                                 inv_lattice[k][2] * inv_lattice[k][2]);
+      tolerance *= 1.01;
+      checker->hash_tolerance[k] = tolerance;
+      if (tolerance * max_mesh < 1) {
+        checker->hash_mesh[k] = max_mesh;
+      } else {
+        checker->hash_mesh[k] = (int)(1.0 / tolerance);
+        if (checker->hash_mesh[k] < 1) {
+          checker->hash_mesh[k] = 1;
+        }
       }
     }
+  }
 
-    /* The rotated position is not in the structure! */
-    /* This symmetry operator is therefore clearly invalid. */
-    if (!is_found) {
-      return 0;
+  num_cells = checker->hash_mesh[0] * checker->hash_mesh[1] *
+    checker->hash_mesh[2];
+
+  if ((checker->hash_start = (int*)malloc(sizeof(int) *
+                                          (checker->num_types * num_cells + 1)))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated for cell list.");
+    return 0;
+  }
+  if ((checker->hash_atoms = (int*)malloc(sizeof(int) * checker->size))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated for cell list.");
+    free(checker->hash_start);
+    checker->hash_start = NULL;
+    return 0;
+  }
+
+  /* Counting sort of atoms by key. perm_temp keeps the keys. */
+  for (i = 0; i < checker->num_types * num_cells + 1; i++) {
+    checker->hash_start[i] = 0;
+  }
+  for (i = 0; i < checker->size; i++) {
+    for (k = 0; k < 3; k++) {
+      cell[k] = get_cell_index(checker->pos_sorted[i][k],
+                               checker->hash_mesh[k]);
     }
+    key = get_type_rank(checker, checker->types_sorted[i]) * num_cells +
+      (cell[0] * checker->hash_mesh[1] + cell[1]) * checker->hash_mesh[2] +
+      cell[2];
+    checker->perm_temp[i] = key;
+    checker->hash_start[key + 1]++;
+  }
+  for (i = 0; i < checker->num_types * num_cells; i++) {
+    checker->hash_start[i + 1] += checker->hash_start[i];
   }
+  for (i = 0; i < checker->size; i++) {
+    checker->hash_atoms[checker->hash_start[checker->perm_temp[i]]] = i;
+    checker->hash_start[checker->perm_temp[i]]++;
+  }
+  for (i = checker->num_types * num_cells; i > 0; i--) {
+    checker->hash_start[i] = checker->hash_start[i - 1];
+  }
+  checker->hash_start[0] = 0;
+
+  checker->hash_symprec = symprec;
 
   return 1;
 }
 
-/* Optimized for the case where the max difference in index */
-/* between pos_original and pos_rotated is small. */
-/* -1: Error.  0: False.  1:  True. */
-static int check_total_overlap_for_sorted(SPGCONST double lattice[3][3],
-                                          SPGCONST double (*pos_original)[3],
-                                          SPGCONST double (*pos_rotated)[3],
-                                          const int types_original[],
-                                          const int types_rotated[],
-                                          const int num_pos,
-                                          const double symprec)
+/* -1 is returned if type is not in the cell. */
+static int get_type_rank(const OverlapChecker *checker, const int type)
 {
-  int * found;
-  int i, i_orig, i_rot;
-  int search_start;
+  int lo, hi, mid;
+
+  lo = 0;
+  hi = checker->num_types - 1;
+  while (lo <= hi) {
+    mid = (lo + hi) / 2;
+    if (checker->distinct_types[mid] == type) {
+      return mid;
+    } else if (checker->distinct_types[mid] < type) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return -1;
+}
 
-  found = NULL;
+/* Index of an atom in pos_sorted overlapping with pos is returned. */
+/* Atoms already found are skipped and the one returned is marked */
+/* as found. -1 is returned if not found. */
+static int find_overlap_in_hash(const OverlapChecker *checker,
+                                int * found,
+                                const double pos[3],
+                                const int type,
+                                const double symprec)
+{
+  int i, j, k, l, m, n, type_rank, num_cells, key, atom;
+  int cell[3], first[3], last[3], neighbor[3];
+  double x;
 
-  if ((found = (int *)malloc(num_pos * sizeof(int))) == NULL) {
-    warning_print("spglib: Memory could not be allocated");
+  if ((type_rank = get_type_rank(checker, type)) < 0) {
     return -1;
   }
 
-  /* found[i] = 1 if pos_rotated[i] has been found in pos_original */
-  for (i = 0; i < num_pos; i++) {
-    found[i] = 0;
-  }
-
-  search_start = 0;
-  for (i_orig = 0; i_orig < num_pos; i_orig++) {
-
-    /* Permanently skip positions filled near the beginning. */
-    while (found[search_start]) {
-      search_start++;
+  num_cells = checker->hash_mesh[0] * checker->hash_mesh[1] *
+    checker->hash_mesh[2];
+
+  /* Neighboring cells are searched only when pos is closer to */
+  /* their boundaries than the tolerance, and without duplication. */
+  for (k = 0; k < 3; k++) {
+    n = checker->hash_mesh[k];
+    if (n < 3) {
+      cell[k] = 0;
+      first[k] = 0;
+      last[k] = n - 1;
+    } else {
+      cell[k] = get_cell_index(pos[k], n);
+      x = (pos[k] - floor(pos[k])) * n - cell[k];
+      first[k] = (x < checker->hash_tolerance[k] * n) ? -1 : 0;
+      last[k] = (1 - x < checker->hash_tolerance[k] * n) ? 1 : 0;
     }
+  }
 
-    for (i_rot = search_start; i_rot < num_pos; i_rot++) {
-
-      /* Skip any filled positions that aren't near the beginning. */
-      if (found[i_rot]) {
-        continue;
-      }
-
-      if (cel_is_overlap_with_same_type(pos_original[i_orig],
-                                        pos_rotated[i_rot],
-                                        types_original[i_orig],
-                                        types_rotated[i_rot],
-                                        lattice,
-                                        symprec)) {
-        found[i_rot] = 1;
-        break;
+  for (i = first[0]; i <= last[0]; i++) {
+    neighbor[0] = (cell[0] + i + checker->hash_mesh[0]) % checker->hash_mesh[0];
+    for (j = first[1]; j <= last[1]; j++) {
+      neighbor[1] = (cell[1] + j + checker->hash_mesh[1]) %
+        checker->hash_mesh[1];
+      for (l = first[2]; l <= last[2]; l++) {
+        neighbor[2] = (cell[2] + l + checker->hash_mesh[2]) %
+          checker->hash_mesh[2];
+        key = type_rank * num_cells +
+          (neighbor[0] * checker->hash_mesh[1] + neighbor[1]) *
+          checker->hash_mesh[2] + neighbor[2];
+        for (m = checker->hash_start[key];
+             m < checker->hash_start[key + 1];
+             m++) {
+          atom = checker->hash_atoms[m];
+          if (found[atom]) {
+            continue;
+          }
+          if (cel_is_overlap(pos,
+                             checker->pos_sorted[atom],
+                             checker->lattice,
+                             symprec)) {
+            found[atom] = 1;
+            return atom;
+          }
+        }
       }
     }
-
-    if (i_rot == num_pos) {
-      /* We never hit the 'break'. */
-      /* Failure; a position in pos_original does not */
-      /* overlap with any position in pos_rotated. */
-      return 0;
-    }
   }
 
-  free(found);
-  found = NULL;
-
-  /* Success */
-  return 1;
+  return -1;
 }
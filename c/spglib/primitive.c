@@ -37,6 +37,7 @@
 #include "cell.h"
 #include "delaunay.h"
 #include "mathfunc.h"
+#include "overlap.h"
 #include "primitive.h"
 #include "symmetry.h"
 
@@ -51,6 +52,7 @@ static Primitive * get_primitive(const Cell * cell,
 static Cell * get_cell_with_smallest_lattice(const Cell * cell,
                                              const double symprec);
 static Cell * get_primitive_cell(int * mapping_table,
+                                 double prim_lat[3][3],
                                  const Cell * cell,
                                  const VecDBL * pure_trans,
                                  const double symprec,
@@ -73,12 +75,15 @@ static int get_primitive_in_translation_space(double t_mat[3][3],
                                               const double symprec);
 static Symmetry * collect_primitive_symmetry(const Symmetry *symmetry,
                                              const int primsym_size);
+static int is_pure_translation_lattice(const Cell * cell,
+                                       SPGCONST double relative_lattice[3][3],
+                                       const double symprec);
 
 /* return NULL if failed */
 Primitive * prm_alloc_primitive(const int size)
 {
   Primitive *primitive;
-  int i;
+  int i, j;
 
   primitive = NULL;
 
@@ -92,6 +97,11 @@ Primitive * prm_alloc_primitive(const int size)
   primitive->size = size;
   primitive->tolerance = 0;
   primitive->angle_tolerance = -1.0;
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 3; j++) {
+      primitive->orig_lattice[i][j] = 0;
+    }
+  }
 
   if (size > 0) {
     if ((primitive->mapping_table = (int*) malloc(sizeof(int) * size)) == NULL) {
@@ -134,6 +144,96 @@ Primitive * prm_get_primitive(const Cell * cell,
   return get_primitive(cell, symprec, angle_tolerance);
 }
 
+/* Primitive cell is made with a primitive lattice expected in advance, */
+/* e.g., orig_lattice found for a strained cell. The lattice is accepted */
+/* only if its basis vectors are pure translations of cell and the */
+/* primitive cell has no more pure translation. The lattice is reduced */
+/* in the same way as prm_get_primitive. Return NULL if not accepted. */
+Primitive * prm_get_primitive_with_lattice(const Cell * cell,
+                                           SPGCONST double prim_lattice[3][3],
+                                           const double symprec,
+                                           const double angle_tolerance)
+{
+  int i, multi;
+  int inv_relative_int[3][3];
+  double inv_lat[3][3], relative_lattice[3][3], inv_relative[3][3];
+  double lattice[3][3], smallest_lat[3][3];
+  Primitive *primitive;
+  VecDBL *pure_trans;
+
+  debug_print("prm_get_primitive_with_lattice (tolerance = %f):\n", symprec);
+
+  primitive = NULL;
+  pure_trans = NULL;
+
+  /* Clean the lattice so that the cell lattice is its integer multiple. */
+  if (!mat_inverse_matrix_d3(inv_lat, cell->lattice, 0)) {
+    return NULL;
+  }
+  mat_multiply_matrix_d3(relative_lattice, inv_lat, prim_lattice);
+  if (!mat_inverse_matrix_d3(inv_relative, relative_lattice, 0)) {
+    return NULL;
+  }
+  mat_cast_matrix_3d_to_3i(inv_relative_int, inv_relative);
+  multi = abs(mat_get_determinant_i3(inv_relative_int));
+  if (multi == 0 || (cell->size / multi) * multi != cell->size) {
+    return NULL;
+  }
+  mat_cast_matrix_3i_to_3d(inv_relative, inv_relative_int);
+  mat_inverse_matrix_d3(relative_lattice, inv_relative, 0);
+  mat_multiply_matrix_d3(lattice, cell->lattice, relative_lattice);
+
+  if ((primitive = prm_alloc_primitive(cell->size)) == NULL) {
+    return NULL;
+  }
+
+  if (multi == 1) {
+    if ((primitive->cell = get_cell_with_smallest_lattice(cell, symprec))
+        == NULL) {
+      goto not_found;
+    }
+    for (i = 0; i < cell->size; i++) {
+      primitive->mapping_table[i] = i;
+    }
+    mat_copy_matrix_d3(primitive->orig_lattice, cell->lattice);
+  } else {
+    mat_copy_matrix_d3(primitive->orig_lattice, lattice);
+    if (!is_pure_translation_lattice(cell, relative_lattice, symprec)) {
+      goto not_found;
+    }
+    if (!del_delaunay_reduce(smallest_lat, lattice, symprec)) {
+      goto not_found;
+    }
+    if ((primitive->cell = cel_trim_cell(primitive->mapping_table,
+                                         smallest_lat,
+                                         cell,
+                                         symprec)) == NULL) {
+      goto not_found;
+    }
+  }
+
+  if ((pure_trans = sym_get_pure_translation(primitive->cell, symprec))
+      == NULL) {
+    goto not_found;
+  }
+  if (pure_trans->size != 1) {
+    mat_free_VecDBL(pure_trans);
+    pure_trans = NULL;
+    goto not_found;
+  }
+  mat_free_VecDBL(pure_trans);
+  pure_trans = NULL;
+
+  primitive->tolerance = symprec;
+  primitive->angle_tolerance = angle_tolerance;
+  return primitive;
+
+ not_found:
+  prm_free_primitive(primitive);
+  primitive = NULL;
+  return NULL;
+}
+
 Symmetry * prm_get_primitive_symmetry(const Symmetry *symmetry,
                                       const double symprec)
 {
@@ -229,10 +329,12 @@ static Primitive * get_primitive(const Cell * cell,
           for (i = 0; i < cell->size; i++) {
             primitive->mapping_table[i] = i;
           }
+          mat_copy_matrix_d3(primitive->orig_lattice, cell->lattice);
           goto found;
         }
       } else {
         if ((primitive->cell = get_primitive_cell(primitive->mapping_table,
+                                                  primitive->orig_lattice,
                                                   cell,
                                                   pure_trans,
                                                   tolerance,
@@ -302,13 +404,14 @@ static Cell * get_cell_with_smallest_lattice(const Cell * cell,
 
 /* Return NULL if failed */
 static Cell * get_primitive_cell(int * mapping_table,
+                                 double prim_lat[3][3],
                                  const Cell * cell,
                                  const VecDBL * pure_trans,
                                  const double symprec,
                                  const double angle_tolerance)
 {
   int multi;
-  double prim_lat[3][3], smallest_lat[3][3];
+  double smallest_lat[3][3];
   Cell * primitive_cell;
 
   debug_print("get_primitive_cell:\n");
@@ -688,3 +791,39 @@ static Symmetry * collect_primitive_symmetry(const Symmetry *symmetry,
 
   return prim_symmetry;
 }
+
+/* Return 0 if any basis vector of relative_lattice, given in */
+/* fractional coordinates of cell, is not a pure translation. */
+static int is_pure_translation_lattice(const Cell * cell,
+                                       SPGCONST double relative_lattice[3][3],
+                                       const double symprec)
+{
+  int i, j, is_found;
+  int identity[3][3] = {{1, 0, 0},
+                        {0, 1, 0},
+                        {0, 0, 1}};
+  double trans[3];
+  OverlapChecker *checker;
+
+  checker = NULL;
+
+  if ((checker = ovl_overlap_checker_init(cell)) == NULL) {
+    return 0;
+  }
+
+  is_found = 1;
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 3; j++) {
+      trans[j] = relative_lattice[j][i];
+    }
+    if (ovl_check_total_overlap(checker, trans, identity, symprec, 1) != 1) {
+      is_found = 0;
+      break;
+    }
+  }
+
+  ovl_overlap_checker_free(checker);
+  checker = NULL;
+
+  return is_found;
+}
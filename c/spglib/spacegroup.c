@@ -419,6 +419,54 @@ Spacegroup spa_search_spacegroup(const Cell * primitive,
 }
 
 
+/* Same as spa_search_spacegroup but hall_number is only tried first, */
+/* and the other space-group types are searched when it fails. */
+/* Return spacegroup.number = 0 if failed */
+Spacegroup spa_search_spacegroup_with_hint(const Cell * primitive,
+                                           const int hall_number,
+                                           const double symprec,
+                                           const double angle_tolerance)
+{
+  Spacegroup spacegroup;
+  Symmetry *symmetry;
+  int candidate[1];
+
+  debug_print("search_spacegroup_with_hint (tolerance = %f):\n", symprec);
+
+  symmetry = NULL;
+  spacegroup.number = 0;
+
+  if ((symmetry = sym_get_operation(primitive, symprec, angle_tolerance)) ==
+      NULL) {
+    goto ret;
+  }
+
+  if (hall_number > 0) {
+    candidate[0] = hall_number;
+    spacegroup = search_spacegroup_with_symmetry(primitive,
+                                                 candidate,
+                                                 1,
+                                                 symmetry,
+                                                 symprec,
+                                                 angle_tolerance);
+  }
+
+  if (spacegroup.number == 0) {
+    spacegroup = search_spacegroup_with_symmetry(primitive,
+                                                 spacegroup_to_hall_number,
+                                                 230,
+                                                 symmetry,
+                                                 symprec,
+                                                 angle_tolerance);
+  }
+
+  sym_free_symmetry(symmetry);
+  symmetry = NULL;
+
+ ret:
+  return spacegroup;
+}
+
 Spacegroup spa_search_spacegroup_with_symmetry(const Symmetry *symmetry,
                                                const double symprec)
 {
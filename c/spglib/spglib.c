@@ -77,6 +77,36 @@ static SpglibErrorMessage spglib_error_message[] = {
   {SPGERR_NONE, ""},
 };
 
+/*---------*/
+/* context */
+/*---------*/
+#define NUM_CONTEXT_ENTRIES 8
+
+/* Result of a search kept to be tried for a cell with the same */
+/* atom types. primitive_matrix is the primitive lattice given in */
+/* the fractional coordinates of the cell lattice, which is invariant */
+/* under strain. hint_hall_number is the Hall number of the hint at */
+/* the search. The entry is tried only under the same hint, so that */
+/* a setting taken from a hint is not kept after the hint is changed. */
+typedef struct {
+  int num_atom;
+  int *types;
+  int hint_hall_number;
+  int hall_number;
+  double primitive_matrix[3][3];
+} SpglibContextEntry;
+
+struct _SpglibContext {
+  double symprec;
+  double angle_tolerance;
+  int hall_number;
+  int has_primitive_matrix;
+  double primitive_matrix[3][3];
+  int num_entries;
+  int last_entry;
+  SpglibContextEntry entries[NUM_CONTEXT_ENTRIES];
+};
+
 /*---------*/
 /* general */
 /*---------*/
@@ -87,6 +117,19 @@ static SpglibDataset * get_dataset(SPGCONST double lattice[3][3],
                                    const int hall_number,
                                    const double symprec,
                                    const double angle_tolerance);
+static SpglibDataset * get_dataset_with_context(SpglibContext *context,
+                                                SPGCONST double lattice[3][3],
+                                                SPGCONST double position[][3],
+                                                const int types[],
+                                                const int num_atom,
+                                                const int hall_number,
+                                                const double symprec,
+                                                const double angle_tolerance);
+static DataContainer * determine_all_with_context(SpglibContext *context,
+                                                  const Cell * cell);
+static void set_context_entry(SpglibContext *context,
+                              const Cell * cell,
+                              const DataContainer * container);
 static SpglibDataset * init_dataset(void);
 static int set_dataset(SpglibDataset * dataset,
                        const Cell * cell,
@@ -113,6 +156,23 @@ static int get_symmetry_with_collinear_spin(int rotation[][3][3],
                                             const int num_atom,
                                             const double symprec,
                                             const double angle_tolerance);
+static int get_supercell_symmetry(int rotation[][3][3],
+                                  double translation[][3],
+                                  int equivalent_atoms[],
+                                  int map_operations[],
+                                  const int max_size,
+                                  SPGCONST int unit_rotation[][3][3],
+                                  SPGCONST double unit_translation[][3],
+                                  const int num_unit_operations,
+                                  SPGCONST double unit_lattice[3][3],
+                                  SPGCONST double unit_position[][3],
+                                  const int unit_types[],
+                                  const int num_unit_atom,
+                                  SPGCONST int transformation_matrix[3][3],
+                                  SPGCONST double position[][3],
+                                  const int types[],
+                                  const int num_atom,
+                                  const double symprec);
 static int get_multiplicity(SPGCONST double lattice[3][3],
                             SPGCONST double position[][3],
                             const int types[],
@@ -345,6 +405,73 @@ void spg_free_dataset(SpglibDataset *dataset)
   free(dataset);
 }
 
+/* Return NULL if failed */
+SpglibContext * spg_context_new(const double symprec,
+                                const double angle_tolerance)
+{
+  SpglibContext *context;
+
+  context = NULL;
+
+  if ((context = (SpglibContext*) malloc(sizeof(SpglibContext))) == NULL) {
+    warning_print("spglib: Memory could not be allocated.");
+    return NULL;
+  }
+
+  context->symprec = symprec;
+  context->angle_tolerance = angle_tolerance;
+  context->hall_number = 0;
+  context->has_primitive_matrix = 0;
+  context->num_entries = 0;
+  context->last_entry = -1;
+
+  return context;
+}
+
+/* hall_number = 0 and primitive_matrix = NULL mean unknown. */
+void spg_context_set_hint(SpglibContext *context,
+                          const int hall_number,
+                          SPGCONST double primitive_matrix[3][3])
+{
+  context->hall_number = hall_number;
+  if (primitive_matrix == NULL) {
+    context->has_primitive_matrix = 0;
+  } else {
+    context->has_primitive_matrix = 1;
+    mat_copy_matrix_d3(context->primitive_matrix, primitive_matrix);
+  }
+}
+
+/* Return NULL if failed */
+SpglibDataset * spg_context_get_dataset(SpglibContext *context,
+                                        SPGCONST double lattice[3][3],
+                                        SPGCONST double position[][3],
+                                        const int types[],
+                                        const int num_atom)
+{
+  return get_dataset_with_context(context,
+                                  lattice,
+                                  position,
+                                  types,
+                                  num_atom,
+                                  0,
+                                  context->symprec,
+                                  context->angle_tolerance);
+}
+
+void spg_context_free(SpglibContext *context)
+{
+  int i;
+
+  if (context != NULL) {
+    for (i = 0; i < context->num_entries; i++) {
+      free(context->entries[i].types);
+      context->entries[i].types = NULL;
+    }
+    free(context);
+  }
+}
+
 /* Return 0 if failed */
 int spg_get_symmetry(int rotation[][3][3],
                      double translation[][3],
@@ -439,6 +566,44 @@ int spgat_get_symmetry_with_collinear_spin(int rotation[][3][3],
                                           angle_tolerance);
 }
 
+/* Return 0 if failed */
+int spg_get_supercell_symmetry(int rotation[][3][3],
+                               double translation[][3],
+                               int equivalent_atoms[],
+                               int map_operations[],
+                               const int max_size,
+                               SPGCONST int unit_rotation[][3][3],
+                               SPGCONST double unit_translation[][3],
+                               const int num_unit_operations,
+                               SPGCONST double unit_lattice[3][3],
+                               SPGCONST double unit_position[][3],
+                               const int unit_types[],
+                               const int num_unit_atom,
+                               SPGCONST int transformation_matrix[3][3],
+                               SPGCONST double position[][3],
+                               const int types[],
+                               const int num_atom,
+                               const double symprec)
+{
+  return get_supercell_symmetry(rotation,
+                                translation,
+                                equivalent_atoms,
+                                map_operations,
+                                max_size,
+                                unit_rotation,
+                                unit_translation,
+                                num_unit_operations,
+                                unit_lattice,
+                                unit_position,
+                                unit_types,
+                                num_unit_atom,
+                                transformation_matrix,
+                                position,
+                                types,
+                                num_atom,
+                                symprec);
+}
+
 int spg_get_hall_number_from_symmetry(SPGCONST int rotation[][3][3],
                                       SPGCONST double translation[][3],
                                       const int num_operations,
@@ -1013,6 +1178,27 @@ static SpglibDataset * get_dataset(SPGCONST double lattice[3][3],
                                    const int hall_number,
                                    const double symprec,
                                    const double angle_tolerance)
+{
+  return get_dataset_with_context(NULL,
+                                  lattice,
+                                  position,
+                                  types,
+                                  num_atom,
+                                  hall_number,
+                                  symprec,
+                                  angle_tolerance);
+}
+
+/* context can be NULL. */
+/* Return NULL if failed */
+static SpglibDataset * get_dataset_with_context(SpglibContext *context,
+                                                SPGCONST double lattice[3][3],
+                                                SPGCONST double position[][3],
+                                                const int types[],
+                                                const int num_atom,
+                                                const int hall_number,
+                                                const double symprec,
+                                                const double angle_tolerance)
 {
   SpglibDataset *dataset;
   Cell *cell;
@@ -1041,18 +1227,28 @@ static SpglibDataset * get_dataset(SPGCONST double lattice[3][3],
     goto atoms_too_close;
   }
 
-  if ((container = det_determine_all(cell,
-                                     hall_number,
-                                     symprec,
-                                     angle_tolerance))
-      != NULL) {
+  if (context != NULL) {
+    container = determine_all_with_context(context, cell);
+  } else {
+    container = det_determine_all(cell,
+                                  hall_number,
+                                  symprec,
+                                  angle_tolerance);
+  }
+
+  if (container != NULL) {
     if (set_dataset(dataset,
                     cell,
                     container->primitive,
                     container->spacegroup,
                     container->exact_structure)) {
+      if (context != NULL) {
+        set_context_entry(context, cell, container);
+      }
       goto found;
     }
+    det_free_container(container);
+    container = NULL;
   }
 
   cel_free_cell(cell);
@@ -1077,6 +1273,125 @@ static SpglibDataset * get_dataset(SPGCONST double lattice[3][3],
   return dataset;
 }
 
+/* The primitive lattice and the space group found for the latest cell */
+/* with the same atom types under the same hint, or else the hint, are */
+/* tried first. The full search is made when they don't hold. */
+/* Return NULL if failed */
+static DataContainer * determine_all_with_context(SpglibContext *context,
+                                                  const Cell * cell)
+{
+  int i, j, hall_number;
+  double prim_lattice[3][3];
+  DataContainer *container;
+  SpglibContextEntry *entry;
+
+  container = NULL;
+  entry = NULL;
+
+  for (i = 0; i < context->num_entries; i++) {
+    /* From the latest */
+    entry = context->entries +
+      (context->last_entry - i + NUM_CONTEXT_ENTRIES) % NUM_CONTEXT_ENTRIES;
+    if (entry->num_atom == cell->size &&
+        entry->hint_hall_number == context->hall_number) {
+      for (j = 0; j < cell->size; j++) {
+        if (entry->types[j] != cell->types[j]) {
+          break;
+        }
+      }
+      if (j == cell->size) {
+        break;
+      }
+    }
+    entry = NULL;
+  }
+
+  if (entry != NULL) {
+    mat_multiply_matrix_d3(prim_lattice,
+                           cell->lattice,
+                           entry->primitive_matrix);
+    container = det_determine_all_with_hint(cell,
+                                            prim_lattice,
+                                            entry->hall_number,
+                                            context->symprec,
+                                            context->angle_tolerance);
+  } else if (context->hall_number > 0 || context->has_primitive_matrix) {
+    hall_number = context->hall_number;
+    if (context->has_primitive_matrix) {
+      mat_multiply_matrix_d3(prim_lattice,
+                             cell->lattice,
+                             context->primitive_matrix);
+      container = det_determine_all_with_hint(cell,
+                                              prim_lattice,
+                                              hall_number,
+                                              context->symprec,
+                                              context->angle_tolerance);
+    } else {
+      container = det_determine_all_with_hint(cell,
+                                              NULL,
+                                              hall_number,
+                                              context->symprec,
+                                              context->angle_tolerance);
+    }
+  }
+
+  if (container == NULL) {
+    container = det_determine_all(cell,
+                                  0,
+                                  context->symprec,
+                                  context->angle_tolerance);
+  }
+
+  return container;
+}
+
+static void set_context_entry(SpglibContext *context,
+                              const Cell * cell,
+                              const DataContainer * container)
+{
+  int i;
+  double inv_lat[3][3];
+  SpglibContextEntry *entry;
+
+  if (!mat_inverse_matrix_d3(inv_lat, cell->lattice, 0)) {
+    return;
+  }
+
+  /* The oldest entry is replaced when full. */
+  if (context->num_entries < NUM_CONTEXT_ENTRIES) {
+    entry = context->entries + context->num_entries;
+    entry->num_atom = 0;
+    entry->types = NULL;
+    context->last_entry = context->num_entries;
+    context->num_entries++;
+  } else {
+    context->last_entry = (context->last_entry + 1) % NUM_CONTEXT_ENTRIES;
+    entry = context->entries + context->last_entry;
+  }
+
+  if (entry->num_atom != cell->size) {
+    if (entry->types != NULL) {
+      free(entry->types);
+      entry->types = NULL;
+    }
+    entry->num_atom = 0;
+    if ((entry->types = (int*) malloc(sizeof(int) * cell->size)) == NULL) {
+      warning_print("spglib: Memory could not be allocated.");
+      return;
+    }
+  }
+
+  entry->num_atom = cell->size;
+  for (i = 0; i < cell->size; i++) {
+    entry->types[i] = cell->types[i];
+  }
+  entry->hint_hall_number = context->hall_number;
+  entry->hall_number = container->spacegroup->hall_number;
+  mat_multiply_matrix_d3(entry->primitive_matrix,
+                         inv_lat,
+                         container->primitive->orig_lattice);
+}
+
 static SpglibDataset * init_dataset(void)
 {
   SpglibDataset *dataset;
@@ -1419,6 +1734,107 @@ static int get_symmetry_with_collinear_spin(int rotation[][3][3],
   return 0;
 }
 
+/* Return 0 if failed */
+static int get_supercell_symmetry(int rotation[][3][3],
+                                  double translation[][3],
+                                  int equivalent_atoms[],
+                                  int map_operations[],
+                                  const int max_size,
+                                  SPGCONST int unit_rotation[][3][3],
+                                  SPGCONST double unit_translation[][3],
+                                  const int num_unit_operations,
+                                  SPGCONST double unit_lattice[3][3],
+                                  SPGCONST double unit_position[][3],
+                                  const int unit_types[],
+                                  const int num_unit_atom,
+                                  SPGCONST int transformation_matrix[3][3],
+                                  SPGCONST double position[][3],
+                                  const int types[],
+                                  const int num_atom,
+                                  const double symprec)
+{
+  int i, size;
+  double lattice[3][3];
+  Symmetry *unit_symmetry, *symmetry;
+  Cell *unit_cell, *supercell;
+
+  size = 0;
+  unit_symmetry = NULL;
+  symmetry = NULL;
+  unit_cell = NULL;
+  supercell = NULL;
+
+  if ((unit_cell = cel_alloc_cell(num_unit_atom)) == NULL) {
+    goto err;
+  }
+  cel_set_cell(unit_cell, unit_lattice, unit_position, unit_types);
+
+  if ((supercell = cel_alloc_cell(num_atom)) == NULL) {
+    cel_free_cell(unit_cell);
+    unit_cell = NULL;
+    goto err;
+  }
+  mat_multiply_matrix_di3(lattice, unit_lattice, transformation_matrix);
+  cel_set_cell(supercell, lattice, position, types);
+
+  if ((unit_symmetry = sym_alloc_symmetry(num_unit_operations)) == NULL) {
+    cel_free_cell(supercell);
+    supercell = NULL;
+    cel_free_cell(unit_cell);
+    unit_cell = NULL;
+    goto err;
+  }
+
+  for (i = 0; i < num_unit_operations; i++) {
+    mat_copy_matrix_i3(unit_symmetry->rot[i], unit_rotation[i]);
+    mat_copy_vector_d3(unit_symmetry->trans[i], unit_translation[i]);
+  }
+
+  symmetry = sym_get_supercell_operation(equivalent_atoms,
+                                         map_operations,
+                                         unit_symmetry,
+                                         unit_cell,
+                                         transformation_matrix,
+                                         supercell,
+                                         symprec);
+  sym_free_symmetry(unit_symmetry);
+  unit_symmetry = NULL;
+  cel_free_cell(supercell);
+  supercell = NULL;
+  cel_free_cell(unit_cell);
+  unit_cell = NULL;
+
+  if (symmetry == NULL) {
+    goto err;
+  }
+
+  if (symmetry->size > max_size) {
+    fprintf(stderr, "spglib: Indicated max size(=%d) is less than number ",
+            max_size);
+    fprintf(stderr, "spglib: of symmetry operations(=%d).\n", symmetry->size);
+    sym_free_symmetry(symmetry);
+    symmetry = NULL;
+    spglib_error_code = SPGERR_ARRAY_SIZE_SHORTAGE;
+    return 0;
+  }
+
+  for (i = 0; i < symmetry->size; i++) {
+    mat_copy_matrix_i3(rotation[i], symmetry->rot[i]);
+    mat_copy_vector_d3(translation[i], symmetry->trans[i]);
+  }
+
+  size = symmetry->size;
+  sym_free_symmetry(symmetry);
+  symmetry = NULL;
+
+  spglib_error_code = SPGLIB_SUCCESS;
+  return size;
+
+ err:
+  spglib_error_code = SPGERR_SYMMETRY_OPERATION_SEARCH_FAILED;
+  return 0;
+}
+
 /* Return 0 if failed */
 static int get_multiplicity(SPGCONST double lattice[3][3],
                             SPGCONST double position[][3],
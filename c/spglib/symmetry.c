@@ -44,6 +44,7 @@
 #include "debug.h"
 
 #define NUM_ATOMS_CRITERION_FOR_OPENMP 1000
+#define NUM_CANDIDATES_PER_BLOCK 64
 #define ANGLE_REDUCE_RATE 0.95
 #define NUM_ATTEMPT 100
 #define PI 3.14159265358979323846
@@ -85,6 +86,7 @@ static int identity[3][3] = {{1, 0, 0},
 static int get_index_with_least_atoms(const Cell *cell);
 static VecDBL * get_translation(SPGCONST int rot[3][3],
                                 const Cell *cell,
+                                OverlapChecker *checker,
                                 const double symprec,
                                 const int is_identity);
 static Symmetry * get_operations(const Cell *primitive,
@@ -97,11 +99,20 @@ static Symmetry * reduce_operation(const Cell * primitive,
                                    const int is_pure_trans);
 static int search_translation_part(int atoms_found[],
                                    const Cell * cell,
+                                   OverlapChecker *checker,
                                    SPGCONST int rot[3][3],
                                    const int min_atom_index,
                                    const double origin[3],
                                    const double symprec,
                                    const int is_identity);
+static int search_translation_part_parallel(int atoms_found[],
+                                            const Cell * cell,
+                                            OverlapChecker *checker,
+                                            SPGCONST int rot[3][3],
+                                            const int min_atom_index,
+                                            const double origin[3],
+                                            const double symprec,
+                                            const int is_identity);
 static int search_pure_translations(int atoms_found[],
                                     const Cell * cell,
                                     const double trans[3],
@@ -131,6 +142,28 @@ static int is_identity_metric(SPGCONST double metric_rotated[3][3],
 static double get_angle(SPGCONST double metric[3][3],
                         const int i,
                         const int j);
+static int get_supercell_rotation(int rot_s[3][3],
+                                  SPGCONST int rot[3][3],
+                                  SPGCONST int tmat[3][3],
+                                  SPGCONST int adj[3][3],
+                                  const int det);
+static void get_hermite_normal_form(int hnf[3][3], SPGCONST int tmat[3][3]);
+static int get_lattice_point_index(int reduced[3],
+                                   const int n[3],
+                                   SPGCONST int hnf[3][3]);
+static int identify_supercell_atoms(int s2u[],
+                                    int lattice_points[][3],
+                                    const Cell *unit_cell,
+                                    SPGCONST int tmat[3][3],
+                                    const Cell *supercell,
+                                    const double symprec);
+static int map_unit_cell_atoms(int unit_map[],
+                               int shift[][3],
+                               SPGCONST int rot[3][3],
+                               const double trans[3],
+                               const Cell *unit_cell,
+                               const double symprec);
+static void get_adjugate_matrix_i3(int adj[3][3], SPGCONST int a[3][3]);
 
 /* Return NULL if failed */
 Symmetry * sym_alloc_symmetry(const int size)
@@ -211,13 +244,24 @@ VecDBL * sym_get_pure_translation(const Cell *cell,
 {
   int multi;
   VecDBL * pure_trans;
+  OverlapChecker * checker;
 
   debug_print("sym_get_pure_translation (tolerance = %f):\n", symprec);
 
   multi = 0;
   pure_trans = NULL;
+  checker = NULL;
+
+  if ((checker = ovl_overlap_checker_init(cell)) == NULL) {
+    return NULL;
+  }
 
-  if ((pure_trans = get_translation(identity, cell, symprec, 1)) == NULL) {
+  pure_trans = get_translation(identity, cell, checker, symprec, 1);
+
+  ovl_overlap_checker_free(checker);
+  checker = NULL;
+
+  if (pure_trans == NULL) {
     warning_print("spglib: get_translation failed (line %d, %s).\n",
                   __LINE__, __FILE__);
     return NULL;
@@ -287,6 +331,231 @@ VecDBL * sym_reduce_pure_translation(const Cell * cell,
   return pure_trans_reduced;
 }
 
+/* Return NULL if failed */
+/* Operations of a supercell are made of the unit cell operations */
+/* that keep the supercell lattice and the lattice points of the unit */
+/* cell in the supercell, where the supercell lattice is given by */
+/* unit_cell->lattice x tmat. A supercell atom is identified with a */
+/* pair of a unit cell atom and a lattice point, by which */
+/* equivalent_atoms and map_operations are obtained without overlap */
+/* search. map_operations gives the first operation that sends each */
+/* atom to its equivalent atom. Lattice points are indexed by 0 to */
+/* det(tmat) - 1 by the Hermite normal form of tmat. */
+Symmetry * sym_get_supercell_operation(int equivalent_atoms[],
+                                       int map_operations[],
+                                       const Symmetry *symmetry,
+                                       const Cell *unit_cell,
+                                       SPGCONST int tmat[3][3],
+                                       const Cell *supercell,
+                                       const double symprec)
+{
+  int i, j, k, a, b, det, num_points, num_compat, index;
+  int adj[3][3], hnf[3][3], n[3];
+  int *s2u, *atom_index, *compat, *unit_map, *first_atom;
+  int *unit_rep;
+  int (*lattice_points)[3], (*points)[3], (*shift)[3], (*rot_s)[3][3];
+  double t[3];
+  Symmetry *supercell_sym;
+
+  s2u = NULL;
+  atom_index = NULL;
+  compat = NULL;
+  unit_map = NULL;
+  first_atom = NULL;
+  unit_rep = NULL;
+  lattice_points = NULL;
+  points = NULL;
+  shift = NULL;
+  rot_s = NULL;
+  supercell_sym = NULL;
+
+  det = mat_get_determinant_i3(tmat);
+  num_points = abs(det);
+  if (num_points == 0 || supercell->size != unit_cell->size * num_points) {
+    warning_print("spglib: Supercell is inconsistent with unit cell ");
+    warning_print("(line %d, %s).\n", __LINE__, __FILE__);
+    return NULL;
+  }
+
+  get_adjugate_matrix_i3(adj, tmat);
+  get_hermite_normal_form(hnf, tmat);
+
+  if ((s2u = (int*)malloc(sizeof(int) * supercell->size)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((lattice_points = (int (*)[3]) malloc(sizeof(int[3]) * supercell->size))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((atom_index = (int*)malloc(sizeof(int) * unit_cell->size * num_points))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((points = (int (*)[3]) malloc(sizeof(int[3]) * num_points)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((first_atom = (int*)malloc(sizeof(int) * unit_cell->size)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((unit_rep = (int*)malloc(sizeof(int) * unit_cell->size)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((compat = (int*)malloc(sizeof(int) * symmetry->size)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((rot_s = (int (*)[3][3]) malloc(sizeof(int[3][3]) * symmetry->size))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((unit_map = (int*)malloc(sizeof(int) * symmetry->size * unit_cell->size))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+  if ((shift = (int (*)[3]) malloc(sizeof(int[3]) *
+                                   symmetry->size * unit_cell->size))
+      == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    goto ret;
+  }
+
+  /* Supercell atom i is unit cell atom s2u[i] shifted by lattice_points[i]. */
+  if (! identify_supercell_atoms(s2u,
+                                 lattice_points,
+                                 unit_cell,
+                                 tmat,
+                                 supercell,
+                                 symprec)) {
+    goto ret;
+  }
+
+  for (i = 0; i < unit_cell->size * num_points; i++) {
+    atom_index[i] = -1;
+  }
+  for (i = 0; i < unit_cell->size; i++) {
+    first_atom[i] = -1;
+  }
+  /* As many atoms as slots, so every lattice point is filled when no */
+  /* slot is taken twice. Index 0 is the origin. */
+  for (i = 0; i < supercell->size; i++) {
+    index = get_lattice_point_index(n, lattice_points[i], hnf);
+    if (atom_index[s2u[i] * num_points + index] > -1) {
+      warning_print("spglib: Overlapping atoms in supercell ");
+      warning_print("(line %d, %s).\n", __LINE__, __FILE__);
+      goto ret;
+    }
+    atom_index[s2u[i] * num_points + index] = i;
+    mat_copy_vector_i3(points[index], n);
+    if (first_atom[s2u[i]] < 0) {
+      first_atom[s2u[i]] = i;
+    }
+  }
+
+  num_compat = 0;
+  for (i = 0; i < symmetry->size; i++) {
+    if (! get_supercell_rotation(rot_s[num_compat],
+                                 symmetry->rot[i],
+                                 tmat,
+                                 adj,
+                                 det)) {
+      continue;
+    }
+    if (! map_unit_cell_atoms(unit_map + num_compat * unit_cell->size,
+                              shift + num_compat * unit_cell->size,
+                              symmetry->rot[i],
+                              symmetry->trans[i],
+                              unit_cell,
+                              symprec)) {
+      goto ret;
+    }
+    compat[num_compat] = i;
+    num_compat++;
+  }
+
+  if ((supercell_sym = sym_alloc_symmetry(num_compat * num_points)) == NULL) {
+    goto ret;
+  }
+
+  for (i = 0; i < num_compat; i++) {
+    for (j = 0; j < num_points; j++) {
+      k = i * num_points + j;
+      mat_copy_matrix_i3(supercell_sym->rot[k], rot_s[i]);
+      for (a = 0; a < 3; a++) {
+        t[a] = symmetry->trans[compat[i]][a] + points[j][a];
+      }
+      for (a = 0; a < 3; a++) {
+        supercell_sym->trans[k][a] = mat_Dmod1((adj[a][0] * t[0] +
+                                                adj[a][1] * t[1] +
+                                                adj[a][2] * t[2]) / det);
+      }
+    }
+  }
+
+  /* Orbits in supercell are those of unit cell atoms because all the */
+  /* lattice translations are included. */
+  for (a = 0; a < unit_cell->size; a++) {
+    unit_rep[a] = a;
+    for (i = 0; i < num_compat; i++) {
+      b = unit_map[i * unit_cell->size + a];
+      if (first_atom[b] < first_atom[unit_rep[a]]) {
+        unit_rep[a] = b;
+      }
+    }
+  }
+
+  for (i = 0; i < supercell->size; i++) {
+    equivalent_atoms[i] = first_atom[unit_rep[s2u[i]]];
+    a = s2u[i];
+    b = s2u[equivalent_atoms[i]];
+    for (j = 0; j < num_compat; j++) {
+      if (unit_map[j * unit_cell->size + a] != b) {
+        continue;
+      }
+      mat_multiply_matrix_vector_i3(n, symmetry->rot[compat[j]],
+                                    lattice_points[i]);
+      for (k = 0; k < 3; k++) {
+        n[k] = lattice_points[equivalent_atoms[i]][k] - n[k] -
+          shift[j * unit_cell->size + a][k];
+      }
+      map_operations[i] = j * num_points +
+        get_lattice_point_index(n, n, hnf);
+      break;
+    }
+  }
+
+ ret:
+  free(shift);
+  shift = NULL;
+  free(unit_map);
+  unit_map = NULL;
+  free(rot_s);
+  rot_s = NULL;
+  free(compat);
+  compat = NULL;
+  free(unit_rep);
+  unit_rep = NULL;
+  free(first_atom);
+  first_atom = NULL;
+  free(points);
+  points = NULL;
+  free(atom_index);
+  atom_index = NULL;
+  free(lattice_points);
+  lattice_points = NULL;
+  free(s2u);
+  s2u = NULL;
+
+  return supercell_sym;
+}
+
 /* 1) Pointgroup operations of the primitive cell are obtained. */
 /*    These are constrained by the input cell lattice pointgroup, */
 /*    i.e., even if the lattice of the primitive cell has higher */
@@ -399,9 +668,11 @@ static Symmetry * reduce_operation(const Cell * primitive,
 
 /* Look for the translations which satisfy the input symmetry operation. */
 /* This function is heaviest in this code. */
+/* checker has to be made from cell and can be shared among rotations. */
 /* Return NULL if failed */
 static VecDBL * get_translation(SPGCONST int rot[3][3],
                                 const Cell *cell,
+                                OverlapChecker *checker,
                                 const double symprec,
                                 const int is_identity)
 {
@@ -435,13 +706,25 @@ static VecDBL * get_translation(SPGCONST int rot[3][3],
   /* Set min_atom_index as the origin to measure the distance between atoms. */
   mat_multiply_matrix_vector_id3(origin, rot, cell->position[min_atom_index]);
 
-  num_trans = search_translation_part(is_found,
-                                      cell,
-                                      rot,
-                                      min_atom_index,
-                                      origin,
-                                      symprec,
-                                      is_identity);
+  if (cell->size < NUM_ATOMS_CRITERION_FOR_OPENMP) {
+    num_trans = search_translation_part(is_found,
+                                        cell,
+                                        checker,
+                                        rot,
+                                        min_atom_index,
+                                        origin,
+                                        symprec,
+                                        is_identity);
+  } else {
+    num_trans = search_translation_part_parallel(is_found,
+                                                 cell,
+                                                 checker,
+                                                 rot,
+                                                 min_atom_index,
+                                                 origin,
+                                                 symprec,
+                                                 is_identity);
+  }
   if (num_trans == -1 || num_trans == 0) {
     goto ret;
   }
@@ -471,6 +754,7 @@ static VecDBL * get_translation(SPGCONST int rot[3][3],
 /* Returns -1 on failure. */
 static int search_translation_part(int atoms_found[],
                                    const Cell * cell,
+                                   OverlapChecker *checker,
                                    SPGCONST int rot[3][3],
                                    const int min_atom_index,
                                    const double origin[3],
@@ -479,13 +763,6 @@ static int search_translation_part(int atoms_found[],
 {
   int i, j, num_trans, is_overlap;
   double trans[3];
-  OverlapChecker * checker;
-
-  checker = NULL;
-
-  if ((checker = ovl_overlap_checker_init(cell)) == NULL) {
-    return -1;
-  }
 
   num_trans = 0;
 
@@ -508,7 +785,7 @@ static int search_translation_part(int atoms_found[],
                                          symprec,
                                          is_identity);
     if (is_overlap == -1) {
-      goto err;
+      return -1;
     } else if (is_overlap) {
       atoms_found[i] = 1;
       num_trans++;
@@ -521,14 +798,116 @@ static int search_translation_part(int atoms_found[],
     }
   }
 
-  ovl_overlap_checker_free(checker);
-  checker = NULL;
   return num_trans;
+}
 
- err:
-  ovl_overlap_checker_free(checker);
-  checker = NULL;
-  return -1;
+/* Candidate translations are checked in parallel in blocks of */
+/* NUM_CANDIDATES_PER_BLOCK atoms. checker is shared read-only and */
+/* each thread has its own work space. Found translations are */
+/* processed sequentially after each block, so the result does not */
+/* depend on the number of threads. */
+/* Returns -1 on failure. */
+static int search_translation_part_parallel(int atoms_found[],
+                                            const Cell * cell,
+                                            OverlapChecker *checker,
+                                            SPGCONST int rot[3][3],
+                                            const int min_atom_index,
+                                            const double origin[3],
+                                            const double symprec,
+                                            const int is_identity)
+{
+  int i, j, num_trans, block_start, block_end;
+  int *is_overlap, *found_work;
+  double trans[3];
+
+  is_overlap = NULL;
+
+  if (!ovl_overlap_checker_set_symprec(checker, symprec)) {
+    return -1;
+  }
+
+  if ((is_overlap = (int*)malloc(sizeof(int) * cell->size)) == NULL) {
+    warning_print("spglib: Memory could not be allocated ");
+    return -1;
+  }
+
+  num_trans = 0;
+
+  for (block_start = 0;
+       block_start < cell->size;
+       block_start += NUM_CANDIDATES_PER_BLOCK) {
+    block_end = block_start + NUM_CANDIDATES_PER_BLOCK;
+    if (block_end > cell->size) {
+      block_end = cell->size;
+    }
+
+#pragma omp parallel private(i, j, trans, found_work)
+    {
+      found_work = (int*)malloc(sizeof(int) * cell->size);
+#pragma omp for schedule(dynamic)
+      for (i = block_start; i < block_end; i++) {
+        is_overlap[i] = 0;
+
+        if (atoms_found[i]) {
+          continue;
+        }
+
+        if (cell->types[i] != cell->types[min_atom_index]) {
+          continue;
+        }
+
+        if (found_work == NULL) {
+          is_overlap[i] = -1;
+          continue;
+        }
+
+        for (j = 0; j < 3; j++) {
+          trans[j] = cell->position[i][j] - origin[j];
+        }
+
+        is_overlap[i] = ovl_check_total_overlap_with_work(checker,
+                                                          found_work,
+                                                          trans,
+                                                          rot,
+                                                          symprec,
+                                                          is_identity);
+      }
+      if (found_work != NULL) {
+        free(found_work);
+        found_work = NULL;
+      }
+    }
+
+    for (i = block_start; i < block_end; i++) {
+      if (is_overlap[i] == -1) {
+        num_trans = -1;
+        goto ret;
+      }
+
+      /* May be found by search_pure_translations in this block. */
+      if (!is_overlap[i] || atoms_found[i]) {
+        continue;
+      }
+
+      atoms_found[i] = 1;
+      num_trans++;
+      if (is_identity) {
+        for (j = 0; j < 3; j++) {
+          trans[j] = cell->position[i][j] - origin[j];
+        }
+        num_trans += search_pure_translations(atoms_found,
+                                              cell,
+                                              trans,
+                                              symprec);
+      }
+    }
+  }
+
+ ret:
+  free(is_overlap);
+  is_overlap = NULL;
+
+  return num_trans;
 }
 
 static int search_pure_translations(int atoms_found[],
@@ -666,15 +1045,23 @@ get_space_group_operations(SPGCONST PointSymmetry *lattice_sym,
   int i, j, num_sym, total_num_sym;
   VecDBL **trans;
   Symmetry *symmetry;
+  OverlapChecker *checker;
 
   debug_print("get_space_group_operations (tolerance = %f):\n", symprec);
 
   trans = NULL;
   symmetry = NULL;
+  checker = NULL;
+
+  if ((checker = ovl_overlap_checker_init(primitive)) == NULL) {
+    return NULL;
+  }
 
   if ((trans = (VecDBL**) malloc(sizeof(VecDBL*) * lattice_sym->size))
       == NULL) {
     warning_print("spglib: Memory could not be allocated ");
+    ovl_overlap_checker_free(checker);
+    checker = NULL;
     return NULL;
   }
 
@@ -685,8 +1072,11 @@ get_space_group_operations(SPGCONST PointSymmetry *lattice_sym,
   total_num_sym = 0;
   for (i = 0; i < lattice_sym->size; i++) {
 
-    if ((trans[i] = get_translation(lattice_sym->rot[i], primitive, symprec, 0))
-        != NULL) {
+    if ((trans[i] = get_translation(lattice_sym->rot[i],
+                                    primitive,
+                                    checker,
+                                    symprec,
+                                    0)) != NULL) {
 
       debug_print("  match translation %d/%d; tolerance = %f\n",
                   i + 1, lattice_sym->size, symprec);
@@ -720,6 +1110,8 @@ get_space_group_operations(SPGCONST PointSymmetry *lattice_sym,
   }
   free(trans);
   trans = NULL;
+  ovl_overlap_checker_free(checker);
+  checker = NULL;
 
   return symmetry;
 }
@@ -908,3 +1300,181 @@ static void set_axes(int axes[3][3],
   for (i = 0; i < 3; i++) {axes[i][1] = relative_axes[a2][i]; }
   for (i = 0; i < 3; i++) {axes[i][2] = relative_axes[a3][i]; }
 }
+
+/* Return 0 if the rotation does not keep the supercell lattice. */
+static int get_supercell_rotation(int rot_s[3][3],
+                                  SPGCONST int rot[3][3],
+                                  SPGCONST int tmat[3][3],
+                                  SPGCONST int adj[3][3],
+                                  const int det)
+{
+  int i, j;
+  int m[3][3];
+
+  /* rot_s = tmat^-1 rot tmat, where tmat^-1 = adj / det. */
+  mat_multiply_matrix_i3(m, adj, rot);
+  mat_multiply_matrix_i3(m, m, tmat);
+
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 3; j++) {
+      if (m[i][j] % det != 0) {
+        return 0;
+      }
+      rot_s[i][j] = m[i][j] / det;
+    }
+  }
+
+  return 1;
+}
+
+/* Lower triangular Hermite normal form of the columns of tmat, */
+/* i.e., hnf = tmat U with a unimodular U, made by column operations. */
+/* The columns of hnf span the same supercell lattice as tmat. */
+static void get_hermite_normal_form(int hnf[3][3], SPGCONST int tmat[3][3])
+{
+  int i, j, k, q, tmp;
+
+  mat_copy_matrix_i3(hnf, tmat);
+
+  for (i = 0; i < 3; i++) {
+    for (j = i + 1; j < 3; j++) {
+      /* Euclid's algorithm on hnf[i][i] and hnf[i][j] */
+      while (hnf[i][j] != 0) {
+        q = hnf[i][i] / hnf[i][j];
+        for (k = 0; k < 3; k++) {
+          tmp = hnf[k][i] - q * hnf[k][j];
+          hnf[k][i] = hnf[k][j];
+          hnf[k][j] = tmp;
+        }
+      }
+    }
+    if (hnf[i][i] < 0) {
+      for (k = 0; k < 3; k++) {
+        hnf[k][i] = -hnf[k][i];
+      }
+    }
+  }
+}
+
+/* Lattice point n of the unit cell is reduced to the representative */
+/* with 0 <= reduced[i] < hnf[i][i] modulo the supercell lattice. */
+/* reduced may be n itself. */
+/* Return the index in 0 to det(tmat) - 1 of the representative. */
+static int get_lattice_point_index(int reduced[3],
+                                   const int n[3],
+                                   SPGCONST int hnf[3][3])
+{
+  int i, j, q;
+
+  mat_copy_vector_i3(reduced, n);
+
+  for (i = 0; i < 3; i++) {
+    q = reduced[i] / hnf[i][i];
+    if (reduced[i] - q * hnf[i][i] < 0) {
+      q--;
+    }
+    for (j = i; j < 3; j++) {
+      reduced[j] -= q * hnf[j][i];
+    }
+  }
+
+  return (reduced[0] * hnf[1][1] + reduced[1]) * hnf[2][2] + reduced[2];
+}
+
+/* Return 0 if failed */
+static int identify_supercell_atoms(int s2u[],
+                                    int lattice_points[][3],
+                                    const Cell *unit_cell,
+                                    SPGCONST int tmat[3][3],
+                                    const Cell *supercell,
+                                    const double symprec)
+{
+  int i, j, k;
+  double pos[3];
+
+  for (i = 0; i < supercell->size; i++) {
+    mat_multiply_matrix_vector_id3(pos, tmat, supercell->position[i]);
+    s2u[i] = -1;
+    for (j = 0; j < unit_cell->size; j++) {
+      if (unit_cell->types[j] != supercell->types[i]) {
+        continue;
+      }
+      if (cel_is_overlap(pos,
+                         unit_cell->position[j],
+                         unit_cell->lattice,
+                         symprec)) {
+        s2u[i] = j;
+        for (k = 0; k < 3; k++) {
+          lattice_points[i][k] = mat_Nint(pos[k] - unit_cell->position[j][k]);
+        }
+        break;
+      }
+    }
+    if (s2u[i] < 0) {
+      warning_print("spglib: Supercell atom %d is not found in unit cell ",
+                    i);
+      warning_print("(line %d, %s).\n", __LINE__, __FILE__);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* Unit cell atom i is sent by (rot, trans) to atom unit_map[i] */
+/* shifted by lattice vector shift[i]. */
+/* Return 0 if failed */
+static int map_unit_cell_atoms(int unit_map[],
+                               int shift[][3],
+                               SPGCONST int rot[3][3],
+                               const double trans[3],
+                               const Cell *unit_cell,
+                               const double symprec)
+{
+  int i, j, k;
+  double pos[3];
+
+  for (i = 0; i < unit_cell->size; i++) {
+    mat_multiply_matrix_vector_id3(pos, rot, unit_cell->position[i]);
+    for (k = 0; k < 3; k++) {
+      pos[k] += trans[k];
+    }
+    unit_map[i] = -1;
+    for (j = 0; j < unit_cell->size; j++) {
+      if (unit_cell->types[j] != unit_cell->types[i]) {
+        continue;
+      }
+      if (cel_is_overlap(pos,
+                         unit_cell->position[j],
+                         unit_cell->lattice,
+                         symprec)) {
+        unit_map[i] = j;
+        for (k = 0; k < 3; k++) {
+          shift[i][k] = mat_Nint(pos[k] - unit_cell->position[j][k]);
+        }
+        break;
+      }
+    }
+    if (unit_map[i] < 0) {
+      warning_print("spglib: Unit cell operation does not map atom %d ", i);
+      warning_print("(line %d, %s).\n", __LINE__, __FILE__);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/* a adj = det(a) I */
+static void get_adjugate_matrix_i3(int adj[3][3], SPGCONST int a[3][3])
+{
+  adj[0][0] = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+  adj[0][1] = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+  adj[0][2] = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+  adj[1][0] = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+  adj[1][1] = a[0][0] * a[2][2] - a[0][2] * a[2][0];
+  adj[1][2] = a[0][2] * a[1][0] - a[0][0] * a[1][2];
+  adj[2][0] = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+  adj[2][1] = a[0][1] * a[2][0] - a[0][0] * a[2][1];
+  adj[2][2] = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+}
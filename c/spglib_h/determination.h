@@ -50,6 +50,11 @@ DataContainer * det_determine_all(const Cell * cell,
                                   const int hall_number,
                                   const double symprec,
                                   const double angle_tolerance);
+DataContainer * det_determine_all_with_hint(const Cell * cell,
+                                            SPGCONST double prim_lattice[3][3],
+                                            const int hall_number,
+                                            const double symprec,
+                                            const double angle_tolerance);
 void det_free_container(DataContainer * container);
 
 #endif
@@ -44,18 +44,28 @@ typedef struct {
   void * argsort_work;
   void * blob;
 
-  /* Temp areas for writing stuff. (points into blob) */
-  double (*pos_temp_1)[3];
-  double (*pos_temp_2)[3];
-
   /* Temp area for writing lattice point distances. (points into blob) */
   double * distance_temp; /* for lattice point distances */
   int * perm_temp; /* for permutations during sort */
+  int * found_temp; /* for atoms already matched */
 
   /* Sorted data of original cell. (points into blob)*/
   double (*lattice)[3];
   double (*pos_sorted)[3];
   int * types_sorted;
+
+  /* Cell list of pos_sorted keyed by (type, cell) that is built */
+  /* for the symprec given at first and rebuilt when it changes. */
+  /* Atoms in the cell key are */
+  /* hash_atoms[hash_start[key]:hash_start[key + 1]], where */
+  /* key = type_rank * num_cells + cell index in the mesh. */
+  double hash_symprec;
+  int hash_mesh[3];
+  double hash_tolerance[3]; /* in fractional coordinates */
+  int num_types;
+  int * distinct_types; /* (points into blob) */
+  int * hash_start;
+  int * hash_atoms;
 } OverlapChecker;
 
 OverlapChecker* ovl_overlap_checker_init(const Cell *cell);
@@ -66,4 +76,14 @@ int ovl_check_total_overlap(OverlapChecker *checker,
                             const double symprec,
                             const int is_identity);
 
+int ovl_overlap_checker_set_symprec(OverlapChecker *checker,
+                                    const double symprec);
+
+int ovl_check_total_overlap_with_work(const OverlapChecker *checker,
+                                      int * found_work,
+                                      const double test_trans[3],
+                                      int rot[3][3],
+                                      const double symprec,
+                                      const int is_identity);
+
 void ovl_overlap_checker_free(OverlapChecker *checker);
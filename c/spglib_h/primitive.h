@@ -45,6 +45,7 @@ typedef struct {
   int size;
   double tolerance;
   double angle_tolerance;
+  double orig_lattice[3][3]; /* before Delaunay reduction */
 } Primitive;
 
 Primitive * prm_alloc_primitive(const int size);
@@ -52,6 +53,10 @@ void prm_free_primitive(Primitive * primitive);
 Primitive * prm_get_primitive(const Cell * cell,
                               const double symprec,
                               const double angle_tolerance);
+Primitive * prm_get_primitive_with_lattice(const Cell * cell,
+                                           SPGCONST double prim_lattice[3][3],
+                                           const double symprec,
+                                           const double angle_tolerance);
 Symmetry * prm_get_primitive_symmetry(const Symmetry *symmetry,
 				      const double symprec);
 #endif
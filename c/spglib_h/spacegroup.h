@@ -70,6 +70,10 @@ Spacegroup spa_search_spacegroup(const Cell * primitive,
                                  const int hall_number,
                                  const double symprec,
                                  const double angle_tolerance);
+Spacegroup spa_search_spacegroup_with_hint(const Cell * primitive,
+                                           const int hall_number,
+                                           const double symprec,
+                                           const double angle_tolerance);
 Spacegroup spa_search_spacegroup_with_symmetry(const Symmetry *symmetry,
                                                const double symprec);
 Cell * spa_transform_to_primitive(int * mapping_table,
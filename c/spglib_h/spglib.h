@@ -141,6 +141,9 @@ typedef struct {
   char arithmetic_crystal_class_symbol[7];
 } SpglibSpacegroupType;
 
+/* Keeps results of symmetry search to be reused for similar cells. */
+typedef struct _SpglibContext SpglibContext;
+
 int spg_get_major_version(void);
 int spg_get_minor_version(void);
 int spg_get_micro_version(void);
@@ -181,6 +184,32 @@ spgat_get_dataset_with_hall_number(SPGCONST double lattice[3][3],
 
 void spg_free_dataset(SpglibDataset *dataset);
 
+/* Symmetry search for cells related to each other, e.g., strained */
+/* cells of a volume scan, where the primitive lattice and the space */
+/* group found for the last cell with the same atom types are tried */
+/* first. The hint is tried for a cell without such a previous one. */
+/* primitive_matrix gives the primitive lattice by */
+/* lattice x primitive_matrix, and NULL means unknown. hall_number = 0 */
+/* means unknown. Results are the same as spgat_get_dataset, except */
+/* that a hall_number of a non-default setting given as the hint is */
+/* taken when the space group matches. Previous results are reused */
+/* only while the same hall_number is set as the hint, i.e., such a */
+/* setting is not kept after the hint is changed or cleared. */
+SpglibContext * spg_context_new(const double symprec,
+                                const double angle_tolerance);
+
+void spg_context_set_hint(SpglibContext *context,
+                          const int hall_number,
+                          SPGCONST double primitive_matrix[3][3]);
+
+SpglibDataset * spg_context_get_dataset(SpglibContext *context,
+                                        SPGCONST double lattice[3][3],
+                                        SPGCONST double position[][3],
+                                        const int types[],
+                                        const int num_atom);
+
+void spg_context_free(SpglibContext *context);
+
 /* Find symmetry operations. The operations are stored in */
 /* ``rotatiion`` and ``translation``. The number of operations is */
 /* return as the return value. Rotations and translations are */
@@ -230,6 +259,31 @@ int spgat_get_symmetry_with_collinear_spin(int rotation[][3][3],
                                            const double symprec,
                                            const double angle_tolerance);
 
+/* Symmetry operations of a supercell are made from those of its unit */
+/* cell, e.g., obtained by spg_get_dataset, without symmetry search. */
+/* The supercell lattice is unit_lattice x transformation_matrix and */
+/* position is given with respect to the supercell lattice. The unit */
+/* cell operations that do not keep the supercell lattice are dropped. */
+/* map_operations gives the index of the first operation that sends */
+/* each atom to its equivalent atom. Return 0 if failed. */
+int spg_get_supercell_symmetry(int rotation[][3][3],
+                               double translation[][3],
+                               int equivalent_atoms[],
+                               int map_operations[],
+                               const int max_size,
+                               SPGCONST int unit_rotation[][3][3],
+                               SPGCONST double unit_translation[][3],
+                               const int num_unit_operations,
+                               SPGCONST double unit_lattice[3][3],
+                               SPGCONST double unit_position[][3],
+                               const int unit_types[],
+                               const int num_unit_atom,
+                               SPGCONST int transformation_matrix[3][3],
+                               SPGCONST double position[][3],
+                               const int types[],
+                               const int num_atom,
+                               const double symprec);
+
 /* Space group type (hall_number) is searched from symmetry operations. */
 int spg_get_hall_number_from_symmetry(SPGCONST int rotation[][3][3],
                                       SPGCONST double translation[][3],
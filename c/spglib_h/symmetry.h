@@ -64,5 +64,12 @@ VecDBL * sym_reduce_pure_translation(const Cell * cell,
                                      const VecDBL * pure_trans,
                                      const double symprec,
                                      const double angle_tolerance);
+Symmetry * sym_get_supercell_operation(int equivalent_atoms[],
+                                       int map_operations[],
+                                       const Symmetry *symmetry,
+                                       const Cell *unit_cell,
+                                       SPGCONST int tmat[3][3],
+                                       const Cell *supercell,
+                                       const double symprec);
 
 #endif
@@ -79,6 +79,8 @@ class Phonopy(object):
                  symprec=1e-5,
                  is_symmetry=True,
                  use_lapack_solver=False,
+                 symmetry_context=None,
+                 use_unitcell_symmetry=False,
                  log_level=0):
 
         if is_auto_displacements is not None:
@@ -100,7 +102,16 @@ class Phonopy(object):
         self._factor = factor
         self._frequency_scale_factor = frequency_scale_factor
         self._is_symmetry = is_symmetry
-        self._use_lapack_solver = use_lapack_solver
+        if use_lapack_solver:
+            import warnings
+            warnings.warn("use_lapack_solver is deprecated and ignored. "
+                          "Phonons are solved by LAPACK zheev whenever "
+                          "phonopy is built with LAPACK.",
+                          DeprecationWarning)
+        self._symmetry_context = symmetry_context
+        # Supercell symmetry is built from unit cell symmetry if possible.
+        # Wyckoff letters and origin shift can differ from the full search.
+        self._use_unitcell_symmetry = use_unitcell_symmetry
         self._log_level = log_level
 
         # Create supercell and primitive cell
@@ -545,8 +556,7 @@ class Phonopy(object):
             is_gamma_center=is_gamma_center,
             group_velocity=self._group_velocity,
             rotations=self._primitive_symmetry.get_pointgroup_operations(),
-            factor=self._factor,
-            use_lapack_solver=self._use_lapack_solver)
+            factor=self._factor)
         if run_immediately:
             self._mesh.run()
         return True
@@ -582,9 +592,13 @@ class Phonopy(object):
                       is_time_reversal=True,
                       is_mesh_symmetry=True,
                       is_eigenvectors=False,
-                      is_gamma_center=False):
+                      is_gamma_center=False,
+                      block_size=None):
         """Create an IterMesh instance
 
+        Phonons are solved at block_size q-points at a time
+        (default 1), which bounds memory space for eigenvectors.
+
         """
 
 
@@ -602,7 +616,8 @@ class Phonopy(object):
             is_eigenvectors=is_eigenvectors,
             is_gamma_center=is_gamma_center,
             rotations=self._primitive_symmetry.get_pointgroup_operations(),
-            factor=self._factor)
+            factor=self._factor,
+            block_size=block_size)
         return True
 
     def get_iter_mesh(self):
@@ -610,7 +625,7 @@ class Phonopy(object):
 
         This instance object does not store all phonon data. With very
         dense mesh and eigenvectors needed, IterMesh can save memory
-        space, but expected to be slow.
+        space, but expected to be slow for small block_size.
 
         This object is used as an iterator. Phonon frequencies and
         eigenvectos are obtained as below:
@@ -620,6 +635,14 @@ class Phonopy(object):
                 print(freqs)
                 print(eigvecs)
 
+        Blocks of phonons can be also passed to consumers:
+
+            iter_mesh.add_consumer(func)
+            iter_mesh.run()
+
+        where func(q_indices, frequencies, eigenvectors) is called for
+        each block. After run(), frequencies at all q-points are stored.
+
         """
 
         return self._iter_mesh
@@ -1342,14 +1365,22 @@ class Phonopy(object):
             return True
 
     def _search_symmetry(self):
+        if self._use_unitcell_symmetry:
+            unitcell = self._unitcell
+        else:
+            unitcell = None
         self._symmetry = Symmetry(self._supercell,
                                   self._symprec,
-                                  self._is_symmetry)
+                                  self._is_symmetry,
+                                  symmetry_context=self._symmetry_context,
+                                  unitcell=unitcell)
 
     def _search_primitive_symmetry(self):
-        self._primitive_symmetry = Symmetry(self._primitive,
-                                            self._symprec,
-                                            self._is_symmetry)
+        self._primitive_symmetry = Symmetry(
+            self._primitive,
+            self._symprec,
+            self._is_symmetry,
+            symmetry_context=self._symmetry_context)
 
         if (len(self._symmetry.get_pointgroup_operations()) !=
             len(self._primitive_symmetry.get_pointgroup_operations())):
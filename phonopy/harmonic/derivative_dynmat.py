@@ -56,6 +56,7 @@ class DerivativeOfDynamicalMatrix(object):
             [p2p_map[self._s2p_map[i]] for i in range(len(self._s2p_map))],
             dtype='intc')
         self._mass = self._pcell.get_masses()
+        self._pair_ptr, self._pair_atoms = self._dynmat.get_fc_pair_list()
 
         self._ddm = None
 
@@ -70,6 +71,23 @@ class DerivativeOfDynamicalMatrix(object):
         else:
             self._run_c(q, q_direction=q_direction)
 
+    def run_at_qpoints(self, qpoints, q_direction=None, lang='C'):
+        """Compute derivatives of dynamical matrices at many q-points
+
+        With C implementation, q-points are distributed over threads.
+        Derivatives are obtained by get_derivative_of_dynamical_matrix
+        in the shape of (num_qpoints, 3, num_band, num_band).
+
+        """
+        if self._derivative_order is not None or lang != 'C':
+            ddms = []
+            for q in qpoints:
+                self._run_py(q, q_direction=q_direction)
+                ddms.append(self._ddm)
+            self._ddm = np.array(ddms)
+        else:
+            self._run_c_at_qpoints(qpoints, q_direction=q_direction)
+
     def set_derivative_order(self, order):
         if order == 1 or order == 2:
             self._derivative_order = order
@@ -82,61 +100,119 @@ class DerivativeOfDynamicalMatrix(object):
     def _run_c(self, q, q_direction=None):
         import phonopy._phonopy as phonoc
         num_patom = len(self._p2s_map)
-
-        mass = self._pcell.get_masses()
-        fc = self._force_constants
         itemsize = self._force_constants.itemsize
         ddm = np.zeros((3, num_patom * 3, num_patom * 3),
                        dtype=("c%d" % (itemsize * 2)))
-        vectors = self._smallest_vectors
-        multiplicity = self._multiplicity
+        if self._dynmat.is_nac() and q_direction is not None:
+            q_dir = np.array(q_direction, dtype='double', order='C')
+        else:
+            q_dir = None
+
+        (fc,
+         lattice,
+         vectors,
+         multiplicity,
+         mass,
+         s2p_map,
+         p2s_map,
+         nac_factor,
+         born,
+         dielectric,
+         pair_ptr,
+         pair_atoms) = self._get_c_arguments()
+
+        phonoc.derivative_dynmat(ddm.view(dtype='double'),
+                                 fc,
+                                 np.array(q, dtype='double'),
+                                 lattice,
+                                 vectors,
+                                 multiplicity,
+                                 mass,
+                                 s2p_map,
+                                 p2s_map,
+                                 nac_factor,
+                                 born,
+                                 dielectric,
+                                 q_dir,
+                                 pair_ptr,
+                                 pair_atoms)
+
+        self._ddm = ddm
+
+    def _run_c_at_qpoints(self, qpoints, q_direction=None):
+        import phonopy._phonopy as phonoc
+        _qpoints = np.array(qpoints, dtype='double', order='C')
+        num_band = len(self._p2s_map) * 3
+        itemsize = self._force_constants.itemsize
+        dtype = "c%d" % (itemsize * 2)
+        ddms = np.zeros((len(_qpoints), 3, num_band, num_band), dtype=dtype)
+        if self._dynmat.is_nac() and q_direction is not None:
+            q_dir = np.array(q_direction, dtype='double', order='C')
+        else:
+            q_dir = None
+
+        (fc,
+         lattice,
+         vectors,
+         multiplicity,
+         mass,
+         s2p_map,
+         p2s_map,
+         nac_factor,
+         born,
+         dielectric,
+         pair_ptr,
+         pair_atoms) = self._get_c_arguments()
+
+        phonoc.derivative_dynmats(ddms.view(dtype='double'),
+                                  fc,
+                                  _qpoints,
+                                  lattice,
+                                  vectors,
+                                  multiplicity,
+                                  mass,
+                                  s2p_map,
+                                  p2s_map,
+                                  nac_factor,
+                                  born,
+                                  dielectric,
+                                  q_dir,
+                                  pair_ptr,
+                                  pair_atoms)
+
+        self._ddm = ddms
+
+    def _get_c_arguments(self):
+        """q-independent arguments of C derivative of dynamical matrix"""
+        fc = self._force_constants
         if self._dynmat.is_nac():
             born = self._dynmat.get_born_effective_charges()
             dielectric = self._dynmat.get_dielectric_constant()
             nac_factor = self._dynmat.get_nac_factor()
-            if q_direction is None:
-                q_dir = None
-            else:
-                q_dir = np.array(q_direction, dtype='double', order='C')
         else:
             born = None
             dielectric = None
             nac_factor = 0
-            q_dir = None
 
         if fc.shape[0] == fc.shape[1]: # full fc
-            phonoc.derivative_dynmat(ddm.view(dtype='double'),
-                                     fc,
-                                     np.array(q, dtype='double'),
-                                     np.array(self._pcell.get_cell().T,
-                                              dtype='double', order='C'),
-                                     vectors,
-                                     multiplicity,
-                                     mass,
-                                     self._s2p_map,
-                                     self._p2s_map,
-                                     nac_factor,
-                                     born,
-                                     dielectric,
-                                     q_dir)
+            s2p_map = self._s2p_map
+            p2s_map = self._p2s_map
         else:
-            phonoc.derivative_dynmat(ddm.view(dtype='double'),
-                                     fc,
-                                     np.array(q, dtype='double'),
-                                     np.array(self._pcell.get_cell().T,
-                                              dtype='double', order='C'),
-                                     vectors,
-                                     multiplicity,
-                                     mass,
-                                     self._s2pp_map,
-                                     np.arange(len(self._p2s_map),
-                                               dtype='intc'),
-                                     nac_factor,
-                                     born,
-                                     dielectric,
-                                     q_dir)
-
-        self._ddm = ddm
+            s2p_map = self._s2pp_map
+            p2s_map = np.arange(len(self._p2s_map), dtype='intc')
+
+        return (fc,
+                np.array(self._pcell.get_cell().T, dtype='double', order='C'),
+                self._smallest_vectors,
+                self._multiplicity,
+                self._pcell.get_masses(),
+                s2p_map,
+                p2s_map,
+                nac_factor,
+                born,
+                dielectric,
+                self._pair_ptr,
+                self._pair_atoms)
 
     def _run_py(self, q, q_direction=None):
         if self._dynmat.is_nac():
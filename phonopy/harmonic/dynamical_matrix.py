@@ -34,6 +34,7 @@
 
 import textwrap
 from phonopy.harmonic.dynmat_to_fc import DynmatToForceConstants
+from phonopy.structure.cells import get_smallest_vector_lattice_points
 import numpy as np
 
 def get_dynamical_matrix(fc2,
@@ -108,6 +109,13 @@ class DynamicalMatrix(object):
             dtype='intc')
         (self._smallest_vectors,
          self._multiplicity) = primitive.get_smallest_vectors()
+        self._lattice_points = None
+        self._lattice_index = None
+        self._positions = None
+        self._set_lattice_phase_table()
+        self._pair_ptr = None
+        self._pair_atoms = None
+        self._set_fc_pair_list()
         # Non analytical term correction
         self._nac = False
 
@@ -132,6 +140,20 @@ class DynamicalMatrix(object):
     def get_shortest_vectors(self):
         return self._smallest_vectors, self._multiplicity
 
+    def get_fc_pair_list(self):
+        """Supercell atoms having non-zero force constants
+
+        For the pair of primitive atoms (i, j), the supercell atoms k
+        mapped to j that have non-zero fc[i, k] are stored in
+        pair_atoms[pair_ptr[i * num_patom + j]:pair_ptr[i * num_patom + j + 1]]
+        in ascending order.
+
+        Returns:
+            (pair_ptr, pair_atoms)
+
+        """
+        return self._pair_ptr, self._pair_atoms
+
     def get_primitive_to_supercell_map(self):
         return self._p2s_map
 
@@ -149,6 +171,31 @@ class DynamicalMatrix(object):
     def set_dynamical_matrix(self, q):
         self._set_dynamical_matrix(q)
 
+    def get_dynamical_matrices_at_qpoints(self, qpoints):
+        """Dynamical matrices at many q-points
+
+        With the C extension, all dynamical matrices are built in one call
+        that is parallelized over q-points.
+
+        Args:
+            qpoints: q-points in reduced coordinates, shape=(num_qpoints, 3)
+
+        Returns:
+            Dynamical matrices, shape=(num_qpoints, num_band, num_band)
+
+        """
+        _qpoints = np.array(qpoints, dtype='double', order='C').reshape(-1, 3)
+        try:
+            import phonopy._phonopy as phonoc
+            dms = self._get_c_dynamical_matrices(_qpoints)
+        except ImportError:
+            dms = self._get_py_dynamical_matrices(_qpoints)
+
+        if self._decimals is None:
+            return dms
+        else:
+            return dms.round(decimals=self._decimals)
+
     def _set_dynamical_matrix(self, q):
         try:
             import phonopy._phonopy as phonoc
@@ -166,6 +213,44 @@ class DynamicalMatrix(object):
         else:
             self._force_constants = np.array(fc, dtype='double', order='C')
 
+    def _set_lattice_phase_table(self, tolerance=1e-8):
+        """Decompose smallest vectors into atom positions and lattice points
+
+        With these, exp(2pi i q.R) is computed only once for each lattice
+        point R at each q in C. When the smallest vectors can not be
+        decomposed within the tolerance, the table is not used.
+
+        """
+        pos = self._pcell.get_scaled_positions()
+        lattice_points, lattice_index = get_smallest_vector_lattice_points(
+            self._smallest_vectors,
+            self._multiplicity,
+            pos,
+            self._s2pp_map,
+            tolerance=tolerance)
+        if lattice_points is None:
+            return
+
+        self._lattice_points = lattice_points
+        self._lattice_index = lattice_index
+        self._positions = np.array(pos, dtype='double', order='C')
+
+    def _set_fc_pair_list(self):
+        fc = self._force_constants
+        num_patom = len(self._p2s_map)
+        if fc.shape[0] == fc.shape[1]: # full fc
+            fc_p = fc[self._p2s_map]
+        else:
+            fc_p = fc
+        nonzero = (fc_p.reshape(num_patom, fc.shape[1], 9) != 0).any(axis=2)
+        patoms, satoms = np.nonzero(nonzero)
+        pairs = patoms * num_patom + self._s2pp_map[satoms]
+        order = np.lexsort((satoms, pairs))
+        self._pair_atoms = np.array(satoms[order], dtype='intc')
+        self._pair_ptr = np.zeros(num_patom ** 2 + 1, dtype='intc')
+        self._pair_ptr[1:] = np.cumsum(
+            np.bincount(pairs, minlength=num_patom ** 2))
+
     def _set_c_dynamical_matrix(self, q):
         import phonopy._phonopy as phonoc
 
@@ -186,7 +271,12 @@ class DynamicalMatrix(object):
                                     multiplicity,
                                     mass,
                                     self._s2p_map,
-                                    self._p2s_map)
+                                    self._p2s_map,
+                                    self._lattice_points,
+                                    self._lattice_index,
+                                    self._positions,
+                                    self._pair_ptr,
+                                    self._pair_atoms)
         else:
             phonoc.dynamical_matrix(dm.view(dtype='double'),
                                     fc,
@@ -195,7 +285,12 @@ class DynamicalMatrix(object):
                                     multiplicity,
                                     mass,
                                     self._s2pp_map,
-                                    np.arange(len(self._p2s_map), dtype='intc'))
+                                    np.arange(len(self._p2s_map), dtype='intc'),
+                                    self._lattice_points,
+                                    self._lattice_index,
+                                    self._positions,
+                                    self._pair_ptr,
+                                    self._pair_atoms)
 
         # Data of dm array are stored in memory by the C order of
         # (size_prim * 3, size_prim * 3, 2), where the last 2 means
@@ -207,6 +302,76 @@ class DynamicalMatrix(object):
         #   dm = dm_double[:, :, 0] + 1j * dm_double[:, :, 1]
         self._dynamical_matrix = dm
 
+    def _get_c_dynamical_matrices(self,
+                                  qpoints,
+                                  q_cart=None,
+                                  nac_factors=None):
+        import phonopy._phonopy as phonoc
+
+        fc = self._force_constants
+        size_prim = self._pcell.get_number_of_atoms()
+        dms = np.zeros((len(qpoints), size_prim * 3, size_prim * 3),
+                       dtype=("c%d" % (fc.itemsize * 2)))
+        phonoc.dynamical_matrices(
+            dms.view(dtype='double'),
+            *self._get_c_dynamical_matrices_arguments(qpoints,
+                                                      q_cart=q_cart,
+                                                      nac_factors=nac_factors))
+        return dms
+
+    def _get_c_dynamical_matrices_arguments(self,
+                                            qpoints,
+                                            q_cart=None,
+                                            nac_factors=None):
+        """Arguments of phonoc.dynamical_matrices after the output array"""
+        fc = self._force_constants
+        if nac_factors is None:
+            born = None
+        else:
+            born = self._born
+
+        if fc.shape[0] == fc.shape[1]: # full fc
+            s2p_map = self._s2p_map
+            p2s_map = self._p2s_map
+        else:
+            s2p_map = self._s2pp_map
+            p2s_map = np.arange(len(self._p2s_map), dtype='intc')
+
+        return (fc,
+                qpoints,
+                self._smallest_vectors,
+                self._multiplicity,
+                self._pcell.get_masses(),
+                s2p_map,
+                p2s_map,
+                self._lattice_points,
+                self._lattice_index,
+                self._positions,
+                self._pair_ptr,
+                self._pair_atoms,
+                q_cart,
+                born,
+                nac_factors)
+
+    def _get_c_solver_arguments(self, qpoints, q_direction=None):
+        """Arguments of phonoc.phonons_at_qpoints for dynamical matrices
+
+        None is returned when dynamical matrices can not be built inside
+        the solver, e.g., by rounding with decimals.
+
+        """
+        if self._decimals is None:
+            return self._get_c_dynamical_matrices_arguments(qpoints)
+        else:
+            return None
+
+    def _get_py_dynamical_matrices(self, qpoints):
+        dms = []
+        for q in qpoints:
+            self.set_dynamical_matrix(q)
+            dms.append(self._dynamical_matrix)
+        return np.array(dms, dtype=self._dtype_complex, order='C')
+
     def _set_py_dynamical_matrix(self, q):
         fc = self._force_constants
         vecs = self._smallest_vectors
@@ -267,6 +432,8 @@ class DynamicalMatrixNAC(DynamicalMatrix):
         self._G_cutoff = None
         self._Lambda = None # 4*Lambda**2 is stored.
         self._dd_q0 = None
+        # q-independent G-space terms, see _set_c_dipole_dipole_workspace
+        self._dd_workspace = None
 
         self._nac = True
         if nac_params is not None:
@@ -327,6 +494,7 @@ class DynamicalMatrixNAC(DynamicalMatrix):
         try:
             import phonopy._phonopy as phonoc
             self._set_c_dipole_dipole_q0()
+            self._set_c_dipole_dipole_workspace()
         except ImportError:
             print("Python version of dipole-dipole calculation is not well "
                   "implemented.")
@@ -353,6 +521,102 @@ class DynamicalMatrixNAC(DynamicalMatrix):
                 self.make_Gonze_nac_dataset(self._log_level)
             self._set_Gonze_dynamical_matrix(q_red, q_direction)
 
+    def get_dynamical_matrices_at_qpoints(self, qpoints, q_direction=None):
+        """Dynamical matrices with NAC at many q-points
+
+        q-points are treated as set_dynamical_matrix(q) without
+        q_direction, i.e., NAC is not applied at Gamma point, unless
+        q_direction is given. q_direction is used only at Gamma point.
+
+        """
+        _qpoints = np.array(qpoints, dtype='double', order='C').reshape(-1, 3)
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            dms = []
+            for q in _qpoints:
+                if (np.abs(q) < self._symprec).all():
+                    self.set_dynamical_matrix(q, q_direction=q_direction)
+                else:
+                    self.set_dynamical_matrix(q)
+                dms.append(self._dynamical_matrix)
+            dms = np.array(dms, dtype=self._dtype_complex, order='C')
+            if self._decimals is None:
+                return dms
+            else:
+                return dms.round(decimals=self._decimals)
+
+        if self._method == 'wang':
+            dms = self._get_c_dynamical_matrices(
+                _qpoints, *self._get_Wang_nac_factors(_qpoints, q_direction))
+        else:
+            if self._Gonze_force_constants is None:
+                self.make_Gonze_nac_dataset(self._log_level)
+            fc = self._force_constants
+            pair_list = self._pair_ptr, self._pair_atoms
+            self._force_constants = self._Gonze_force_constants
+            self._pair_ptr, self._pair_atoms = None, None
+            dms = self._get_c_dynamical_matrices(_qpoints)
+            self._force_constants = fc
+            self._pair_ptr, self._pair_atoms = pair_list
+            is_gamma = self._get_is_gamma(_qpoints)
+            for i, q_red in enumerate(_qpoints):
+                if is_gamma[i]:
+                    self.set_dynamical_matrix(q_red, q_direction=q_direction)
+                    dms[i] = self._dynamical_matrix
+                else:
+                    dms[i] += self._get_Gonze_dipole_dipole(q_red, None)
+
+        if self._decimals is None:
+            return dms
+        else:
+            return dms.round(decimals=self._decimals)
+
+    def _get_c_solver_arguments(self, qpoints, q_direction=None):
+        if self._method == 'wang' and self._decimals is None:
+            return self._get_c_dynamical_matrices_arguments(
+                qpoints, *self._get_Wang_nac_factors(qpoints, q_direction))
+        else:
+            return None
+
+    def _get_is_gamma(self, qpoints):
+        rec_lat = np.linalg.inv(self._pcell.get_cell()) # column vectors
+        q_cart = np.dot(qpoints, rec_lat.T)
+        return np.sqrt((q_cart ** 2).sum(axis=1)) < self._symprec
+
+    def _get_Wang_nac_factors(self, qpoints, q_direction):
+        """q_cart and NAC factors of phonoc.dynamical_matrices
+
+        The factor is zero at Gamma point without q_direction.
+
+        """
+        # Products are written element-wise instead of np.dot, whose
+        # rounding may depend on the number of q-points through BLAS.
+        rec_lat = np.linalg.inv(self._pcell.get_cell()) # column vectors
+        _qpoints = np.array(qpoints, dtype='double')
+        q_cart = np.array(_qpoints[:, 0:1] * rec_lat[:, 0] +
+                          _qpoints[:, 1:2] * rec_lat[:, 1] +
+                          _qpoints[:, 2:3] * rec_lat[:, 2],
+                          dtype='double', order='C')
+        is_gamma = self._get_is_gamma(qpoints)
+        if q_direction is not None:
+            q_cart[is_gamma] = np.dot(q_direction, rec_lat.T)
+            is_gamma[:] = np.sqrt((q_cart ** 2).sum(axis=1)) < self._symprec
+
+        N = (self._scell.get_number_of_atoms() //
+             self._pcell.get_number_of_atoms())
+        nac_factors = np.zeros(len(qpoints), dtype='double')
+        eps = self._dielectric
+        qe = (q_cart[:, 0:1] * eps[0] +
+              q_cart[:, 1:2] * eps[1] +
+              q_cart[:, 2:3] * eps[2])
+        qeq = (qe[:, 0] * q_cart[:, 0] +
+               qe[:, 1] * q_cart[:, 1] +
+               qe[:, 2] * q_cart[:, 2])
+        nac_factors[~is_gamma] = (self.get_nac_factor() /
+                                  qeq[~is_gamma] / N)
+        return q_cart, nac_factors
+
     def _set_Wang_dynamical_matrix(self, q_red, q_direction):
         # Wang method (J. Phys.: Condens. Matter 22 (2010) 202201)
         rec_lat = np.linalg.inv(self._pcell.get_cell()) # column vectors
@@ -399,7 +663,10 @@ class DynamicalMatrixNAC(DynamicalMatrix):
                                         self._p2s_map,
                                         np.array(q, dtype='double'),
                                         self._born,
-                                        factor)
+                                        factor,
+                                        self._lattice_points,
+                                        self._lattice_index,
+                                        self._positions)
         else:
             phonoc.nac_dynamical_matrix(dm.view(dtype='double'),
                                         fc,
@@ -412,7 +679,10 @@ class DynamicalMatrixNAC(DynamicalMatrix):
                                                   dtype='intc'),
                                         np.array(q, dtype='double'),
                                         self._born,
-                                        factor)
+                                        factor,
+                                        self._lattice_points,
+                                        self._lattice_index,
+                                        self._positions)
 
         self._dynamical_matrix = dm
 
@@ -436,9 +706,12 @@ class DynamicalMatrixNAC(DynamicalMatrix):
             print("%d %s" % (self._Gonze_count + 1, q_red))
         self._Gonze_count += 1
         fc = self._force_constants
+        pair_list = self._pair_ptr, self._pair_atoms
         self._force_constants = self._Gonze_force_constants
+        self._pair_ptr, self._pair_atoms = None, None
         self._set_dynamical_matrix(q_red)
         self._force_constants = fc
+        self._pair_ptr, self._pair_atoms = pair_list
         dm_dd = self._get_Gonze_dipole_dipole(q_red, q_direction)
         self._dynamical_matrix += dm_dd
 
@@ -506,6 +779,11 @@ class DynamicalMatrixNAC(DynamicalMatrix):
         dd = np.zeros((num_atom, 3, num_atom, 3),
                       dtype=self._dtype_complex, order='C')
 
+        if self._dd_workspace is None:
+            workspace = ()
+        else:
+            workspace = self._dd_workspace
+
         phonoc.dipole_dipole(dd.view(dtype='double'),
                              self._dd_q0.view(dtype='double'),
                              self._G_list,
@@ -516,9 +794,44 @@ class DynamicalMatrixNAC(DynamicalMatrix):
                              np.array(pos, dtype='double', order='C'),
                              self._unit_conversion * 4.0 * np.pi / volume,
                              self._Lambda,
-                             self._symprec)
+                             self._symprec,
+                             *workspace)
         return dd
 
+    def _set_c_dipole_dipole_workspace(self):
+        """Store q-independent parts of G-space sum
+
+        |G+q|^2, (G+q).eps.(G+q) and exp(2pi i G.(r_i - r_j)) are
+        reconstructed from these arrays at each q-point, where the last
+        is made of per-atom phases exp(2pi i G.r_i). The
+        scratch array of dipole-dipole is allocated only once.
+
+        """
+        import phonopy._phonopy as phonoc
+
+        pos = np.array(self._pcell.get_positions(), dtype='double', order='C')
+        num_atom = len(pos)
+        num_G = len(self._G_list)
+        dd_tmp = np.zeros((num_atom, 3, num_atom, 3),
+                          dtype=self._dtype_complex, order='C')
+        G_phases = np.zeros((num_G, num_atom),
+                            dtype=self._dtype_complex, order='C')
+        eps_G = np.zeros((num_G, 3), dtype='double', order='C')
+        G_eps_G = np.zeros(num_G, dtype='double')
+        G_norm2 = np.zeros(num_G, dtype='double')
+        phonoc.dipole_dipole_workspace(G_phases.view(dtype='double'),
+                                       eps_G,
+                                       G_eps_G,
+                                       G_norm2,
+                                       self._G_list,
+                                       self._dielectric,
+                                       pos)
+        self._dd_workspace = (dd_tmp.view(dtype='double'),
+                              G_phases.view(dtype='double'),
+                              eps_G,
+                              G_eps_G,
+                              G_norm2)
+
     def _set_c_dipole_dipole_q0(self):
         import phonopy._phonopy as phonoc
 
@@ -35,7 +35,9 @@
 import numpy as np
 from phonopy.structure.atoms import PhonopyAtoms as Atoms
 from phonopy.structure.symmetry import Symmetry
-from phonopy.structure.cells import get_supercell
+from phonopy.structure.cells import (get_supercell,
+                                     get_smallest_vector_lattice_points,
+                                     SNF3x3)
 from phonopy.harmonic.force_constants import distribute_force_constants
 
 def get_commensurate_points(supercell_matrix): # wrt primitive cell
@@ -48,13 +50,118 @@ def get_commensurate_points(supercell_matrix): # wrt primitive cell
     return np.array(np.where(q_pos > 1 - 1e-15, q_pos - 1, q_pos),
                     dtype='double', order='C')
 
+class CommensurateGridFFT(object):
+    """Fourier transform between fc and dynamical matrices by FFT
+
+    Commensurate points q and lattice points n of the primitive cell
+    modulo the supercell are put on the same grid of shape D, where
+    D = P M Q is the Smith normal form of the supercell matrix M
+    (in the primitive basis). With u = P n mod D and v = D P^-T q,
+    q.n = sum_a u_a v_a / D_a modulo integer. Images of a supercell atom
+    given by the smallest vectors are decomposed into atom positions and
+    lattice points beforehand, which are then summed up with the weights
+    of 1 / multiplicity.
+
+    fc are compact, i.e., fc[num_patom, num_satom, 3, 3], and dynamical
+    matrices are given at the commensurate points in the order of
+    commensurate_points.
+
+    """
+
+    def __init__(self,
+                 primitive,
+                 supercell_matrix,
+                 commensurate_points,
+                 lattice_points,
+                 lattice_index):
+        self._masses = primitive.get_masses()
+        self._pos = primitive.get_scaled_positions()
+        self._num_patom = len(self._pos)
+        s2p = primitive.get_supercell_to_primitive_map()
+        p2p = primitive.get_primitive_to_primitive_map()
+        self._s2pp = np.array([p2p[i] for i in s2p], dtype='intc')
+        self._multiplicity = primitive.get_smallest_vectors()[1]
+        self._commensurate_points = commensurate_points
+
+        snf = SNF3x3(supercell_matrix)
+        snf.run()
+        self._mesh = np.diag(snf.A)
+        P = snf.P
+        P_inv_T = np.rint(np.linalg.inv(P)).astype('intc').T
+
+        v = np.rint(np.dot(commensurate_points, P_inv_T.T) * self._mesh)
+        v = v.astype('intc') % self._mesh
+        self._q_index = np.ravel_multi_index(v.T, self._mesh)
+        u = np.dot(lattice_points, P.T) % self._mesh
+        self._lattice_grid_index = np.ravel_multi_index(u.T, self._mesh)
+        self._lattice_index = lattice_index
+
+    def get_force_constants(self, dynamical_matrices):
+        N = len(self._commensurate_points)
+        n_p = self._num_patom
+        dm = np.array(dynamical_matrices).reshape(N, n_p, 3, n_p, 3)
+        dm = dm.transpose(1, 3, 2, 4, 0)
+        dm = dm * self._get_atom_phases(-1)[:, :, None, None, :]
+        grid = np.zeros((n_p, n_p, 3, 3, np.prod(self._mesh)),
+                        dtype=dm.dtype)
+        grid[..., self._q_index] = dm
+        grid = np.fft.fftn(grid.reshape((n_p, n_p, 3, 3) +
+                                        tuple(self._mesh)),
+                           axes=(-3, -2, -1))
+        grid = grid.reshape(n_p, n_p, 3, 3, -1).real.transpose(0, 1, 4, 2, 3)
+
+        num_satom = len(self._s2pp)
+        multi = self._multiplicity.T
+        fc = np.zeros((n_p, num_satom, 3, 3), dtype='double', order='C')
+        i_p = np.arange(n_p)[:, None]
+        for l in range(multi.max()):
+            u = self._lattice_grid_index[self._lattice_index[:, :, l].T]
+            fc += (grid[i_p, self._s2pp[None, :], u] *
+                   (l < multi)[:, :, None, None])
+        coef = (np.sqrt(np.outer(self._masses, self._masses[self._s2pp])) /
+                N / multi)
+        fc *= coef[:, :, None, None]
+        return fc
+
+    def get_dynamical_matrices(self, force_constants):
+        N = len(self._commensurate_points)
+        n_p = self._num_patom
+        multi = self._multiplicity.T
+        fc = force_constants / multi[:, :, None, None]
+        grid = np.zeros((n_p, n_p, np.prod(self._mesh), 3, 3), dtype='double')
+        i_p = np.repeat(np.arange(n_p), len(self._s2pp))
+        j_p = np.tile(self._s2pp, n_p)
+        for l in range(multi.max()):
+            mask = (l < multi).ravel()
+            u = self._lattice_grid_index[self._lattice_index[:, :, l].T]
+            np.add.at(grid,
+                      (i_p[mask], j_p[mask], u.ravel()[mask]),
+                      fc.reshape(-1, 3, 3)[mask])
+        grid = grid.transpose(0, 1, 3, 4, 2).reshape(
+            (n_p, n_p, 3, 3) + tuple(self._mesh))
+        grid = np.fft.ifftn(grid, axes=(-3, -2, -1)) * N
+        dm = grid.reshape(n_p, n_p, 3, 3, -1)[..., self._q_index]
+        dm *= self._get_atom_phases(1)[:, :, None, None, :]
+        dm /= np.sqrt(np.outer(self._masses,
+                               self._masses))[:, :, None, None, None]
+        dm = dm.transpose(4, 0, 2, 1, 3).reshape(N, n_p * 3, n_p * 3)
+        # Hermitianized in the same way as DynamicalMatrix
+        return (dm + dm.conj().transpose(0, 2, 1)) / 2
+
+    def _get_atom_phases(self, sign):
+        dpos = self._pos[None, :, :] - self._pos[:, None, :]
+        return np.exp(sign * 2j * np.pi *
+                      np.dot(dpos, self._commensurate_points.T))
+
+
 class DynmatToForceConstants(object):
     def __init__(self,
                  primitive,
                  supercell,
                  frequencies=None,
                  eigenvectors=None,
-                 symprec=1e-5):
+                 symprec=1e-5,
+                 use_fft=True):
         self._primitive = primitive
         self._supercell = supercell
         supercell_matrix = np.linalg.inv(self._primitive.get_primitive_matrix())
@@ -62,6 +169,9 @@ class DynmatToForceConstants(object):
         self._commensurate_points = get_commensurate_points(supercell_matrix)
         (self._shortest_vectors,
          self._multiplicity) = primitive.get_smallest_vectors()
+        self._fft = None
+        if use_fft:
+            self._set_fft(supercell_matrix)
         self._dynmat = None
         n_s = self._supercell.get_number_of_atoms()
         n_p = self._primitive.get_number_of_atoms()
@@ -107,7 +217,28 @@ class DynmatToForceConstants(object):
 
         self._dynmat = np.array(dm, dtype=self._dtype_complex, order='C')
 
+    def _set_fft(self, supercell_matrix):
+        s2p = self._primitive.get_supercell_to_primitive_map()
+        p2p = self._primitive.get_primitive_to_primitive_map()
+        s2pp = np.array([p2p[i] for i in s2p], dtype='intc')
+        lattice_points, lattice_index = get_smallest_vector_lattice_points(
+            self._shortest_vectors,
+            self._multiplicity,
+            self._primitive.get_scaled_positions(),
+            s2pp)
+        if lattice_points is not None:
+            self._fft = CommensurateGridFFT(self._primitive,
+                                            supercell_matrix,
+                                            self._commensurate_points,
+                                            lattice_points,
+                                            lattice_index)
+
     def _inverse_transformation(self):
+        if self._fft is not None:
+            self._force_constants[:] = self._fft.get_force_constants(
+                self._dynmat)
+            return
+
         try:
             import phonopy._phonopy as phonoc
             self._c_inverse_transformation()
@@ -120,6 +251,10 @@ class DynmatToForceConstants(object):
         s2p = self._primitive.get_supercell_to_primitive_map()
         p2p = self._primitive.get_primitive_to_primitive_map()
         s2pp = np.array([p2p[i] for i in s2p], dtype='intc')
+        pos = np.array(self._primitive.get_scaled_positions(),
+                       dtype='double', order='C')
+        lattice_points, lattice_index = get_smallest_vector_lattice_points(
+            self._shortest_vectors, self._multiplicity, pos, s2pp)
 
         phonoc.transform_dynmat_to_fc(self._force_constants,
                                       self._dynmat.view(dtype='double'),
@@ -127,7 +262,10 @@ class DynmatToForceConstants(object):
                                       self._shortest_vectors,
                                       self._multiplicity,
                                       self._primitive.get_masses(),
-                                      s2pp)
+                                      s2pp,
+                                      lattice_points,
+                                      lattice_index,
+                                      pos)
 
     def _py_inverse_transformation(self):
         s2p = self._primitive.get_supercell_to_primitive_map()
@@ -72,11 +72,23 @@ def get_fc2(supercell,
       j: Atom index at which force on the atom is measured.
       a, b: Cartesian direction indices = (0, 1, 2) for i and j, respectively
 
+    With atom_list, force constants are returned in the compact form
+    force_constants[len(atom_list), num_atom, 3, 3]. Only the rows of
+    the displaced atoms are held besides it, i.e., the full
+    (num_atom, num_atom, 3, 3) array is not allocated.
+
     """
 
-    force_constants = np.zeros((supercell.get_number_of_atoms(),
-                                supercell.get_number_of_atoms(),
-                                3, 3), dtype='double')
+    num_atom = supercell.get_number_of_atoms()
+    disp_atom_list = _get_disp_atom_list(dataset)
+    if atom_list is None:
+        force_constants = np.zeros((num_atom, num_atom, 3, 3),
+                                   dtype='double')
+        fc_row_indices = disp_atom_list
+    else:
+        force_constants = np.zeros((len(disp_atom_list), num_atom, 3, 3),
+                                   dtype='double')
+        fc_row_indices = np.arange(len(disp_atom_list))
 
     # Fill force_constants[ displaced_atoms, all_atoms_in_supercell ]
     atom_list_done = _get_force_constants_disps(
@@ -84,7 +96,8 @@ def get_fc2(supercell,
         supercell,
         dataset,
         symmetry,
-        computation_algorithm=computation_algorithm)
+        computation_algorithm=computation_algorithm,
+        fc_row_indices=fc_row_indices)
 
     # Distribute non-equivalent force constants to those equivalent
     symprec = symmetry.get_symmetry_tolerance()
@@ -103,6 +116,9 @@ def get_fc2(supercell,
                                    trans,
                                    symprec)
     else:
+        fc_compress = np.zeros((len(atom_list),
+                                supercell.get_number_of_atoms(),
+                                3, 3), dtype='double')
         distribute_force_constants(force_constants,
                                    atom_list,
                                    atom_list_done,
@@ -110,19 +126,15 @@ def get_fc2(supercell,
                                    positions,
                                    rotations,
                                    trans,
-                                   symprec)
+                                   symprec,
+                                   compact_force_constants=fc_compress,
+                                   is_done_rows_only=True)
+        force_constants = fc_compress
 
     if decimals:
         force_constants = force_constants.round(decimals=decimals)
 
-    if atom_list is not None:
-        fc_compress = np.zeros((len(atom_list),
-                                supercell.get_number_of_atoms(),
-                                3, 3), dtype='double')
-        fc_compress[:] = force_constants[atom_list]
-        return fc_compress
-    else:
-        return force_constants
+    return force_constants
 
 def cutoff_force_constants(force_constants,
                            supercell,
@@ -155,7 +167,7 @@ def symmetrize_force_constants(force_constants, iteration=1):
 
     try:
         import phonopy._phonopy as phonoc
-        phonoc.perm_trans_symmetrize_fc(force_constants)
+        phonoc.perm_trans_symmetrize_fc(force_constants, iteration)
     except ImportError:
         for i in range(iteration):
             set_permutation_symmetry(force_constants)
@@ -165,13 +177,15 @@ def symmetrize_compact_force_constants(force_constants,
                                        supercell,
                                        symmetry,
                                        s2p_map,
-                                       p2s_map):
+                                       p2s_map,
+                                       iteration=1):
     """Symmetry force constants by translational and permutation symmetries.
 
     Here force constants are stored in a compact form:
     (n_patom, n_satom, 3, 3).
 
-    For the symmetrization, permutation array is necessary.
+    For the symmetrization, permutation array is necessary. The
+    symmetrization is done in place without a copy of force constants.
 
     """
 
@@ -197,7 +211,8 @@ def symmetrize_compact_force_constants(force_constants,
         phonoc.perm_trans_symmetrize_compact_fc(force_constants,
                                                 permutations,
                                                 s2p_map,
-                                                p2s_map)
+                                                p2s_map,
+                                                iteration)
     except ImportError:
         print("Import error at phonoc.perm_trans_symmetrize_compact_fc.")
         print("Corresponding pytono code is not implemented.")
@@ -211,7 +226,18 @@ def distribute_force_constants(force_constants,
                                positions, # scaled (fractional)
                                rotations, # scaled (fractional)
                                trans, # scaled (fractional)
-                               symprec):
+                               symprec,
+                               compact_force_constants=None,
+                               is_done_rows_only=False):
+    """Distribute force constants of atom_list_done to those of atom_list
+
+    When compact_force_constants of shape (len(atom_list), num_atom, 3, 3)
+    is given, the force constants of atom_list are written there and
+    force_constants is only read. If is_done_rows_only=True in addition,
+    force_constants has shape (len(atom_list_done), num_atom, 3, 3) and
+    holds the rows of atom_list_done in that order.
+
+    """
     permutations = _compute_all_sg_permutations(positions,
                                                 rotations,
                                                 trans,
@@ -225,13 +251,21 @@ def distribute_force_constants(force_constants,
                                for r in rotations],
                               dtype='double', order='C')
 
+    if is_done_rows_only:
+        done_rows = np.zeros(len(positions), dtype='intc') - 1
+        done_rows[atom_list_done] = np.arange(len(atom_list_done))
+    else:
+        done_rows = None
+
     import phonopy._phonopy as phonoc
     phonoc.distribute_fc2_with_mappings(force_constants,
                                         np.array(atom_list, dtype='intc'),
                                         rots_cartesian,
                                         permutations,
                                         np.array(map_atoms, dtype='intc'),
-                                        np.array(map_syms, dtype='intc'))
+                                        np.array(map_syms, dtype='intc'),
+                                        compact_force_constants,
+                                        done_rows)
 
 def solve_force_constants(force_constants,
                           disp_atom_number,
@@ -241,25 +275,14 @@ def solve_force_constants(force_constants,
                           site_symmetry,
                           symprec,
                           computation_algorithm="svd"):
-    if computation_algorithm == "regression":
-        fc_info = _solve_force_constants_regression(
-            force_constants,
-            disp_atom_number,
-            displacements,
-            sets_of_forces,
-            supercell,
-            site_symmetry,
-            symprec)
-        return fc_info
-    else:
-        _solve_force_constants_svd(force_constants,
-                                   disp_atom_number,
-                                   displacements,
-                                   sets_of_forces,
-                                   supercell,
-                                   site_symmetry,
-                                   symprec)
-        return None
+    return _solve_force_constants_row(force_constants[disp_atom_number],
+                                      disp_atom_number,
+                                      displacements,
+                                      sets_of_forces,
+                                      supercell,
+                                      site_symmetry,
+                                      symprec,
+                                      computation_algorithm)
 
 def get_positions_sent_by_rot_inv(lattice, # column vectors
                                   positions,
@@ -562,7 +585,37 @@ def show_drift_force_constants(force_constants, name="force constants"):
 #################
 # Local methods #
 #################
-def _solve_force_constants_svd(force_constants,
+def _solve_force_constants_row(fc_row,
+                               disp_atom_number,
+                               displacements,
+                               sets_of_forces,
+                               supercell,
+                               site_symmetry,
+                               symprec,
+                               computation_algorithm):
+    """Solve force_constants[disp_atom_number] written in fc_row"""
+
+    if computation_algorithm == "regression":
+        fc_info = _solve_force_constants_regression(
+            fc_row,
+            disp_atom_number,
+            displacements,
+            sets_of_forces,
+            supercell,
+            site_symmetry,
+            symprec)
+        return fc_info
+    else:
+        _solve_force_constants_svd(fc_row,
+                                   disp_atom_number,
+                                   displacements,
+                                   sets_of_forces,
+                                   supercell,
+                                   site_symmetry,
+                                   symprec)
+        return None
+
+def _solve_force_constants_svd(fc_row,
                                disp_atom_number,
                                displacements,
                                sets_of_forces,
@@ -590,10 +643,9 @@ def _solve_force_constants_svd(force_constants,
                                    site_sym_cart))
 
         combined_forces = np.reshape(combined_forces, (-1, 3))
-        force_constants[disp_atom_number, i] = -np.dot(
-            inv_displacements, combined_forces)
+        fc_row[i] = -np.dot(inv_displacements, combined_forces)
 
-def _solve_force_constants_regression(force_constants,
+def _solve_force_constants_regression(fc_row,
                                       disp_atom_number,
                                       displacements,
                                       sets_of_forces,
@@ -640,14 +692,13 @@ def _solve_force_constants_regression(force_constants,
             for y in range(3):
                 xLin = rot_disps.T[x]
                 yLin = combined_forces.T[y]
-                force_constants[disp_atom_number,i,x,y] = \
-                      -np.dot(xLin,yLin) / np.dot(xLin,xLin)
+                fc_row[i,x,y] = -np.dot(xLin,yLin) / np.dot(xLin,xLin)
                 if len(xLin)<=1:
                     # no chances for a fitting error, we have just one value
                     err = 0
                 else:
                     variance = np.dot(yLin,yLin)/np.dot(xLin,xLin) - \
-                                  force_constants[disp_atom_number,i,x,y]**2
+                                  fc_row[i,x,y]**2
                     if variance<0 and variance>-1e-10:
                        # in numerics, it happens. This is "numerical zero"
                        err = 0
@@ -661,7 +712,8 @@ def _get_force_constants_disps(force_constants,
                                supercell,
                                dataset,
                                symmetry,
-                               computation_algorithm="svd"):
+                               computation_algorithm="svd",
+                               fc_row_indices=None):
     """Calculate force constants Phi = -F / d
 
     Force constants are obtained by one of the following algorithm.
@@ -677,11 +729,17 @@ def _get_force_constants_disps(force_constants,
          FCs are spread. Such an FC 'error' is calculated separately for every
          tensor element. At the end we report their average value. We also
          report a maximum value among these tensor-elements-errors.
+
+    Force constants of i-th displaced atom are written in
+    force_constants[fc_row_indices[i]]. By default fc_row_indices are
+    the displaced atom numbers.
     """
 
     symprec = symmetry.get_symmetry_tolerance()
-    disp_atom_list = np.unique([x['number'] for x in dataset['first_atoms']])
-    for disp_atom_number in disp_atom_list:
+    disp_atom_list = _get_disp_atom_list(dataset)
+    if fc_row_indices is None:
+        fc_row_indices = disp_atom_list
+    for disp_atom_number, fc_row_index in zip(disp_atom_list, fc_row_indices):
         disps = []
         sets_of_forces = []
 
@@ -693,15 +751,15 @@ def _get_force_constants_disps(force_constants,
 
         site_symmetry = symmetry.get_site_symmetry(disp_atom_number)
 
-        fc_info = solve_force_constants(
-            force_constants,
+        fc_info = _solve_force_constants_row(
+            force_constants[fc_row_index],
             disp_atom_number,
             disps,
             sets_of_forces,
             supercell,
             site_symmetry,
             symprec,
-            computation_algorithm=computation_algorithm)
+            computation_algorithm)
 
         if fc_info is not None:
             # KL(m)
@@ -716,6 +774,9 @@ def _get_force_constants_disps(force_constants,
 
     return disp_atom_list
 
+def _get_disp_atom_list(dataset):
+    return np.unique([x['number'] for x in dataset['first_atoms']])
+
 def _combine_force_constants_equivalent_atoms(fc_combined,
                                               force_constants,
                                               i,
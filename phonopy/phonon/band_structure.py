@@ -34,25 +34,62 @@
 
 import numpy as np
 from phonopy.units import VaspToTHz
+from phonopy.phonon.solver import get_phonons_at_qpoints
 
 def estimate_band_connection(prev_eigvecs, eigvecs, prev_band_order):
     metric = np.abs(np.dot(prev_eigvecs.conjugate().T, eigvecs))
-    connection_order = []
-    for overlaps in metric:
-        maxval = 0
-        for i in reversed(range(len(metric))):
-            val = overlaps[i]
-            if i in connection_order:
-                continue
-            if val > maxval:
-                maxval = val
-                maxindex = i
-        connection_order.append(maxindex)
-
+    connection_order = _get_connection_order(metric)
     band_order = [connection_order[x] for x in prev_band_order]
 
     return band_order
 
+def get_band_connection_orders(eigenvectors):
+    """Estimate band orders along a path from eigenvector overlaps
+
+    Overlaps between neighbouring q-points are computed for all
+    q-points at once. Only the band assignment runs sequentially.
+
+    Args:
+        eigenvectors: Eigenvectors on a path given as column vectors
+            with the shape of (num_qpoints, num_band, num_band).
+
+    Returns:
+        Band orders with the shape of (num_qpoints, num_band). Bands of
+        i-th q-point are connected by eigenvalues[i][band_orders[i]].
+
+    """
+    num_qpoints, num_band = eigenvectors.shape[:2]
+    band_orders = np.zeros((num_qpoints, num_band), dtype='intc')
+    band_orders[0] = np.arange(num_band)
+    if num_qpoints < 2:
+        return band_orders
+
+    metrics = np.abs(np.matmul(
+        eigenvectors[:-1].conjugate().transpose(0, 2, 1), eigenvectors[1:]))
+    for i, metric in enumerate(metrics):
+        connection_order = _get_connection_order(metric)
+        band_orders[i + 1] = connection_order[band_orders[i]]
+
+    return band_orders
+
+def _get_connection_order(metric):
+    """Connect each band to the unassigned band with the largest overlap
+
+    Bands are assigned in order. Among equal overlaps, the band with
+    the larger index is chosen.
+
+    """
+    num_band = len(metric)
+    connection_order = np.zeros(num_band, dtype='intc')
+    is_free = np.ones(num_band, dtype='bool')
+    for i, overlaps in enumerate(metric):
+        candidates = np.where(is_free, overlaps, -1)
+        j = num_band - 1 - np.argmax(candidates[::-1])
+        connection_order[i] = j
+        is_free[j] = False
+
+    return connection_order
+
 def get_band_qpoints(band_paths, npoints):
     """Generate qpoints for band structure path
 
@@ -285,21 +322,23 @@ class BandStructure(object):
         eigvecs = []
         group_velocities = []
         distances = []
-        is_nac = self._dynamical_matrix.is_nac()
 
-        for path in self._paths:
+        for path, frequencies, eigenvectors in zip(
+                self._paths, *self._solve_phonons_on_paths()):
             self._set_initial_point(path[0])
 
             (distances_on_path,
              eigvals_on_path,
              eigvecs_on_path,
-             gv_on_path) = self._solve_dm_on_path(path)
+             gv_on_path) = self._solve_dm_on_path(path,
+                                                  frequencies,
+                                                  eigenvectors)
 
-            eigvals.append(np.array(eigvals_on_path))
+            eigvals.append(eigvals_on_path)
             if self._is_eigenvectors:
-                eigvecs.append(np.array(eigvecs_on_path))
+                eigvecs.append(eigvecs_on_path)
             if self._group_velocity is not None:
-                group_velocities.append(np.array(gv_on_path))
+                group_velocities.append(gv_on_path)
             distances.append(np.array(distances_on_path))
             self._special_points.append(self._distance)
 
@@ -312,58 +351,81 @@ class BandStructure(object):
 
         self._set_frequencies()
 
-    def _solve_dm_on_path(self, path):
-        is_nac = self._dynamical_matrix.is_nac()
-        distances_on_path = []
-        eigvals_on_path = []
-        eigvecs_on_path = []
-        gv_on_path = []
+    def _solve_phonons_on_paths(self):
+        """Solve phonons at q-points of all paths
 
-        if self._group_velocity is not None:
-            self._group_velocity.set_q_points(path)
-            gv = self._group_velocity.get_group_velocity()
+        Without NAC, q-points of all paths are solved in one batch.
+        With NAC, the q-direction used at Gamma point depends on path,
+        so paths are solved one by one.
 
-        for i, q in enumerate(path):
-            self._shift_point(q)
-            distances_on_path.append(self._distance)
+        Returns:
+            Lists of frequencies and eigenvectors (or None) of paths.
 
-            if is_nac:
+        """
+        if self._dynamical_matrix.is_nac():
+            batches = [[path] for path in self._paths]
+        else:
+            batches = [self._paths]
+
+        frequencies_of_paths = []
+        eigenvectors_of_paths = []
+        num_band = self._cell.get_number_of_atoms() * 3
+        for paths in batches:
+            qpoints = np.concatenate(paths)
+            frequencies = np.zeros((len(qpoints), num_band), dtype='double')
+            if self._is_eigenvectors:
+                eigenvectors = np.zeros(
+                    (len(qpoints), num_band, num_band),
+                    dtype=("c%d" % (frequencies.itemsize * 2)))
+            else:
+                eigenvectors = None
+            if self._dynamical_matrix.is_nac():
+                q_direction = paths[0][0] - paths[0][-1] # Used only at Gamma
+            else:
                 q_direction = None
-                if (np.abs(q) < 0.0001).all(): # For Gamma point
-                    q_direction = path[0] - path[-1]
-                self._dynamical_matrix.set_dynamical_matrix(
-                    q, q_direction=q_direction)
+            get_phonons_at_qpoints(frequencies,
+                                   eigenvectors,
+                                   self._dynamical_matrix,
+                                   qpoints,
+                                   self._factor,
+                                   nac_q_direction=q_direction)
+            indices = np.cumsum([len(path) for path in paths])[:-1]
+            frequencies_of_paths += np.split(frequencies, indices)
+            if eigenvectors is None:
+                eigenvectors_of_paths += [None] * len(paths)
             else:
-                self._dynamical_matrix.set_dynamical_matrix(q)
-            dm = self._dynamical_matrix.get_dynamical_matrix()
+                eigenvectors_of_paths += np.split(eigenvectors, indices)
 
-            if self._is_eigenvectors:
-                eigvals, eigvecs = np.linalg.eigh(dm)
-                eigvals = eigvals.real
-            else:
-                eigvals = np.linalg.eigvalsh(dm).real
+        return frequencies_of_paths, eigenvectors_of_paths
 
-            if self._is_band_connection:
-                if i == 0:
-                    band_order = range(len(eigvals))
-                else:
-                    band_order = estimate_band_connection(prev_eigvecs,
-                                                          eigvecs,
-                                                          band_order)
-                eigvals_on_path.append(eigvals[band_order])
-                eigvecs_on_path.append((eigvecs.T)[band_order].T)
-
-                if self._group_velocity is not None:
-                    gv_on_path.append(gv[i][band_order])
-                prev_eigvecs = eigvecs
-            else:
-                eigvals_on_path.append(eigvals)
-                if self._is_eigenvectors:
-                    eigvecs_on_path.append(eigvecs)
-                if self._group_velocity is not None:
-                    gv_on_path.append(gv[i])
+    def _solve_dm_on_path(self, path, frequencies, eigenvectors):
+        distances_on_path = []
+        for q in path:
+            self._shift_point(q)
+            distances_on_path.append(self._distance)
 
-        return distances_on_path, eigvals_on_path, eigvecs_on_path, gv_on_path
+        if self._group_velocity is not None:
+            self._group_velocity.set_q_points(path,
+                                              frequencies=frequencies,
+                                              eigenvectors=eigenvectors)
+            gv = self._group_velocity.get_group_velocity()
+        else:
+            gv = None
+
+        eigenvalues = (frequencies ** 2 * np.sign(frequencies) /
+                       self._factor ** 2)
+
+        if self._is_band_connection:
+            band_orders = get_band_connection_orders(eigenvectors)
+            i_q = np.arange(len(path))[:, None]
+            eigenvalues = eigenvalues[i_q, band_orders]
+            eigenvectors = eigenvectors[i_q[:, None],
+                                        np.arange(eigenvectors.shape[1])[:, None],
+                                        band_orders[:, None, :]]
+            if gv is not None:
+                gv = gv[i_q, band_orders]
+
+        return distances_on_path, eigenvalues, eigenvectors, gv
 
     def _set_frequencies(self):
         frequencies = []
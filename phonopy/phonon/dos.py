@@ -34,8 +34,8 @@
 
 import sys
 import numpy as np
+from phonopy.phonon.mesh import IterMesh
 from phonopy.phonon.tetrahedron_mesh import TetrahedronMesh
-from phonopy.structure.tetrahedron_method import TetrahedronMethod
 
 def write_total_dos(frequency_points,
                     total_dos,
@@ -166,14 +166,9 @@ def run_tetrahedron_method_dos(mesh,
         print("Phonopy C-extension has to be built properly.")
         sys.exit(1)
 
-    if coef is None:
-        _coef = np.ones((frequencies.shape[0], 1, frequencies.shape[1]),
-                        dtype='double')
-    else:
-        _coef = np.array(coef, dtype='double', order='C')
-    arr_shape = frequencies.shape + (len(frequency_points), _coef.shape[1])
-    dos = np.zeros(arr_shape, dtype='double')
-
+    dos, _coef = _get_tetrahedron_method_dos_arrays(frequency_points,
+                                                    frequencies,
+                                                    coef)
     phonoc.tetrahedron_method_dos(dos,
                                   mesh,
                                   frequency_points,
@@ -182,6 +177,51 @@ def run_tetrahedron_method_dos(mesh,
                                   grid_address,
                                   grid_mapping_table,
                                   relative_grid_address)
+    return _sum_tetrahedron_method_dos(dos, mesh, coef)
+
+def run_tetrahedron_method_dos_with_vertices(mesh,
+                                             frequency_points,
+                                             frequencies,
+                                             weights,
+                                             tetrahedra_vertices,
+                                             coef=None):
+    """Tetrahedron method DOS using precomputed tetrahedra vertices
+
+    weights are those of ir-grid-points and tetrahedra_vertices with
+    shape=(num_ir_grid_points, 24, 4) are indices of ir-grid-points as
+    given by Mesh.get_tetrahedra_vertices.
+
+    """
+    try:
+        import phonopy._phonopy as phonoc
+    except ImportError:
+        import sys
+        print("Phonopy C-extension has to be built properly.")
+        sys.exit(1)
+
+    dos, _coef = _get_tetrahedron_method_dos_arrays(frequency_points,
+                                                    frequencies,
+                                                    coef)
+    phonoc.tetrahedron_method_dos_with_vertices(
+        dos,
+        np.array(frequency_points, dtype='double'),
+        frequencies,
+        _coef,
+        np.array(weights, dtype='intc'),
+        tetrahedra_vertices)
+    return _sum_tetrahedron_method_dos(dos, mesh, coef)
+
+def _get_tetrahedron_method_dos_arrays(frequency_points, frequencies, coef):
+    if coef is None:
+        _coef = np.ones((frequencies.shape[0], 1, frequencies.shape[1]),
+                        dtype='double')
+    else:
+        _coef = np.array(coef, dtype='double', order='C')
+    arr_shape = frequencies.shape + (len(frequency_points), _coef.shape[1])
+    dos = np.zeros(arr_shape, dtype='double')
+    return dos, _coef
+
+def _sum_tetrahedron_method_dos(dos, mesh, coef):
     if coef is None:
         return dos[:,:,:,0].sum(axis=0).sum(axis=0) / np.prod(mesh)
     else:
@@ -199,7 +239,8 @@ class Dos(object):
                 mesh_object.get_mesh_numbers(),
                 mesh_object.get_grid_address(),
                 mesh_object.get_grid_mapping_table(),
-                mesh_object.get_ir_grid_points())
+                mesh_object.get_ir_grid_points(),
+                tetrahedra_vertices=mesh_object.get_tetrahedra_vertices())
         else:
             self._tetrahedron_mesh = None
 
@@ -277,17 +318,12 @@ class TotalDos(Dos):
                     self._dos += np.sum(iw * self._weights[i], axis=1)
 
     def _run_tetrahedron_method_dos(self):
-        mesh = self._mesh_object.get_mesh_numbers()
-        cell = self._mesh_object.get_dynamical_matrix().get_primitive()
-        reciprocal_lattice = np.linalg.inv(cell.get_cell())
-        tm = TetrahedronMethod(reciprocal_lattice, mesh=mesh)
-        self._dos = run_tetrahedron_method_dos(
-            mesh,
+        self._dos = run_tetrahedron_method_dos_with_vertices(
+            self._mesh_object.get_mesh_numbers(),
             self._frequency_points,
             self._frequencies,
-            self._mesh_object.get_grid_address(),
-            self._mesh_object.get_grid_mapping_table(),
-            tm.get_tetrahedra())
+            self._weights,
+            self._tetrahedron_mesh.get_tetrahedra_vertices())
 
     def get_dos(self):
         """
@@ -374,33 +410,66 @@ class PartialDos(Dos):
                  tetrahedron_method=False,
                  direction=None,
                  xyz_projection=False):
+        self._direction = direction
+        self._xyz_projection = xyz_projection
+        self._eigvecs2 = None
+        if isinstance(mesh_object, IterMesh):
+            if not mesh_object.is_eigenvectors():
+                raise RuntimeError("PartialDos requires IterMesh with "
+                                   "is_eigenvectors=True.")
+            # Phonons are solved block by block and only projected
+            # squared eigenvectors are stored.
+            self._eigenvectors = None
+            num_band = mesh_object.get_dynamical_matrix().get_dimension()
+            if xyz_projection:
+                num_pdos = num_band
+            else:
+                num_pdos = num_band // 3
+            self._eigvecs2 = np.zeros(
+                (len(mesh_object.get_qpoints()), num_pdos, num_band),
+                dtype='double')
+            mesh_object.add_consumer(self._set_eigvecs2)
+            mesh_object.run()
+            mesh_object.remove_consumer(self._set_eigvecs2)
+
         Dos.__init__(self,
                      mesh_object,
                      sigma=sigma,
                      tetrahedron_method=tetrahedron_method)
-        self._eigenvectors = self._mesh_object.get_eigenvectors()
         self._partial_dos = None
+        if self._eigvecs2 is None:
+            self._eigenvectors = mesh_object.get_eigenvectors()
+            if self._eigenvectors is None:
+                raise RuntimeError("PartialDos requires eigenvectors. "
+                                   "Mesh has to be run with "
+                                   "is_eigenvectors=True.")
+            self._eigvecs2 = self._get_eigvecs2(self._eigenvectors)
+
+        self._openmp_thm = True
+
+    def _set_eigvecs2(self, q_indices, frequencies, eigenvectors):
+        self._eigvecs2[q_indices] = self._get_eigvecs2(eigenvectors)
 
-        if xyz_projection:
-            self._eigvecs2 = np.abs(self._eigenvectors) ** 2
+    def _get_eigvecs2(self, eigenvectors):
+        if self._xyz_projection:
+            return np.abs(eigenvectors) ** 2
         else:
-            num_atom = self._frequencies.shape[1] // 3
+            num_atom = eigenvectors.shape[1] // 3
             i_x = np.arange(num_atom, dtype='int') * 3
             i_y = np.arange(num_atom, dtype='int') * 3 + 1
             i_z = np.arange(num_atom, dtype='int') * 3 + 2
-            if direction is None:
-                self._eigvecs2 = np.abs(self._eigenvectors[:, i_x, :]) ** 2
-                self._eigvecs2 += np.abs(self._eigenvectors[:, i_y, :]) ** 2
-                self._eigvecs2 += np.abs(self._eigenvectors[:, i_z, :]) ** 2
+            if self._direction is None:
+                eigvecs2 = np.abs(eigenvectors[:, i_x, :]) ** 2
+                eigvecs2 += np.abs(eigenvectors[:, i_y, :]) ** 2
+                eigvecs2 += np.abs(eigenvectors[:, i_z, :]) ** 2
             else:
-                d = np.array(direction, dtype='double')
-                d /= np.linalg.norm(direction)
-                proj_eigvecs = self._eigenvectors[:, i_x, :] * d[0]
-                proj_eigvecs += self._eigenvectors[:, i_y, :] * d[1]
-                proj_eigvecs += self._eigenvectors[:, i_z, :] * d[2]
-                self._eigvecs2 = np.abs(proj_eigvecs) ** 2
-
-        self._openmp_thm = True
+                d = np.array(self._direction, dtype='double')
+                d /= np.linalg.norm(self._direction)
+                proj_eigvecs = eigenvectors[:, i_x, :] * d[0]
+                proj_eigvecs += eigenvectors[:, i_y, :] * d[1]
+                proj_eigvecs += eigenvectors[:, i_z, :] * d[2]
+                eigvecs2 = np.abs(proj_eigvecs) ** 2
+            return eigvecs2
 
     def run(self):
         if self._tetrahedron_mesh is None:
@@ -433,17 +502,12 @@ class PartialDos(Dos):
             self._partial_dos += np.dot(iw * w, self._eigvecs2[i].T).T
 
     def _run_tetrahedron_method_dos(self):
-        mesh = self._mesh_object.get_mesh_numbers()
-        cell = self._mesh_object.get_dynamical_matrix().get_primitive()
-        reciprocal_lattice = np.linalg.inv(cell.get_cell())
-        tm = TetrahedronMethod(reciprocal_lattice, mesh=mesh)
-        pdos = run_tetrahedron_method_dos(
-            mesh,
+        pdos = run_tetrahedron_method_dos_with_vertices(
+            self._mesh_object.get_mesh_numbers(),
             self._frequency_points,
             self._frequencies,
-            self._mesh_object.get_grid_address(),
-            self._mesh_object.get_grid_mapping_table(),
-            tm.get_tetrahedra(),
+            self._weights,
+            self._tetrahedron_mesh.get_tetrahedra_vertices(),
             coef=self._eigvecs2)
         self._partial_dos = pdos.T
 
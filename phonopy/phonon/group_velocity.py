@@ -38,6 +38,7 @@ from phonopy.units import VaspToTHz
 from phonopy.harmonic.derivative_dynmat import DerivativeOfDynamicalMatrix
 from phonopy.harmonic.force_constants import similarity_transformation
 from phonopy.phonon.degeneracy import degenerate_sets
+from phonopy.phonon.solver import get_phonons_at_qpoints
 
 def get_group_velocity(q, # q-point
                        dynamical_matrix,
@@ -92,12 +93,16 @@ class GroupVelocity(object):
                  symmetry=None,
                  frequency_factor_to_THz=VaspToTHz,
                  cutoff_frequency=1e-4,
-                 log_level=0):
+                 log_level=0,
+                 block_size=64):
         """
         q_points is a list of sets of q-point and q-direction:
         [[q-point, q-direction], [q-point, q-direction], ...]
 
         q_length is used such as D(q + q_length) - D(q - q_length).
+
+        block_size is the number of q-points whose eigenvectors are held
+        at a time when phonons have to be solved here.
         """
         self._dynmat = dynamical_matrix
         primitive = dynamical_matrix.get_primitive()
@@ -122,8 +127,15 @@ class GroupVelocity(object):
         else:
             self._ddm = None
         self._symmetry = symmetry
+        self._rotations_cartesian = None
+        if self._symmetry is not None:
+            self._rotations_cartesian = np.array(
+                [similarity_transformation(self._reciprocal_lattice, r)
+                 for r in self._symmetry.get_reciprocal_operations()],
+                dtype='double', order='C')
         self._factor = frequency_factor_to_THz
         self._cutoff_frequency = cutoff_frequency
+        self._block_size = block_size
 
         self._directions = np.array([[1, 2, 3],
                                      [1, 0, 0],
@@ -135,7 +147,19 @@ class GroupVelocity(object):
         self._group_velocity = None
         self._perturbation = None
 
-    def set_q_points(self, q_points, perturbation=None):
+    def set_q_points(self,
+                     q_points,
+                     perturbation=None,
+                     frequencies=None,
+                     eigenvectors=None):
+        """Compute group velocities at q-points
+
+        frequencies and eigenvectors at q_points may be given when they
+        have been already computed, e.g., by Mesh, with the same unit
+        conversion factor. They are used by the C implementation
+        instead of solving phonons again.
+
+        """
         self._q_points = q_points
         self._perturbation = perturbation
         if perturbation is None:
@@ -144,7 +168,8 @@ class GroupVelocity(object):
             self._directions[0] = np.dot(
                 self._reciprocal_lattice, perturbation)
         self._directions[0] /= np.linalg.norm(self._directions[0])
-        self._set_group_velocity()
+        self._set_group_velocity(frequencies=frequencies,
+                                 eigenvectors=eigenvectors)
 
     def set_q_length(self, q_length):
         self._q_length = q_length
@@ -155,9 +180,71 @@ class GroupVelocity(object):
     def get_group_velocity(self):
         return self._group_velocity
 
-    def _set_group_velocity(self):
-        gv = [self._set_group_velocity_at_q(q) for q in self._q_points]
-        self._group_velocity = np.array(gv)
+    def _set_group_velocity(self, frequencies=None, eigenvectors=None):
+        if self._is_c_group_velocity():
+            self._set_c_group_velocity(frequencies=frequencies,
+                                       eigenvectors=eigenvectors)
+        else:
+            gv = [self._set_group_velocity_at_q(q) for q in self._q_points]
+            self._group_velocity = np.array(gv)
+
+    def _is_c_group_velocity(self):
+        if self._ddm is None:
+            return False
+        try:
+            from phonopy._phonopy import group_velocities
+        except ImportError:
+            return False
+        return True
+
+    def _set_c_group_velocity(self, frequencies=None, eigenvectors=None):
+        q_points = np.array(self._q_points, dtype='double', order='C')
+        if frequencies is None or eigenvectors is None:
+            # Phonons are solved by block_size q-points and each block of
+            # eigenvectors is discarded after use.
+            num_band = self._dynmat.get_dimension()
+            dtype = "c%d" % (np.dtype('double').itemsize * 2)
+            gv = np.zeros((len(q_points), num_band, 3), dtype='double')
+            for i in range(0, len(q_points), self._block_size):
+                j = min(i + self._block_size, len(q_points))
+                freqs = np.zeros((j - i, num_band), dtype='double')
+                eigvecs = np.zeros((j - i, num_band, num_band), dtype=dtype)
+                get_phonons_at_qpoints(freqs,
+                                       eigvecs,
+                                       self._dynmat,
+                                       q_points[i:j],
+                                       self._factor)
+                gv[i:j] = self._get_c_group_velocities(q_points[i:j],
+                                                       freqs,
+                                                       eigvecs)
+        else:
+            gv = self._get_c_group_velocities(q_points,
+                                              frequencies,
+                                              eigenvectors)
+        self._group_velocity = gv
+
+    def _get_c_group_velocities(self, q_points, frequencies, eigenvectors):
+        import phonopy._phonopy as phonoc
+
+        dtype = "c%d" % (np.dtype('double').itemsize * 2)
+        freqs = np.array(frequencies, dtype='double', order='C')
+        eigvecs = np.array(eigenvectors, dtype=dtype, order='C')
+        gv = np.zeros(freqs.shape + (3,), dtype='double')
+        num_failed = phonoc.group_velocities(
+            gv,
+            freqs,
+            eigvecs,
+            q_points,
+            np.array(self._directions[0], dtype='double'),
+            *(self._ddm._get_c_arguments() +
+              (self._factor, self._cutoff_frequency, 1e-4)))
+        if num_failed > 0:
+            raise RuntimeError("Diagonalization by LAPACK zheev failed "
+                               "at %d degenerate subspaces." % num_failed)
+
+        if self._perturbation is None:
+            self._symmetrize_group_velocities(gv, q_points)
+        return gv
 
     def _set_group_velocity_at_q(self, q):
         self._dynmat.set_dynamical_matrix(q)
@@ -185,20 +272,30 @@ class GroupVelocity(object):
         else:
             return gv
 
+    def _symmetrize_group_velocities(self, gv, q_points):
+        """Symmetrize group velocities at q-points in place"""
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            for i, q in enumerate(q_points):
+                gv[i] = self._symmetrize_group_velocity(gv[i], q)
+        else:
+            phonoc.symmetrize_group_velocities(
+                gv,
+                np.array(q_points, dtype='double', order='C'),
+                np.array(self._symmetry.get_reciprocal_operations(),
+                         dtype='intc', order='C'),
+                self._rotations_cartesian,
+                self._symmetry.get_symmetry_tolerance())
+
     def _symmetrize_group_velocity(self, gv, q):
-        rotations = []
-        for r in self._symmetry.get_reciprocal_operations():
-            q_in_BZ = q - np.rint(q)
-            diff = q_in_BZ - np.dot(r, q_in_BZ)
-            if (np.abs(diff) < self._symmetry.get_symmetry_tolerance()).all():
-                rotations.append(r)
-
-        gv_sym = np.zeros_like(gv)
-        for r in rotations:
-            r_cart = similarity_transformation(self._reciprocal_lattice, r)
-            gv_sym += np.dot(r_cart, gv.T).T
-
-        return gv_sym / len(rotations)
+        rotations = self._symmetry.get_reciprocal_operations()
+        q_in_BZ = q - np.rint(q)
+        diff = q_in_BZ - np.dot(rotations, q_in_BZ)
+        is_little = (np.abs(diff) <
+                     self._symmetry.get_symmetry_tolerance()).all(axis=1)
+        r_cart = self._rotations_cartesian[is_little].mean(axis=0)
+        return np.dot(gv, r_cart.T)
 
     def _get_dD(self, q):
         if self._q_length is None:
@@ -32,9 +32,14 @@
 # ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 # POSSIBILITY OF SUCH DAMAGE.
 
+import os
 import numpy as np
 from phonopy.units import VaspToTHz
 from phonopy.structure.grid_points import GridPoints
+from phonopy.structure.tetrahedron_method import TetrahedronMethod
+from phonopy.phonon.tetrahedron_mesh import (get_tetrahedra_vertices,
+                                             get_gp_ir_index)
+from phonopy.phonon.solver import get_phonons_at_qpoints
 
 class MeshBase(object):
     def __init__(self,
@@ -68,6 +73,7 @@ class MeshBase(object):
         self._frequencies = None
         self._eigenvalues = None
         self._eigenvectors = None
+        self._tetrahedra_vertices = None
 
     def get_dynamical_matrix(self):
         return self._dynamical_matrix
@@ -90,6 +96,27 @@ class MeshBase(object):
     def get_grid_mapping_table(self):
         return self._gp.get_grid_mapping_table()
 
+    def get_tetrahedra_vertices(self):
+        """Return ir-grid-point indices at vertices of 24 tetrahedra
+
+        The shape is (num_ir_grid_points, 24, 4). This depends only on
+        the mesh, so it is computed at the first call and shared by
+        the tetrahedron method calculations on this mesh.
+
+        """
+        if self._tetrahedra_vertices is None:
+            reciprocal_lattice = np.linalg.inv(self._cell.get_cell())
+            tm = TetrahedronMethod(reciprocal_lattice, mesh=self._mesh)
+            ir_grid_points = self.get_ir_grid_points()
+            self._tetrahedra_vertices = get_tetrahedra_vertices(
+                tm.get_tetrahedra(),
+                self._mesh,
+                ir_grid_points,
+                self.get_grid_address(),
+                get_gp_ir_index(self.get_grid_mapping_table(),
+                                ir_grid_points))
+        return self._tetrahedra_vertices
+
     def get_eigenvalues(self):
         return self._eigenvalues
 
@@ -123,7 +150,15 @@ class Mesh(MeshBase):
 
         self._group_velocity = group_velocity
         self._group_velocities = None
-        self._use_lapack_solver = use_lapack_solver
+        # Number of q-points whose eigenvectors are held at a time for
+        # group velocities when eigenvectors are not stored.
+        self._block_size = 64
+        if use_lapack_solver:
+            import warnings
+            warnings.warn("use_lapack_solver is deprecated and ignored. "
+                          "Phonons are solved by LAPACK zheev whenever "
+                          "phonopy is built with LAPACK.",
+                          DeprecationWarning)
 
         self._q_count = 0
 
@@ -145,9 +180,12 @@ class Mesh(MeshBase):
             return self._frequencies[i], self._eigenvectors[i]
 
     def run(self):
-        self._set_phonon()
-        if self._group_velocity is not None:
-            self._set_group_velocities(self._group_velocity)
+        if self._group_velocity is None or self._is_eigenvectors:
+            self._set_phonon()
+            if self._group_velocity is not None:
+                self._set_group_velocities(self._group_velocity)
+        else:
+            self._set_phonon_with_group_velocities(self._group_velocity)
 
     def get_group_velocities(self):
         return self._group_velocities
@@ -224,47 +262,78 @@ class Mesh(MeshBase):
         num_band = self._cell.get_number_of_atoms() * 3
         num_qpoints = len(self._qpoints)
 
-        self._eigenvalues = np.zeros((num_qpoints, num_band), dtype='double')
-        self._frequencies = np.zeros_like(self._eigenvalues)
-        if self._is_eigenvectors or self._use_lapack_solver:
+        self._frequencies = np.zeros((num_qpoints, num_band), dtype='double')
+        if self._is_eigenvectors:
             dtype = "c%d" % (np.dtype('double').itemsize * 2)
             self._eigenvectors = np.zeros(
                 (num_qpoints, num_band, num_band,), dtype=dtype)
 
-        if self._use_lapack_solver:
-            from phono3py.phonon.solver import get_phonons_at_qpoints
-            get_phonons_at_qpoints(self._frequencies,
-                                   self._eigenvectors,
+        get_phonons_at_qpoints(self._frequencies,
+                               self._eigenvectors,
+                               self._dynamical_matrix,
+                               self._qpoints,
+                               self._factor,
+                               lapack_zheev_uplo='L')
+        self._set_eigenvalues()
+
+    def _set_phonon_with_group_velocities(self, group_velocity):
+        """Phonons and group velocities without storing all eigenvectors
+
+        Eigenvectors are solved by block_size q-points, used for group
+        velocities of the block, and discarded.
+
+        """
+        num_band = self._cell.get_number_of_atoms() * 3
+        num_qpoints = len(self._qpoints)
+        dtype = "c%d" % (np.dtype('double').itemsize * 2)
+
+        self._frequencies = np.zeros((num_qpoints, num_band), dtype='double')
+        self._group_velocities = np.zeros((num_qpoints, num_band, 3),
+                                          dtype='double')
+        for i in range(0, num_qpoints, self._block_size):
+            j = min(i + self._block_size, num_qpoints)
+            eigvecs = np.zeros((j - i, num_band, num_band), dtype=dtype)
+            get_phonons_at_qpoints(self._frequencies[i:j],
+                                   eigvecs,
                                    self._dynamical_matrix,
-                                   self._qpoints,
+                                   self._qpoints[i:j],
                                    self._factor,
-                                   nac_q_direction=None,
                                    lapack_zheev_uplo='L')
-            self._eigenvalues = np.array(self._frequencies ** 2 *
-                                         np.sign(self._frequencies),
-                                         dtype='double',
-                                         order='C') / self._factor ** 2
-            if not self._is_eigenvectors:
-                self._eigenvalues = None
-        else:
-            for i, q in enumerate(self._qpoints):
-                self._dynamical_matrix.set_dynamical_matrix(q)
-                dm = self._dynamical_matrix.get_dynamical_matrix()
-                if self._is_eigenvectors:
-                    eigvals, self._eigenvectors[i] = np.linalg.eigh(dm)
-                    self._eigenvalues[i] = eigvals.real
-                else:
-                    self._eigenvalues[i] = np.linalg.eigvalsh(dm).real
-            self._frequencies = np.array(np.sqrt(abs(self._eigenvalues)) *
-                                         np.sign(self._eigenvalues),
-                                         dtype='double',
-                                         order='C') * self._factor
+            group_velocity.set_q_points(self._qpoints[i:j],
+                                        frequencies=self._frequencies[i:j],
+                                        eigenvectors=eigvecs)
+            self._group_velocities[i:j] = group_velocity.get_group_velocity()
+        self._set_eigenvalues()
+
+    def _set_eigenvalues(self):
+        self._eigenvalues = np.array(self._frequencies ** 2 *
+                                     np.sign(self._frequencies),
+                                     dtype='double',
+                                     order='C') / self._factor ** 2
 
     def _set_group_velocities(self, group_velocity):
-        group_velocity.set_q_points(self._qpoints)
+        group_velocity.set_q_points(self._qpoints,
+                                    frequencies=self._frequencies,
+                                    eigenvectors=self._eigenvectors)
         self._group_velocities = group_velocity.get_group_velocity()
 
 class IterMesh(MeshBase):
+    """Phonons on sampling mesh without storing all eigenvectors
+
+    Phonons are solved at block_size q-points at a time. Used as an
+    iterator, phonons are returned q-point by q-point, and only one
+    block of phonons is kept. With run(), every block is passed to the
+    consumers registered by add_consumer and then discarded, i.e., peak
+    memory of eigenvectors is determined by block_size, not by the mesh
+    density. Frequencies at all q-points are kept by run().
+
+    PartialDos, ThermalDisplacements, ThermalDisplacementMatrices, and
+    MeshHDF5Writer consume blocks. ThermalProperties is not streamed and
+    takes the frequencies at all q-points, e.g., from get_frequencies()
+    after run(), and eigenvectors at all q-points with is_projection.
+
+    """
+
     def __init__(self,
                  dynamical_matrix,
                  mesh,
@@ -274,7 +343,8 @@ class IterMesh(MeshBase):
                  is_eigenvectors=False,
                  is_gamma_center=False,
                  rotations=None, # Point group operations in real space
-                 factor=VaspToTHz):
+                 factor=VaspToTHz,
+                 block_size=None):
         MeshBase.__init__(self,
                           dynamical_matrix,
                           mesh,
@@ -286,6 +356,12 @@ class IterMesh(MeshBase):
                           rotations=rotations,
                           factor=factor)
 
+        if block_size is None:
+            self._block_size = 1
+        else:
+            self._block_size = block_size
+        self._consumers = []
+        self._block = None
         self._q_count = 0
 
     def __iter__(self):
@@ -298,17 +374,249 @@ class IterMesh(MeshBase):
         if self._q_count == len(self._qpoints):
             raise StopIteration
         else:
-            q = self._qpoints[self._q_count]
-            self._dynamical_matrix.set_dynamical_matrix(q)
-            dm = self._dynamical_matrix.get_dynamical_matrix()
+            i = self._q_count
+            if self._block is None or i >= self._block[0][-1] + 1:
+                self._block = self._get_block(i)
+            q_indices, freqs, eigvecs = self._block
+            self._frequencies = freqs[i - q_indices[0]]
             if self._is_eigenvectors:
-                eigvals, self._eigenvectors = np.linalg.eigh(dm)
-                self._eigenvalues = eigvals.real
-            else:
-                self._eigenvalues = np.linalg.eigvalsh(dm).real
-            self._frequencies = np.array(np.sqrt(abs(self._eigenvalues)) *
-                                         np.sign(self._eigenvalues),
+                self._eigenvectors = eigvecs[i - q_indices[0]]
+            self._eigenvalues = np.array(self._frequencies ** 2 *
+                                         np.sign(self._frequencies),
                                          dtype='double',
-                                         order='C') * self._factor
+                                         order='C') / self._factor ** 2
             self._q_count += 1
             return self._frequencies, self._eigenvectors
+
+    def get_block_size(self):
+        return self._block_size
+
+    def is_eigenvectors(self):
+        return self._is_eigenvectors
+
+    def add_consumer(self, consumer):
+        """Register a consumer of blocks of phonons
+
+        consumer is called in run() as
+            consumer(q_indices, frequencies, eigenvectors)
+        where q_indices are indices of the q-points in get_qpoints(),
+        frequencies.shape=(len(q_indices), num_band), and eigenvectors
+        has shape=(len(q_indices), num_band, num_band) or is None when
+        is_eigenvectors=False.
+
+        """
+        self._consumers.append(consumer)
+
+    def remove_consumer(self, consumer):
+        self._consumers.remove(consumer)
+
+    def run(self, start=0):
+        """Solve phonons block by block and pass them to consumers
+
+        Frequencies and eigenvalues at all q-points are stored, but
+        eigenvectors are not.
+
+        Args:
+            start: Index of q-point where the calculation starts, e.g.,
+                to resume an interrupted run. Frequencies at q-points
+                before start are left zero.
+
+        """
+        num_qpoints = len(self._qpoints)
+        num_band = self._cell.get_number_of_atoms() * 3
+        frequencies = np.zeros((num_qpoints, num_band), dtype='double')
+        for i in range(start, num_qpoints, self._block_size):
+            q_indices, freqs, eigvecs = self._get_block(i)
+            frequencies[q_indices] = freqs
+            for consumer in self._consumers:
+                consumer(q_indices, freqs, eigvecs)
+
+        self._frequencies = frequencies
+        self._eigenvalues = np.array(frequencies ** 2 * np.sign(frequencies),
+                                     dtype='double',
+                                     order='C') / self._factor ** 2
+        self._eigenvectors = None
+
+    def _get_block(self, start):
+        num_band = self._cell.get_number_of_atoms() * 3
+        q_indices = np.arange(start,
+                              min(start + self._block_size,
+                                  len(self._qpoints)),
+                              dtype='intc')
+        freqs = np.zeros((len(q_indices), num_band), dtype='double')
+        if self._is_eigenvectors:
+            dtype = "c%d" % (np.dtype('double').itemsize * 2)
+            eigvecs = np.zeros((len(q_indices), num_band, num_band),
+                               dtype=dtype)
+        else:
+            eigvecs = None
+        get_phonons_at_qpoints(freqs,
+                               eigvecs,
+                               self._dynamical_matrix,
+                               self._qpoints[q_indices],
+                               self._factor)
+        return q_indices, freqs, eigvecs
+
+
+class MeshHDF5Writer(object):
+    """Consumer of IterMesh writing blocks of phonons to hdf5 file
+
+    Datasets of q-points, weights, frequencies, and optionally
+    eigenvectors and group velocities are created in advance with
+    chunks of block_size q-points, and each block is written as soon
+    as it is solved. The number of finished q-points is recorded as the
+    attribute 'num_finished_qpoints', with which an interrupted run is
+    resumed:
+
+        writer = MeshHDF5Writer(iter_mesh, resume=True)
+        iter_mesh.add_consumer(writer)
+        iter_mesh.run(start=writer.get_num_finished_qpoints())
+
+    """
+
+    def __init__(self,
+                 iter_mesh,
+                 filename="mesh.hdf5",
+                 group_velocity=None,
+                 compression=None,
+                 resume=False):
+        """
+        Args:
+            iter_mesh: IterMesh instance
+            filename: Output file name
+            group_velocity: GroupVelocity instance. Group velocities are
+                written if given.
+            compression: Compression filter of h5py, e.g., 'gzip' or 'lzf'
+            resume: If True and the file of the same mesh exists, writing
+                continues from the last finished block.
+
+        """
+        self._iter_mesh = iter_mesh
+        self._filename = filename
+        self._group_velocity = group_velocity
+        self._num_finished_qpoints = 0
+
+        if resume and os.path.exists(filename):
+            self._open_existing_file(compression)
+        else:
+            self._create_file(compression)
+
+    def __call__(self, q_indices, frequencies, eigenvectors):
+        import h5py
+
+        qpoints = self._iter_mesh.get_qpoints()
+        if self._group_velocity is not None:
+            self._group_velocity.set_q_points(qpoints[q_indices],
+                                              frequencies=frequencies,
+                                              eigenvectors=eigenvectors)
+            gv = self._group_velocity.get_group_velocity()
+
+        i, j = q_indices[0], q_indices[-1] + 1
+        with h5py.File(self._filename, 'r+') as w:
+            w['frequency'][i:j] = frequencies
+            if self._iter_mesh.is_eigenvectors():
+                w['eigenvector'][i:j] = eigenvectors
+            if self._group_velocity is not None:
+                w['group_velocity'][i:j] = gv
+            # Blocks come in order, therefore all q-points before j are done.
+            self._num_finished_qpoints = j
+            w.attrs['num_finished_qpoints'] = j
+
+    def get_num_finished_qpoints(self):
+        return self._num_finished_qpoints
+
+    def _create_file(self, compression):
+        import h5py
+
+        imesh = self._iter_mesh
+        num_qpoints = len(imesh.get_qpoints())
+        num_band = imesh.get_dynamical_matrix().get_dimension()
+        block_size = min(imesh.get_block_size(), num_qpoints)
+        dtype = "c%d" % (np.dtype('double').itemsize * 2)
+
+        with h5py.File(self._filename, 'w') as w:
+            w.create_dataset('mesh', data=imesh.get_mesh_numbers())
+            w.create_dataset('qpoint', data=imesh.get_qpoints())
+            w.create_dataset('weight', data=imesh.get_weights())
+            w.create_dataset('frequency',
+                             (num_qpoints, num_band),
+                             dtype='double',
+                             chunks=(block_size, num_band),
+                             compression=compression)
+            if imesh.is_eigenvectors():
+                w.create_dataset('eigenvector',
+                                 (num_qpoints, num_band, num_band),
+                                 dtype=dtype,
+                                 chunks=(block_size, num_band, num_band),
+                                 compression=compression)
+            if self._group_velocity is not None:
+                w.create_dataset('group_velocity',
+                                 (num_qpoints, num_band, 3),
+                                 dtype='double',
+                                 chunks=(block_size, num_band, 3),
+                                 compression=compression)
+            w.attrs['num_finished_qpoints'] = 0
+
+    def _open_existing_file(self, compression):
+        import h5py
+
+        with h5py.File(self._filename, 'r') as f:
+            if self._is_resumable(f):
+                self._num_finished_qpoints = int(
+                    f.attrs['num_finished_qpoints'])
+                return
+
+        print("Warning: %s is not resumable. A new file is created." %
+              self._filename)
+        self._create_file(compression)
+
+    def _is_resumable(self, f):
+        """Whether the file was written by a run of the same settings
+
+        The mesh, q-points, and the shapes of the datasets have to agree
+        with this run, eigenvector and group_velocity have to exist
+        exactly when they are requested here, and the finished q-points
+        have to end at a boundary of blocks of this run.
+
+        """
+        imesh = self._iter_mesh
+        qpoints = imesh.get_qpoints()
+        num_qpoints = len(qpoints)
+        num_band = imesh.get_dynamical_matrix().get_dimension()
+
+        if 'num_finished_qpoints' not in f.attrs:
+            return False
+        for key in ('mesh', 'qpoint', 'weight', 'frequency'):
+            if key not in f:
+                return False
+        if ('eigenvector' in f) != imesh.is_eigenvectors():
+            return False
+        if ('group_velocity' in f) != (self._group_velocity is not None):
+            return False
+
+        shapes = {'qpoint': qpoints.shape,
+                  'weight': (num_qpoints,),
+                  'frequency': (num_qpoints, num_band)}
+        if imesh.is_eigenvectors():
+            shapes['eigenvector'] = (num_qpoints, num_band, num_band)
+        if self._group_velocity is not None:
+            shapes['group_velocity'] = (num_qpoints, num_band, 3)
+        for key in shapes:
+            if f[key].shape != shapes[key]:
+                return False
+
+        if f['mesh'].shape != (3,):
+            return False
+        if not (f['mesh'][:] == imesh.get_mesh_numbers()).all():
+            return False
+        if not np.allclose(f['qpoint'][:], qpoints):
+            return False
+
+        num_finished = int(f.attrs['num_finished_qpoints'])
+        if num_finished < 0 or num_finished > num_qpoints:
+            return False
+        if (num_finished != num_qpoints and
+            num_finished % imesh.get_block_size() != 0):
+            return False
+
+        return True
@@ -35,6 +35,7 @@
 import numpy as np
 import cmath
 from phonopy.units import VaspToTHz
+from phonopy.phonon.solver import get_phonons_at_qpoints
 
 class QpointsPhonon(object):
     def __init__(self,
@@ -134,31 +135,23 @@ class QpointsPhonon(object):
                 self._qpoints, perturbation=self._nac_q_direction)
             self._gv = self._group_velocity.get_group_velocity()
 
-        if self._write_dynamical_matrix:
-            self._dm = []
-
-        self._frequencies = []
+        num_band = self._natom * 3
+        num_qpoints = len(self._qpoints)
+        self._frequencies = np.zeros((num_qpoints, num_band), dtype='double')
         if self._is_eigenvectors:
-            self._eigenvectors = []
+            dtype = "c%d" % (np.dtype('double').itemsize * 2)
+            self._eigenvectors = np.zeros((num_qpoints, num_band, num_band),
+                                          dtype=dtype, order='C')
+        get_phonons_at_qpoints(self._frequencies,
+                               self._eigenvectors,
+                               self._dynamical_matrix,
+                               self._qpoints,
+                               self._factor,
+                               nac_q_direction=self._nac_q_direction)
 
-        for q in self._qpoints:
-            dm = self._get_dynamical_matrix(q)
-            if self._write_dynamical_matrix:
-                self._dm.append(dm)
-            if self._is_eigenvectors:
-                eigvals, eigvecs = np.linalg.eigh(dm)
-                self._eigenvectors.append(eigvecs)
-            else:
-                eigvals = np.linalg.eigvalsh(dm)
-            eigvals = eigvals.real
-            self._frequencies.append(np.sqrt(np.abs(eigvals)) *
-                                     np.sign(eigvals) * self._factor)
-
-        self._frequencies = np.array(self._frequencies,
-                                     dtype='double', order='C')
-        dtype = "c%d" % (np.dtype('double').itemsize * 2)
-        self._eigenvectors = np.array(self._eigenvectors,
-                                      dtype=dtype, order='C')
+        if self._write_dynamical_matrix:
+            self._dm = np.array([self._get_dynamical_matrix(q)
+                                 for q in self._qpoints])
 
     def _get_dynamical_matrix(self, q):
         if (self._dynamical_matrix.is_nac() and
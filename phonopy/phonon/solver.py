@@ -0,0 +1,149 @@
+# Copyright (C) 2018 Atsushi Togo
+# All rights reserved.
+#
+# This file is part of phonopy.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# * Redistributions of source code must retain the above copyright
+#   notice, this list of conditions and the following disclaimer.
+#
+# * Redistributions in binary form must reproduce the above copyright
+#   notice, this list of conditions and the following disclaimer in
+#   the documentation and/or other materials provided with the
+#   distribution.
+#
+# * Neither the name of the phonopy project nor the names of its
+#   contributors may be used to endorse or promote products derived
+#   from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+
+import numpy as np
+
+
+def get_phonons_at_qpoints(frequencies,
+                           eigenvectors,
+                           dynamical_matrix,
+                           qpoints,
+                           factor,
+                           nac_q_direction=None,
+                           lapack_zheev_uplo='L',
+                           block_size=64):
+    """Solve phonons at q-points
+
+    Dynamical matrices are built and diagonalized by LAPACK zheev in
+    one C loop over q-points if phonopy._phonopy is linked with LAPACK,
+    otherwise numpy.linalg.eigh is used.
+
+    Args:
+        frequencies: Phonon frequencies in factor unit (output),
+            shape=(num_qpoints, num_band), dtype='double'
+        eigenvectors: Eigenvectors as column vectors (output), or None,
+            shape=(num_qpoints, num_band, num_band), dtype=complex
+        dynamical_matrix: DynamicalMatrix or DynamicalMatrixNAC instance
+        qpoints: q-points in reduced coordinates, shape=(num_qpoints, 3)
+        factor: Unit conversion factor to frequency
+        nac_q_direction: q-direction used at Gamma point with NAC,
+            otherwise ignored
+        lapack_zheev_uplo: 'L' or 'U', triangle of dynamical matrix used
+        block_size: Number of q-points whose dynamical matrices are held
+            at a time when they are built in Python, e.g., with NAC by
+            Gonze et al.
+
+    """
+    _qpoints = np.array(qpoints, dtype='double', order='C').reshape(-1, 3)
+    is_nac = dynamical_matrix.is_nac()
+    if is_nac:
+        args = dynamical_matrix._get_c_solver_arguments(
+            _qpoints, q_direction=nac_q_direction)
+    else:
+        args = dynamical_matrix._get_c_solver_arguments(_qpoints)
+
+    try:
+        from phonopy._phonopy import phonons_at_qpoints
+    except ImportError:
+        phonons_at_qpoints = None
+        args = None
+
+    if args is not None:
+        if eigenvectors is None:
+            eigvecs = None
+        else:
+            eigvecs = eigenvectors.view(dtype='double')
+        num_failed = phonons_at_qpoints(frequencies,
+                                        eigvecs,
+                                        None,
+                                        *(args + (factor, lapack_zheev_uplo)))
+    else:
+        # Dynamical matrices are built by block_size q-points to bound
+        # memory space.
+        num_failed = 0
+        for i in range(0, len(_qpoints), block_size):
+            j = min(i + block_size, len(_qpoints))
+            if eigenvectors is None:
+                eigvecs = None
+            else:
+                eigvecs = eigenvectors[i:j]
+            num_failed += _solve_dynamical_matrices(
+                frequencies[i:j],
+                eigvecs,
+                dynamical_matrix,
+                _qpoints[i:j],
+                factor,
+                nac_q_direction,
+                lapack_zheev_uplo,
+                phonons_at_qpoints)
+
+    if num_failed:
+        raise RuntimeError("LAPACK zheev failed at %d q-point(s)." %
+                           num_failed)
+
+
+def _solve_dynamical_matrices(frequencies,
+                              eigenvectors,
+                              dynamical_matrix,
+                              qpoints,
+                              factor,
+                              nac_q_direction,
+                              lapack_zheev_uplo,
+                              phonons_at_qpoints):
+    if dynamical_matrix.is_nac():
+        dms = dynamical_matrix.get_dynamical_matrices_at_qpoints(
+            qpoints, q_direction=nac_q_direction)
+    else:
+        dms = dynamical_matrix.get_dynamical_matrices_at_qpoints(qpoints)
+
+    if phonons_at_qpoints is None:
+        if eigenvectors is None:
+            eigvals = np.linalg.eigvalsh(dms).real
+        else:
+            eigvals, eigenvectors[:] = np.linalg.eigh(dms)
+            eigvals = eigvals.real
+        frequencies[:] = (np.sqrt(np.abs(eigvals)) * np.sign(eigvals) *
+                          factor)
+        return 0
+
+    if eigenvectors is None:
+        eigvecs = None
+    else:
+        eigvecs = eigenvectors.view(dtype='double')
+    return phonons_at_qpoints(
+        frequencies,
+        eigvecs,
+        dms.view(dtype='double'),
+        *((None, ) * 15 + (factor, lapack_zheev_uplo)))
@@ -104,6 +104,77 @@ def _get_tetrahedra_frequencies_Py(gp,
         t_frequencies[:, i, :] = frequencies[gp_ir_index[neighbors]].T
     return t_frequencies
 
+def get_tetrahedra_vertices(relative_grid_address,
+                            mesh,
+                            grid_points,
+                            grid_address,
+                            gp_ir_index,
+                            grid_order=None,
+                            lang='C'):
+    """Return indices of ir-grid-points at vertices of 24 tetrahedra
+
+    Returned array has the shape of (len(grid_points), 24, 4). Indices
+    refer to the irreducible grid points in the order of gp_ir_index,
+    so that frequencies at the vertices are obtained by
+    frequencies[vertices].
+
+    """
+    if lang == 'C':
+        try:
+            import phonopy._phonopy as phonoc
+            return _get_tetrahedra_vertices_C(relative_grid_address,
+                                              mesh,
+                                              grid_points,
+                                              grid_address,
+                                              gp_ir_index)
+        except ImportError:
+            pass
+    return _get_tetrahedra_vertices_Py(relative_grid_address,
+                                       mesh,
+                                       grid_points,
+                                       grid_address,
+                                       gp_ir_index,
+                                       grid_order)
+
+def get_gp_ir_index(grid_mapping_table, ir_grid_points):
+    """Return indices in ir_grid_points of grid points"""
+    ir_index = np.zeros(len(grid_mapping_table), dtype='intc')
+    ir_index[ir_grid_points] = np.arange(len(ir_grid_points), dtype='intc')
+    return np.array(ir_index[grid_mapping_table], dtype='intc')
+
+def _get_tetrahedra_vertices_C(relative_grid_address,
+                               mesh,
+                               grid_points,
+                               grid_address,
+                               gp_ir_index):
+    import phonopy._phonopy as phonoc
+
+    vertices = np.zeros((len(grid_points), 24, 4), dtype='intc')
+    phonoc.tetrahedra_vertices(vertices,
+                               np.array(grid_points, dtype='intc'),
+                               np.array(mesh, dtype='intc'),
+                               grid_address,
+                               np.array(gp_ir_index, dtype='intc'),
+                               relative_grid_address)
+    return vertices
+
+def _get_tetrahedra_vertices_Py(relative_grid_address,
+                                mesh,
+                                grid_points,
+                                grid_address,
+                                gp_ir_index,
+                                grid_order):
+    if grid_order is None:
+        _grid_order = [1, mesh[0], mesh[0] * mesh[1]]
+    else:
+        _grid_order = grid_order
+    vertices = np.zeros((len(grid_points), 24, 4), dtype='intc')
+    for i, gp in enumerate(grid_points):
+        address = relative_grid_address + grid_address[gp]
+        neighbors = np.dot(address % mesh, _grid_order)
+        vertices[i] = gp_ir_index[neighbors]
+    return vertices
+
 class TetrahedronMesh(object):
     def __init__(self,
                  cell,
@@ -113,6 +184,7 @@ class TetrahedronMesh(object):
                  grid_mapping_table,
                  ir_grid_points,
                  grid_order=None,
+                 tetrahedra_vertices=None,
                  lang='C'):
         self._cell = cell
         self._frequencies = frequencies
@@ -132,6 +204,7 @@ class TetrahedronMesh(object):
         self._gp_ir_index = None
 
         self._tm = None
+        self._tetrahedra_vertices = tetrahedra_vertices
         self._tetrahedra_frequencies = None
         self._integration_weights = None
         self._relative_grid_address = None
@@ -150,8 +223,7 @@ class TetrahedronMesh(object):
         if self._grid_point_count == len(self._ir_grid_points):
             raise StopIteration
         else:
-            gp = self._ir_grid_points[self._grid_point_count]
-            self._set_tetrahedra_frequencies(gp)
+            self._set_tetrahedra_frequencies(self._grid_point_count)
             for ib, frequencies in enumerate(self._tetrahedra_frequencies):
                 self._tm.set_tetrahedra_omegas(frequencies)
                 self._tm.run(self._frequency_points, value=self._value)
@@ -191,26 +263,32 @@ class TetrahedronMesh(object):
         num_freqs = len(self._frequency_points)
         self._integration_weights = np.zeros((num_freqs, num_band),
                                              dtype='double')
+
+    def get_tetrahedra_vertices(self):
+        return self._tetrahedra_vertices
+
+    def _prepare(self):
+        self._gp_ir_index = get_gp_ir_index(self._grid_mapping_table,
+                                            self._ir_grid_points)
         reciprocal_lattice = np.linalg.inv(self._cell.get_cell())
         self._tm = TetrahedronMethod(reciprocal_lattice, mesh=self._mesh)
         self._relative_grid_address = self._tm.get_tetrahedra()
+        if self._tetrahedra_vertices is None:
+            self._tetrahedra_vertices = get_tetrahedra_vertices(
+                self._relative_grid_address,
+                self._mesh,
+                self._ir_grid_points,
+                self._grid_address,
+                self._gp_ir_index,
+                grid_order=self._grid_order,
+                lang=self._lang)
 
-    def _prepare(self):
-        ir_gp_indices = {}
-        for i, gp in enumerate(self._ir_grid_points):
-            ir_gp_indices[gp] = i
+    def _set_tetrahedra_frequencies(self, i):
+        """Frequencies at vertices of tetrahedra around i-th ir-grid-point
 
-        self._gp_ir_index = np.zeros_like(self._grid_mapping_table)
-        for i, gp in enumerate(self._grid_mapping_table):
-            self._gp_ir_index[i] = ir_gp_indices[gp]
-        
-    def _set_tetrahedra_frequencies(self, gp):
-        self._tetrahedra_frequencies = get_tetrahedra_frequencies(
-            gp,
-            self._mesh,
-            self._grid_address,
-            self._relative_grid_address,
-            self._gp_ir_index,
-            self._frequencies,
-            grid_order=self._grid_order,
-            lang=self._lang)
+        The shape is (num_band, 24, 4).
+
+        """
+        self._tetrahedra_frequencies = np.array(
+            self._frequencies[self._tetrahedra_vertices[i]].transpose(2, 0, 1),
+            dtype='double', order='C')
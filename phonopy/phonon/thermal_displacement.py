@@ -36,6 +36,7 @@ import numpy as np
 from phonopy.units import AMU, THzToEv, Kb, EV, Hbar, Angstrom
 from phonopy.structure.cells import get_equivalent_smallest_vectors
 from phonopy.interface.cif import write_cif_P1
+from phonopy.phonon.mesh import IterMesh
 
 class ThermalMotion(object):
     def __init__(self,
@@ -101,6 +102,32 @@ class ThermalMotion(object):
         else:
             return 1.0 / (np.exp(freq * THzToEv / (Kb * t)) - 1)
 
+    def _run_phonons(self, iter_phonons, add_phonons):
+        """Pass phonons q-point by q-point to add_phonons(freqs, eigvecs)
+
+        IterMesh is run with a consumer of blocks of phonons, i.e.,
+        eigenvectors at all q-points are not stored. Returns the number
+        of q-points.
+
+        """
+        if isinstance(iter_phonons, IterMesh):
+            if not iter_phonons.is_eigenvectors():
+                raise RuntimeError("IterMesh with is_eigenvectors=True "
+                                   "is required.")
+            def consumer(q_indices, frequencies, eigenvectors):
+                for freqs, eigvecs in zip(frequencies, eigenvectors):
+                    add_phonons(freqs, eigvecs)
+            iter_phonons.add_consumer(consumer)
+            iter_phonons.run()
+            iter_phonons.remove_consumer(consumer)
+            return len(iter_phonons.get_qpoints())
+        else:
+            count = 0
+            for freqs, eigvecs in iter_phonons:
+                add_phonons(freqs, eigvecs)
+                count += 1
+            return count
+
 class ThermalDisplacements(ThermalMotion):
     def __init__(self,
                  iter_phonons,
@@ -146,7 +173,7 @@ class ThermalDisplacements(ThermalMotion):
         temps = self._temperatures
         disps = np.zeros((len(temps), len(masses)), dtype=float)
 
-        for count, (fs, vecs) in enumerate(self._iter_phonons):
+        def add_phonons(fs, vecs):
             if self._projection_direction is not None:
                 p_vecs = np.dot(
                     vecs.T.reshape(-1, 3),
@@ -164,7 +191,8 @@ class ThermalDisplacements(ThermalMotion):
                 for i, t in enumerate(temps):
                     disps[i] += self.get_Q2(f, t) * c
 
-        self._displacements = disps / (count + 1)
+        count = self._run_phonons(self._iter_phonons, add_phonons)
+        self._displacements = disps / count
 
     def write_yaml(self):
         natom = len(self._masses)
@@ -260,28 +288,11 @@ class ThermalDisplacementMatrices(ThermalMotion):
                                      self._ANinv.T)
                     self._disp_matrices_cif[i, j] = mat_cif
 
-        for count, (fs, vecs) in enumerate(self._iter_phonons):
-            if self._projection_direction is not None:
-                p_vecs = np.dot(
-                    vecs.T.reshape(-1, 3),
-                    self._projection_direction).reshape(-1, len(masses))
-                vecs2 = np.abs(p_vecs) ** 2
-            else:
-                vecs2 = (abs(vecs) ** 2).T
-
-            valid_indices = fs > self._fmin
-            if self._fmax is not None:
-                valid_indices *= fs < self._fmax
-
-            for f, v2 in zip(fs[valid_indices], vecs2[valid_indices]):
-                c = v2 / masses
-                for i, t in enumerate(temps):
-                    disps[i] += self.get_Q2(f, t) * c
-
     def _get_disp_matrices(self):
         disps = np.zeros((len(self._temperatures), len(self._masses),
                           3, 3), dtype=complex)
-        for count, (freqs, eigvecs) in enumerate(self._iter_phonons):
+
+        def add_phonons(freqs, eigvecs):
             valid_indices = freqs > self._fmin
             if self._fmax is not None:
                 valid_indices *= freqs < self._fmax
@@ -297,7 +308,9 @@ class ThermalDisplacementMatrices(ThermalMotion):
                         # Probably, overflow in exp(freq / (kB * T))
                         print("%s: T=%.1f freq=%.2f (band #%d)" %
                               (e, t, f, i_band))
-        self._disp_matrices = disps / (count + 1)
+
+        count = self._run_phonons(self._iter_phonons, add_phonons)
+        self._disp_matrices = disps / count
 
     def write_cif(self, cell, temperature_index):
         write_cif_P1(cell,
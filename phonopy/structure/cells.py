@@ -572,6 +572,39 @@ def _get_smallest_vectors(supercell, primitive, symprec):
 #
 # Other tiny tools
 #
+def get_smallest_vector_lattice_points(smallest_vectors,
+                                       multiplicity,
+                                       positions,
+                                       s2pp_map,
+                                       tolerance=1e-8):
+    """Decompose smallest vectors into atom positions and lattice points
+
+    smallest_vectors[k, i, l]
+        = positions[s2pp_map[k]] - positions[i]
+          + lattice_points[lattice_index[k, i, l]]
+
+    where positions are those of the primitive cell. (None, None) is
+    returned when the smallest vectors can not be decomposed within the
+    tolerance.
+
+    """
+    pos = np.array(positions)
+    dpos = pos[s2pp_map][:, None, :] - pos[None, :, :]
+    lattice_vectors = smallest_vectors - dpos[:, :, None, :]
+    mask = (np.arange(smallest_vectors.shape[2])[None, None, :] <
+            multiplicity[:, :, None])
+    diff = lattice_vectors - np.rint(lattice_vectors)
+    if (np.abs(diff[mask]) > tolerance).any():
+        return None, None
+
+    lattice_points, inverse = np.unique(
+        np.rint(lattice_vectors[mask]).astype('intc'),
+        axis=0,
+        return_inverse=True)
+    lattice_index = np.zeros(mask.shape, dtype='intc')
+    lattice_index[mask] = inverse.ravel()
+    return np.array(lattice_points, dtype='intc', order='C'), lattice_index
+
 def get_angles(lattice):
     a, b, c = get_cell_parameters(lattice)
     alpha = np.arccos(np.vdot(lattice[1], lattice[2]) / b / c) / np.pi * 180
@@ -160,54 +160,161 @@ def get_symmetry_dataset(cell, symprec=1e-5, angle_tolerance=-1.0):
     if lattice is None:
         return None
 
-    keys = ('number',
-            'hall_number',
-            'international',
-            'hall',
-            'choice',
-            'transformation_matrix',
-            'origin_shift',
-            'rotations',
-            'translations',
-            'wyckoffs',
-            'equivalent_atoms',
-            'std_lattice',
-            'std_types',
-            'std_positions',
-            # 'pointgroup_number',
-            'pointgroup')
     spg_ds = spg.dataset(lattice, positions, numbers, symprec, angle_tolerance)
     if spg_ds is None:
         _set_error_message()
         return None
 
-    dataset = {}
-    for key, data in zip(keys, spg_ds):
-        dataset[key] = data
+    dataset = _build_dataset_dict(spg_ds)
+    _set_error_message()
+    return dataset
 
-    dataset['international'] = dataset['international'].strip()
-    dataset['hall'] = dataset['hall'].strip()
-    dataset['choice'] = dataset['choice'].strip()
-    dataset['transformation_matrix'] = np.array(
-        dataset['transformation_matrix'], dtype='double', order='C')
-    dataset['origin_shift'] = np.array(dataset['origin_shift'], dtype='double')
-    dataset['rotations'] = np.array(dataset['rotations'],
-                                    dtype='intc', order='C')
-    dataset['translations'] = np.array(dataset['translations'],
-                                       dtype='double', order='C')
-    letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    dataset['wyckoffs'] = [letters[x] for x in dataset['wyckoffs']]
-    dataset['equivalent_atoms'] = np.array(dataset['equivalent_atoms'],
-                                           dtype='intc')
-    dataset['std_lattice'] = np.array(np.transpose(dataset['std_lattice']),
-                                      dtype='double', order='C')
-    dataset['std_types'] = np.array(dataset['std_types'], dtype='intc')
-    dataset['std_positions'] = np.array(dataset['std_positions'],
-                                        dtype='double', order='C')
-    dataset['pointgroup'] = dataset['pointgroup'].strip()
+class SymmetryContext(object):
+    """Symmetry search reusing results for similar cells
+
+    The primitive lattice and the space group found for a cell are tried
+    first for the next cell with the same atomic numbers, e.g., strained
+    cells of a volume scan. They are verified for the new cell, and the
+    full search is made when they don't hold. Datasets are the same as
+    those of get_symmetry_dataset unless a Hall number of a non-default
+    setting is given by set_hint. Previous results are reused only while
+    the same Hall number is set by set_hint, i.e., the setting of a hint
+    is not kept after the hint is changed.
+
+    Args:
+        symprec, angle_tolerance:
+            See the docstring of get_symmetry.
+    """
+
+    def __init__(self, symprec=1e-5, angle_tolerance=-1.0):
+        self._symprec = symprec
+        self._angle_tolerance = angle_tolerance
+        self._context = spg.context_new(symprec, angle_tolerance)
+
+    def get_symmetry_tolerance(self):
+        return self._symprec
+
+    def get_angle_tolerance(self):
+        return self._angle_tolerance
+
+    def set_hint(self, hall_number=0, primitive_matrix=None):
+        """Expected symmetry tried for a cell without a previous one
+
+        Args:
+            hall_number:
+                int: Hall number. The dataset is given in this setting if
+                    the space group matches. 0 means unknown.
+            primitive_matrix:
+                3x3 float matrix: Primitive lattice vectors with respect to
+                    the lattice vectors of the cell, i.e.,
+                    [a_p, b_p, c_p] = [a, b, c] * primitive_matrix.
+                    None means unknown.
+        """
+        if primitive_matrix is None:
+            pmat = None
+        else:
+            pmat = np.array(primitive_matrix, dtype='double', order='C')
+        spg.context_set_hint(self._context, hall_number, pmat)
+
+    def get_symmetry_dataset(self, cell):
+        """Search symmetry dataset from an input cell.
 
+        See the docstring of get_symmetry_dataset for cell and the
+        returned dictionary.
+        """
+        _set_no_error()
+
+        lattice, positions, numbers, _ = _expand_cell(cell)
+        if lattice is None:
+            return None
+
+        spg_ds = spg.context_dataset(self._context, lattice, positions, numbers)
+        if spg_ds is None:
+            _set_error_message()
+            return None
+
+        dataset = _build_dataset_dict(spg_ds)
+        _set_error_message()
+        return dataset
+
+def get_supercell_symmetry(unitcell,
+                           dataset,
+                           supercell,
+                           supercell_matrix,
+                           symprec=1e-5):
+    """Symmetry operations of a supercell made from those of its unit cell
+
+    The unit cell operations that keep the supercell lattice are combined
+    with the lattice points of the unit cell in the supercell. Atoms of
+    the supercell are identified with those of the unit cell, so no
+    symmetry search is made for the supercell.
+
+    Args:
+        unitcell, supercell:
+            See the docstring of get_symmetry. Magnetic moments are
+            ignored.
+        dataset:
+            dict: Symmetry dataset of unitcell given by
+                get_symmetry_dataset.
+        supercell_matrix:
+            Integer 3x3 array as given to Supercell, i.e., supercell
+            lattice vectors in columns are given by
+            np.dot(unitcell lattice vectors in columns, supercell_matrix).
+        symprec:
+            float: Tolerance to identify supercell atoms with unit cell
+                atoms in the unit of length.
+
+    Return:
+        dictionary: Rotation parts, translation parts, equivalent atoms
+        and mapping operations.
+
+        'rotations', 'translations', 'equivalent_atoms':
+            See the docstring of get_symmetry.
+        'map_operations': Gives the numpy 'intc' array of the indices of
+            the first operations that send atoms to their equivalent atoms.
+
+        None is returned if the supercell is inconsistent with the unit
+        cell.
+    """
+    _set_no_error()
+
+    lattice, positions, numbers, _ = _expand_cell(unitcell)
+    if lattice is None:
+        return None
+    s_lattice, s_positions, s_numbers, _ = _expand_cell(supercell)
+    if s_lattice is None:
+        return None
+
+    num_sym = (len(dataset['rotations']) *
+               int(round(abs(np.linalg.det(supercell_matrix)))))
+    rotation = np.zeros((num_sym, 3, 3), dtype='intc')
+    translation = np.zeros((num_sym, 3), dtype='double')
+    equivalent_atoms = np.zeros(len(s_positions), dtype='intc')
+    map_operations = np.zeros(len(s_positions), dtype='intc')
+    num_sym = spg.supercell_symmetry(
+        rotation,
+        translation,
+        equivalent_atoms,
+        map_operations,
+        np.array(dataset['rotations'], dtype='intc', order='C'),
+        np.array(dataset['translations'], dtype='double', order='C'),
+        lattice,
+        positions,
+        numbers,
+        np.array(supercell_matrix, dtype='intc', order='C'),
+        s_positions,
+        s_numbers,
+        symprec)
     _set_error_message()
-    return dataset
+    if num_sym == 0:
+        return None
+    else:
+        return {'rotations': np.array(rotation[:num_sym],
+                                      dtype='intc', order='C'),
+                'translations': np.array(translation[:num_sym],
+                                         dtype='double', order='C'),
+                'equivalent_atoms': equivalent_atoms,
+                'map_operations': map_operations}
 
 def get_spacegroup(cell, symprec=1e-5, angle_tolerance=-1.0, symbol_type=0):
     """Return space group in international table symbol and number as a string.
@@ -702,6 +809,50 @@ def niggli_reduce(lattice, eps=1e-5):
 def get_error_message():
     return spglib_error.message
 
+def _build_dataset_dict(spg_ds):
+    keys = ('number',
+            'hall_number',
+            'international',
+            'hall',
+            'choice',
+            'transformation_matrix',
+            'origin_shift',
+            'rotations',
+            'translations',
+            'wyckoffs',
+            'equivalent_atoms',
+            'std_lattice',
+            'std_types',
+            'std_positions',
+            # 'pointgroup_number',
+            'pointgroup')
+    dataset = {}
+    for key, data in zip(keys, spg_ds):
+        dataset[key] = data
+
+    dataset['international'] = dataset['international'].strip()
+    dataset['hall'] = dataset['hall'].strip()
+    dataset['choice'] = dataset['choice'].strip()
+    dataset['transformation_matrix'] = np.array(
+        dataset['transformation_matrix'], dtype='double', order='C')
+    dataset['origin_shift'] = np.array(dataset['origin_shift'], dtype='double')
+    dataset['rotations'] = np.array(dataset['rotations'],
+                                    dtype='intc', order='C')
+    dataset['translations'] = np.array(dataset['translations'],
+                                       dtype='double', order='C')
+    letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    dataset['wyckoffs'] = [letters[x] for x in dataset['wyckoffs']]
+    dataset['equivalent_atoms'] = np.array(dataset['equivalent_atoms'],
+                                           dtype='intc')
+    dataset['std_lattice'] = np.array(np.transpose(dataset['std_lattice']),
+                                      dtype='double', order='C')
+    dataset['std_types'] = np.array(dataset['std_types'], dtype='intc')
+    dataset['std_positions'] = np.array(dataset['std_positions'],
+                                        dtype='double', order='C')
+    dataset['pointgroup'] = dataset['pointgroup'].strip()
+
+    return dataset
+
 def _expand_cell(cell):
     if isinstance(cell, tuple):
         lattice = np.array(np.transpose(cell[0]), dtype='double', order='C')
@@ -40,15 +40,38 @@ from phonopy.structure.atoms import PhonopyAtoms as Atoms
 from phonopy.harmonic.force_constants import similarity_transformation
 
 class Symmetry(object):
-    def __init__(self, cell, symprec=1e-5, is_symmetry=True):
+    def __init__(self,
+                 cell,
+                 symprec=1e-5,
+                 is_symmetry=True,
+                 symmetry_context=None,
+                 unitcell=None):
+        """
+        symmetry_context: spglib.SymmetryContext
+            Symmetry search is made through it to reuse results for similar
+            cells, e.g., at different volumes. It is used only when its
+            symprec is the same as that given here.
+        unitcell: PhonopyAtoms
+            Unit cell from which cell is built as a Supercell. Symmetry
+            operations of cell are made from those of unitcell instead of
+            searching them in cell. The dataset is then given in the
+            setting found for unitcell, whose origin can differ from
+            that of a search in cell by an equivalent one, so Wyckoff
+            letters can differ, too, e.g., 'a' instead of 'b' for the
+            supercell of [[0, 1, 1], [1, 0, 1], [1, 1, 0]] of conventional
+            Si with an atom at (3/4, 3/4, 3/4).
+        """
         self._cell = cell
         self._symprec = symprec
+        self._symmetry_context = symmetry_context
+        self._unitcell = unitcell
 
         self._symmetry_operations = None
         self._international_table = None
         self._dataset = None
         self._wyckoff_letters = None
         self._map_atoms = None
+        self._map_operations = None
 
         magmom = cell.get_magnetic_moments()
         if type(magmom) is np.ndarray:
@@ -68,7 +91,6 @@ class Symmetry(object):
 
         self._independent_atoms = None
         self._set_independent_atoms()
-        self._map_operations = None
 
     def get_symmetry_operations(self):
         return self._symmetry_operations
@@ -165,7 +187,11 @@ class Symmetry(object):
         return np.array(site_symmetries, dtype='intc')
 
     def _set_symmetry_dataset(self):
-        self._dataset = spg.get_symmetry_dataset(self._cell, self._symprec)
+        if (self._unitcell is not None and
+            hasattr(self._cell, 'get_supercell_matrix')):
+            self._dataset = self._get_supercell_dataset()
+        if self._dataset is None:
+            self._dataset = self._get_dataset(self._cell)
         self._symmetry_operations = {
             'rotations': self._dataset['rotations'],
             'translations': self._dataset['translations']}
@@ -175,6 +201,52 @@ class Symmetry(object):
 
         self._map_atoms = self._dataset['equivalent_atoms']
 
+    def _get_dataset(self, cell):
+        context = self._symmetry_context
+        if (context is not None and
+            context.get_symmetry_tolerance() == self._symprec):
+            return context.get_symmetry_dataset(cell)
+        else:
+            return spg.get_symmetry_dataset(cell, self._symprec)
+
+    def _get_supercell_dataset(self):
+        """Dataset of supercell made from that of unit cell
+
+        None is returned unless all the unit cell operations are kept in
+        the supercell, since otherwise the space group type changes.
+
+        """
+        u_dataset = self._get_dataset(self._unitcell)
+        if u_dataset is None:
+            return None
+        smat = self._cell.get_supercell_matrix()
+        sym = spg.get_supercell_symmetry(self._unitcell,
+                                         u_dataset,
+                                         self._cell,
+                                         smat,
+                                         self._symprec)
+        if sym is None:
+            return None
+        num_lattice_points = int(round(abs(np.linalg.det(smat))))
+        if (len(sym['rotations']) !=
+            len(u_dataset['rotations']) * num_lattice_points):
+            return None
+
+        u2u_map = self._cell.get_unitcell_to_unitcell_map()
+        s2u_map = [u2u_map[i]
+                   for i in self._cell.get_supercell_to_unitcell_map()]
+        dataset = u_dataset.copy()
+        # (a_s, b_s, c_s) = (a, b, c) P^-1 with respect to supercell
+        dataset['transformation_matrix'] = np.dot(
+            u_dataset['transformation_matrix'], smat)
+        dataset['rotations'] = sym['rotations']
+        dataset['translations'] = sym['translations']
+        dataset['wyckoffs'] = [u_dataset['wyckoffs'][i] for i in s2u_map]
+        dataset['equivalent_atoms'] = sym['equivalent_atoms']
+        self._map_operations = sym['map_operations']
+
+        return dataset
+
     def _set_symmetry_operations_with_magmoms(self):
         cell = (self._cell.get_cell(),
                 self._cell.get_scaled_positions(),
@@ -3,6 +3,9 @@ import sys
 import numpy
 
 with_openmp = False
+# LAPACK (Fortran interface) used by phonon solver in C.
+# None: linked when liblapack is found.
+with_lapack = None
 
 try:
     from setuptools import setup, Extension
@@ -62,11 +65,26 @@ else:
     extra_compile_args_phonopy = []
     extra_link_args_phonopy = []
 
+if with_lapack is None:
+    from ctypes.util import find_library
+    with_lapack = find_library('lapack') is not None
+
+if with_lapack:
+    sources_phonopy += ['c/harmonic/lapack_wrapper.c',
+                        'c/harmonic/phonon.c']
+    libraries_phonopy = ['lapack']
+    define_macros_phonopy = [('PHPY_LAPACK', None)]
+else:
+    libraries_phonopy = []
+    define_macros_phonopy = []
+
 extension_phonopy = Extension(
     'phonopy._phonopy',
     extra_compile_args=extra_compile_args_phonopy,
     extra_link_args=extra_link_args_phonopy,
     include_dirs=include_dirs_phonopy,
+    libraries=libraries_phonopy,
+    define_macros=define_macros_phonopy,
     sources=sources_phonopy)
 
 
@@ -0,0 +1,66 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS, parse_BORN
+from phonopy.harmonic.derivative_dynmat import DerivativeOfDynamicalMatrix
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+qpoints = [[0, 0, 0],
+           [0.1, 0.2, 0.3],
+           [0.5, 0, 0.5],
+           [0.25, 0.25, 0.25],
+           [0.5, 0.5, 0.5]]
+
+class TestDerivativeDynmat(unittest.TestCase):
+    def setUp(self):
+        pass
+
+    def tearDown(self):
+        pass
+
+    def test_derivative_dynmat_at_qpoints(self):
+        self._compare(self._get_phonon())
+
+    def test_derivative_dynmat_at_qpoints_Wang(self):
+        self._compare(self._get_phonon(nac_method='wang'))
+
+    def test_derivative_dynmat_at_qpoints_Wang_q_direction(self):
+        self._compare(self._get_phonon(nac_method='wang'),
+                      q_direction=[1, 0, 0])
+
+    def _compare(self, phonon, q_direction=None):
+        dynmat = phonon.get_dynamical_matrix()
+        ddm = DerivativeOfDynamicalMatrix(dynmat)
+        ddm.run_at_qpoints(qpoints, q_direction=q_direction)
+        ddms = ddm.get_derivative_of_dynamical_matrix()
+        for q, ddm_q in zip(qpoints, ddms):
+            ddm.run(q, q_direction=q_direction)
+            np.testing.assert_allclose(
+                ddm_q, ddm.get_derivative_of_dynamical_matrix(), atol=1e-10)
+
+    def _get_phonon(self, nac_method=None):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        force_sets = parse_FORCE_SETS(filename=filename)
+        phonon.set_displacement_dataset(force_sets)
+        phonon.produce_force_constants()
+        if nac_method is not None:
+            filename_born = os.path.join(data_dir, "../BORN_NaCl")
+            nac_params = parse_BORN(phonon.get_primitive(),
+                                    filename=filename_born)
+            nac_params['method'] = nac_method
+            phonon.set_nac_params(nac_params)
+        return phonon
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestDerivativeDynmat)
+    unittest.TextTestRunner(verbosity=2).run(suite)
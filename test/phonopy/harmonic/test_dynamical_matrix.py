@@ -0,0 +1,103 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS, parse_BORN
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+qpoints = [[0, 0, 0],
+           [0.1, 0.2, 0.3],
+           [0.5, 0, 0.5],
+           [0.25, 0.25, 0.25],
+           [0.5, 0.5, 0.5]]
+
+class TestDynamicalMatrix(unittest.TestCase):
+    def setUp(self):
+        pass
+
+    def tearDown(self):
+        pass
+
+    def test_dynamical_matrices_at_qpoints(self):
+        phonon = self._get_phonon()
+        self._compare(phonon.get_dynamical_matrix())
+
+    def test_dynamical_matrices_at_qpoints_Wang(self):
+        phonon = self._get_phonon(nac_method='wang')
+        self._compare(phonon.get_dynamical_matrix())
+
+    def test_dynamical_matrices_at_qpoints_Gonze(self):
+        phonon = self._get_phonon(nac_method='gonze')
+        self._compare(phonon.get_dynamical_matrix())
+
+    def test_Gonze_dipole_dipole_workspace(self):
+        phonon = self._get_phonon(nac_method='gonze')
+        dynmat = phonon.get_dynamical_matrix()
+        dms = dynmat.get_dynamical_matrices_at_qpoints(qpoints)
+        dynmat._dd_workspace = None
+        dms_no_ws = dynmat.get_dynamical_matrices_at_qpoints(qpoints)
+        np.testing.assert_allclose(dms, dms_no_ws, atol=1e-10)
+
+    def test_dynamical_matrix_with_cutoff(self):
+        phonon = self._get_phonon()
+        phonon.set_force_constants_zero_with_radius(4.0)
+        dynmat = phonon.get_dynamical_matrix()
+        for q in qpoints:
+            dynmat.set_dynamical_matrix(q)
+            dm = dynmat.get_dynamical_matrix()
+            dynmat._set_py_dynamical_matrix(q)
+            np.testing.assert_allclose(dm, dynmat.get_dynamical_matrix(),
+                                       atol=1e-10)
+
+    def test_dynamical_matrix_phase_table(self):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         [[-1, 1, 1], [1, -1, 1], [1, 1, -1]],
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        num_satom = phonon.get_supercell().get_number_of_atoms()
+        np.random.seed(0)
+        fc = np.random.random((num_satom, num_satom, 3, 3))
+        phonon.set_force_constants(fc)
+        dynmat = phonon.get_dynamical_matrix()
+        self.assertTrue(dynmat._lattice_points is not None)
+        for q in qpoints:
+            dynmat.set_dynamical_matrix(q)
+            dm = dynmat.get_dynamical_matrix()
+            dynmat._set_py_dynamical_matrix(q)
+            np.testing.assert_allclose(dm, dynmat.get_dynamical_matrix(),
+                                       atol=1e-10)
+
+    def _compare(self, dynmat):
+        dms = dynmat.get_dynamical_matrices_at_qpoints(qpoints)
+        for q, dm in zip(qpoints, dms):
+            dynmat.set_dynamical_matrix(q)
+            np.testing.assert_allclose(dm, dynmat.get_dynamical_matrix(),
+                                       atol=1e-10)
+
+    def _get_phonon(self, nac_method=None):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        force_sets = parse_FORCE_SETS(filename=filename)
+        phonon.set_displacement_dataset(force_sets)
+        phonon.produce_force_constants()
+        if nac_method is not None:
+            filename_born = os.path.join(data_dir, "../BORN_NaCl")
+            nac_params = parse_BORN(phonon.get_primitive(),
+                                    filename=filename_born)
+            nac_params['method'] = nac_method
+            phonon.set_nac_params(nac_params)
+        return phonon
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestDynamicalMatrix)
+    unittest.TextTestRunner(verbosity=2).run(suite)
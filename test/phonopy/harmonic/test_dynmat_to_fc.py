@@ -1,8 +1,13 @@
 import unittest
 import numpy as np
 from phonopy.interface.phonopy_yaml import get_unitcell_from_phonopy_yaml
-from phonopy.harmonic.dynmat_to_fc import get_commensurate_points
-from phonopy.structure.cells import get_supercell, get_primitive
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS
+from phonopy.harmonic.dynmat_to_fc import (get_commensurate_points,
+                                           DynmatToForceConstants)
+from phonopy.structure.cells import (get_supercell, get_primitive,
+                                     get_smallest_vector_lattice_points)
 
 import os
 data_dir=os.path.dirname(os.path.abspath(__file__))
@@ -28,6 +33,103 @@ class TestDynmatToFc(unittest.TestCase):
         # self._write(comm_points)
         self._compare(comm_points)
 
+    def test_dynmat_to_fc(self):
+        phonon = self._get_phonon()
+        primitive = phonon.get_primitive()
+        dynmat = phonon.get_dynamical_matrix()
+        d2f = DynmatToForceConstants(primitive, phonon.get_supercell())
+        comm_points = d2f.get_commensurate_points()
+        d2f.set_dynamical_matrices(
+            dynmat=dynmat.get_dynamical_matrices_at_qpoints(comm_points))
+        d2f.run()
+        fc = d2f.get_force_constants().copy()
+        d2f._py_inverse_transformation()
+        np.testing.assert_allclose(d2f.get_force_constants(), fc, atol=1e-10)
+
+    def test_dynmat_to_fc_fft(self):
+        phonon = self._get_phonon()
+        primitive = phonon.get_primitive()
+        p2s = primitive.get_primitive_to_supercell_map()
+        d2f = DynmatToForceConstants(primitive, phonon.get_supercell())
+        self.assertTrue(d2f._fft is not None)
+        comm_points = d2f.get_commensurate_points()
+
+        # Without index permutation symmetry of fc, both are Hermitianized.
+        fc = np.random.RandomState(0).rand(*phonon.get_force_constants().shape)
+        phonon.set_force_constants(fc)
+        dm = phonon.get_dynamical_matrix().get_dynamical_matrices_at_qpoints(
+            comm_points)
+        np.testing.assert_allclose(
+            d2f._fft.get_dynamical_matrices(fc[p2s]), dm, atol=1e-12)
+
+        phonon = self._get_phonon()
+        fc = phonon.get_force_constants()
+        phonon.set_force_constants((fc + fc.transpose(1, 0, 3, 2)) / 2)
+        dynmat = phonon.get_dynamical_matrix()
+        dm = dynmat.get_dynamical_matrices_at_qpoints(comm_points)
+        np.testing.assert_allclose(
+            d2f._fft.get_dynamical_matrices(phonon.get_force_constants()[p2s]),
+            dm, atol=1e-12)
+
+        d2f.set_dynamical_matrices(dynmat=dm)
+        d2f.run()
+        d2f_direct = DynmatToForceConstants(primitive,
+                                            phonon.get_supercell(),
+                                            use_fft=False)
+        d2f_direct.set_dynamical_matrices(dynmat=dm)
+        d2f_direct.run()
+        np.testing.assert_allclose(d2f.get_force_constants(),
+                                   d2f_direct.get_force_constants(),
+                                   atol=1e-12)
+
+    def test_dynmat_to_fc_without_lattice_points(self):
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            return
+        phonon = self._get_phonon()
+        primitive = phonon.get_primitive()
+        dynmat = phonon.get_dynamical_matrix()
+        d2f = DynmatToForceConstants(primitive, phonon.get_supercell())
+        comm_points = d2f.get_commensurate_points()
+        dm = dynmat.get_dynamical_matrices_at_qpoints(comm_points)
+        p2p = primitive.get_primitive_to_primitive_map()
+        s2pp = np.array([p2p[i] for i in
+                         primitive.get_supercell_to_primitive_map()],
+                        dtype='intc')
+        svecs, multi = primitive.get_smallest_vectors()
+        pos = np.array(primitive.get_scaled_positions(),
+                       dtype='double', order='C')
+        lattice_points, lattice_index = get_smallest_vector_lattice_points(
+            svecs, multi, pos, s2pp)
+        self.assertTrue(lattice_points is not None)
+        fcs = []
+        for args in ((), (None,), (lattice_points, lattice_index, pos)):
+            fc = np.zeros_like(d2f.get_force_constants())
+            phonoc.transform_dynmat_to_fc(fc,
+                                          dm.view(dtype='double'),
+                                          comm_points,
+                                          svecs,
+                                          multi,
+                                          primitive.get_masses(),
+                                          s2pp,
+                                          *args)
+            fcs.append(fc)
+        np.testing.assert_allclose(fcs[0], fcs[1], atol=1e-12)
+        np.testing.assert_allclose(fcs[0], fcs[2], atol=1e-12)
+
+    def _get_phonon(self):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        phonon.set_displacement_dataset(parse_FORCE_SETS(filename=filename))
+        phonon.produce_force_constants()
+        return phonon
+
     def _compare(self, comm_points, filename="comm_points.dat"):
         with open(os.path.join(data_dir,filename)) as f:
             comm_points_in_file = np.loadtxt(f)
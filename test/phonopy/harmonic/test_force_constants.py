@@ -0,0 +1,107 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS
+from phonopy.harmonic.force_constants import (
+    get_fc2, symmetrize_force_constants, symmetrize_compact_force_constants)
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+class TestForceConstants(unittest.TestCase):
+    def setUp(self):
+        # Larger than a tile of the C implementation and not its multiple
+        self._fc = np.random.RandomState(0).rand(70, 70, 3, 3)
+
+    def tearDown(self):
+        pass
+
+    def test_symmetrize_force_constants(self):
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            return
+        fc = self._fc.copy()
+        symmetrize_force_constants(fc)
+        np.testing.assert_allclose(fc, self._perm_trans_symmetrize(self._fc),
+                                   atol=1e-12)
+
+    def test_symmetrize_force_constants_iteration(self):
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            return
+        fc = self._fc.copy()
+        symmetrize_force_constants(fc, iteration=3)
+        fc_ref = self._fc.copy()
+        for i in range(3):
+            fc_ref = self._perm_trans_symmetrize(fc_ref)
+        np.testing.assert_allclose(fc, fc_ref, atol=1e-12)
+
+    def test_symmetrize_compact_force_constants(self):
+        try:
+            import phonopy._phonopy as phonoc
+        except ImportError:
+            return
+        phonon = self._get_phonon()
+        primitive = phonon.get_primitive()
+        s2p = primitive.get_supercell_to_primitive_map()
+        p2s = primitive.get_primitive_to_supercell_map()
+        fc = phonon.get_force_constants()
+        fc_compact = fc[p2s]
+        for iteration in (1, 2):
+            fc_full = fc.copy()
+            symmetrize_force_constants(fc_full, iteration=iteration)
+            fc_sym = fc_compact.copy()
+            symmetrize_compact_force_constants(fc_sym,
+                                               phonon.get_supercell(),
+                                               phonon.get_symmetry(),
+                                               s2p,
+                                               p2s,
+                                               iteration=iteration)
+            np.testing.assert_allclose(fc_sym, fc_full[p2s], atol=1e-10)
+
+    def test_compact_force_constants(self):
+        phonon = self._get_phonon()
+        p2s = phonon.get_primitive().get_primitive_to_supercell_map()
+        fc = phonon.get_force_constants().copy()
+        phonon.produce_force_constants(calculate_full_force_constants=False)
+        np.testing.assert_allclose(phonon.get_force_constants(), fc[p2s],
+                                   atol=1e-12)
+
+    def test_compact_force_constants_not_displaced_atoms(self):
+        phonon = self._get_phonon()
+        fc = phonon.get_force_constants()
+        atom_list = [5, 40, 63]
+        for algorithm in ("svd", "regression"):
+            fc_compact = get_fc2(phonon.get_supercell(),
+                                 phonon.get_symmetry(),
+                                 phonon.get_displacement_dataset(),
+                                 atom_list=atom_list,
+                                 computation_algorithm=algorithm)
+            np.testing.assert_allclose(fc_compact, fc[atom_list], atol=1e-12)
+
+    def _get_phonon(self):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        phonon.set_displacement_dataset(parse_FORCE_SETS(filename=filename))
+        phonon.produce_force_constants()
+        return phonon
+
+    def _perm_trans_symmetrize(self, fc_in):
+        fc = (fc_in + fc_in.transpose(1, 0, 3, 2)) / 2
+        for i in range(len(fc)):
+            sums = fc[i].sum(axis=0) - fc[i, i]
+            fc[i, i] = -(sums + sums.T) / 2
+        return fc
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestForceConstants)
+    unittest.TextTestRunner(verbosity=2).run(suite)
@@ -0,0 +1,68 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS
+from phonopy.phonon.band_structure import (get_band_qpoints,
+                                           estimate_band_connection,
+                                           get_band_connection_orders)
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+class TestBandStructure(unittest.TestCase):
+    def setUp(self):
+        pass
+
+    def tearDown(self):
+        pass
+
+    def test_band_connection_orders(self):
+        phonon = self._get_phonon()
+        path = get_band_qpoints([np.array([[0.1, 0, 0.1],
+                                           [0.5, 0.25, 0.75],
+                                           [0.5, 0.5, 0.5]])], 21)[0]
+        dynmat = phonon.get_dynamical_matrix()
+        eigvecs = []
+        for q in path:
+            dynmat.set_dynamical_matrix(q)
+            eigvecs.append(np.linalg.eigh(dynmat.get_dynamical_matrix())[1])
+        eigvecs = np.array(eigvecs)
+        band_orders = get_band_connection_orders(eigvecs)
+        band_order = range(eigvecs.shape[1])
+        for i in range(1, len(path)):
+            band_order = estimate_band_connection(eigvecs[i - 1],
+                                                  eigvecs[i],
+                                                  band_order)
+            np.testing.assert_array_equal(band_orders[i], band_order)
+
+    def test_band_structure_with_band_connection(self):
+        phonon = self._get_phonon()
+        paths = get_band_qpoints([np.array([[0.1, 0, 0.1],
+                                            [0.5, 0, 0.5],
+                                            [0.5, 0.5, 0.5]])], 11)
+        phonon.set_band_structure(paths, is_band_connection=True)
+        _, _, freqs, eigvecs = phonon.get_band_structure()
+        for path, f_path in zip(paths, freqs):
+            for q, f in zip(path, f_path):
+                np.testing.assert_allclose(np.sort(f),
+                                           phonon.get_frequencies(q),
+                                           atol=1e-8)
+
+    def _get_phonon(self):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        force_sets = parse_FORCE_SETS(filename=filename)
+        phonon.set_displacement_dataset(force_sets)
+        phonon.produce_force_constants()
+        return phonon
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestBandStructure)
+    unittest.TextTestRunner(verbosity=2).run(suite)
@@ -0,0 +1,94 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS, parse_BORN
+from phonopy.phonon.group_velocity import GroupVelocity
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+qpoints = [[0, 0, 0],
+           [0.1, 0, 0.1],
+           [0.1, 0.2, 0.3],
+           [0.5, 0, 0.5],
+           [0.25, 0.25, 0.25],
+           [0.5, 0.5, 0.5]]
+
+class TestGroupVelocity(unittest.TestCase):
+    def setUp(self):
+        pass
+
+    def tearDown(self):
+        pass
+
+    def test_group_velocity(self):
+        self._compare(self._get_phonon())
+
+    def test_group_velocity_Wang(self):
+        self._compare(self._get_phonon(nac_method='wang'))
+
+    def test_group_velocity_with_perturbation(self):
+        self._compare(self._get_phonon(), perturbation=[1, 0, 0])
+
+    def test_group_velocity_block_size(self):
+        phonon = self._get_phonon()
+        gv = GroupVelocity(phonon.get_dynamical_matrix(),
+                           symmetry=phonon.get_primitive_symmetry())
+        gv.set_q_points(qpoints)
+        gv_ref = gv.get_group_velocity()
+        gv = GroupVelocity(phonon.get_dynamical_matrix(),
+                           symmetry=phonon.get_primitive_symmetry(),
+                           block_size=4)
+        gv.set_q_points(qpoints)
+        np.testing.assert_allclose(gv_ref, gv.get_group_velocity(),
+                                   atol=1e-12)
+
+    def test_symmetrize_group_velocities(self):
+        phonon = self._get_phonon()
+        gv = GroupVelocity(phonon.get_dynamical_matrix(),
+                           symmetry=phonon.get_primitive_symmetry())
+        q_points = qpoints + [[0.5, -0.5, 0], [1.5, 0.5, -0.25]]
+        gv_q = np.random.RandomState(1).rand(len(q_points), 6, 3)
+        gv_sym = gv_q.copy()
+        gv._symmetrize_group_velocities(gv_sym, q_points)
+        for q, v, v_sym in zip(q_points, gv_q, gv_sym):
+            np.testing.assert_allclose(
+                v_sym, gv._symmetrize_group_velocity(v, np.array(q)),
+                atol=1e-12)
+
+    def _compare(self, phonon, perturbation=None):
+        gv = GroupVelocity(phonon.get_dynamical_matrix(),
+                           symmetry=phonon.get_primitive_symmetry())
+        if not gv._is_c_group_velocity():
+            return
+        gv.set_q_points(qpoints, perturbation=perturbation)
+        gv_c = gv.get_group_velocity()
+        for q, v in zip(qpoints, gv_c):
+            np.testing.assert_allclose(v,
+                                       gv._set_group_velocity_at_q(q),
+                                       atol=1e-8)
+
+    def _get_phonon(self, nac_method=None):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        force_sets = parse_FORCE_SETS(filename=filename)
+        phonon.set_displacement_dataset(force_sets)
+        phonon.produce_force_constants()
+        if nac_method is not None:
+            filename_born = os.path.join(data_dir, "../BORN_NaCl")
+            nac_params = parse_BORN(phonon.get_primitive(),
+                                    filename=filename_born)
+            nac_params['method'] = nac_method
+            phonon.set_nac_params(nac_params)
+        return phonon
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestGroupVelocity)
+    unittest.TextTestRunner(verbosity=2).run(suite)
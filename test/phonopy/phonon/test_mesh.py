@@ -33,7 +33,216 @@ class TestIterMesh(unittest.TestCase):
         _, _, mesh_freqs, mesh_eigvecs = phonon.get_mesh()
 
         np.testing.assert_allclose(mesh_freqs, freqs)
-        np.testing.assert_allclose(mesh_eigvecs, eigvecs)
+        self._assert_eigenvectors(mesh_freqs, mesh_eigvecs, eigvecs)
+
+    def testIterMeshBlock(self):
+        phonon = self._get_phonon()
+        phonon.set_mesh([3, 3, 3], is_eigenvectors=True)
+        _, _, mesh_freqs, mesh_eigvecs = phonon.get_mesh()
+
+        phonon.set_iter_mesh([3, 3, 3], is_eigenvectors=True, block_size=3)
+        imesh = phonon.get_iter_mesh()
+        freqs = []
+        eigvecs = []
+        for i, (f, e) in enumerate(imesh):
+            freqs.append(f)
+            eigvecs.append(e)
+        np.testing.assert_allclose(mesh_freqs, freqs)
+        self._assert_eigenvectors(mesh_freqs, mesh_eigvecs, eigvecs)
+
+        phonon.set_iter_mesh([3, 3, 3], is_eigenvectors=True, block_size=3)
+        imesh = phonon.get_iter_mesh()
+        eigvecs = np.zeros_like(mesh_eigvecs)
+        def consumer(q_indices, f, e):
+            self.assertTrue(len(q_indices) <= 3)
+            eigvecs[q_indices] = e
+        imesh.add_consumer(consumer)
+        imesh.run()
+        np.testing.assert_allclose(mesh_freqs, imesh.get_frequencies())
+        self._assert_eigenvectors(mesh_freqs, mesh_eigvecs, eigvecs)
+
+    def testIterMeshPartialDos(self):
+        from phonopy.phonon.dos import PartialDos
+
+        phonon = self._get_phonon()
+        phonon.set_mesh([3, 3, 3], is_eigenvectors=True,
+                        is_mesh_symmetry=False)
+        pdos = PartialDos(phonon._mesh, sigma=0.1)
+        pdos.set_draw_area(0, 10, 0.5)
+        pdos.run()
+
+        phonon.set_iter_mesh([3, 3, 3], is_eigenvectors=True,
+                             is_mesh_symmetry=False, block_size=4)
+        ipdos = PartialDos(phonon.get_iter_mesh(), sigma=0.1)
+        ipdos.set_draw_area(0, 10, 0.5)
+        ipdos.run()
+        np.testing.assert_allclose(pdos.get_partial_dos()[1],
+                                   ipdos.get_partial_dos()[1], atol=1e-8)
+
+        phonon.set_iter_mesh([3, 3, 3], is_mesh_symmetry=False)
+        self.assertRaises(RuntimeError,
+                          PartialDos, phonon.get_iter_mesh(), sigma=0.1)
+
+    def testMeshGroupVelocity(self):
+        phonon = self._get_phonon()
+        phonon.set_group_velocity()
+        phonon.set_mesh([4, 4, 4], is_eigenvectors=True)
+        gv = phonon._mesh.get_group_velocities()
+
+        phonon.set_mesh([4, 4, 4], run_immediately=False)
+        phonon._mesh._block_size = 3
+        phonon._mesh.run()
+        self.assertTrue(phonon.get_mesh()[3] is None)
+        np.testing.assert_allclose(gv, phonon._mesh.get_group_velocities(),
+                                   atol=1e-10)
+
+    def testIterMeshThermalDisplacements(self):
+        from phonopy.phonon.thermal_displacement import (
+            ThermalDisplacements, ThermalDisplacementMatrices)
+
+        phonon = self._get_phonon()
+        masses = phonon.get_primitive().get_masses()
+        phonon.set_mesh([3, 3, 3], is_eigenvectors=True,
+                        is_mesh_symmetry=False)
+        phonon.set_iter_mesh([3, 3, 3], is_eigenvectors=True,
+                             is_mesh_symmetry=False, block_size=4)
+        imesh = phonon.get_iter_mesh()
+        td = ThermalDisplacements(phonon._mesh, masses)
+        td.set_temperature_range(0, 500, 100)
+        td.run()
+        itd = ThermalDisplacements(imesh, masses)
+        itd.set_temperature_range(0, 500, 100)
+        itd.run()
+        np.testing.assert_allclose(td.get_thermal_displacements()[1],
+                                   itd.get_thermal_displacements()[1],
+                                   atol=1e-8)
+
+        phonon.set_mesh([3, 3, 3], is_eigenvectors=True,
+                        is_mesh_symmetry=False)
+        tdm = ThermalDisplacementMatrices(phonon._mesh, masses)
+        tdm.set_temperature_range(0, 500, 100)
+        tdm.run()
+        itdm = ThermalDisplacementMatrices(imesh, masses)
+        itdm.set_temperature_range(0, 500, 100)
+        itdm.run()
+        np.testing.assert_allclose(
+            tdm.get_thermal_displacement_matrices()[1],
+            itdm.get_thermal_displacement_matrices()[1], atol=1e-8)
+
+        phonon.set_iter_mesh([3, 3, 3], is_mesh_symmetry=False)
+        td = ThermalDisplacements(phonon.get_iter_mesh(), masses)
+        td.set_temperature_range(0, 500, 100)
+        self.assertRaises(RuntimeError, td.run)
+
+    def testMeshHDF5Writer(self):
+        import tempfile
+        import h5py
+        from phonopy.phonon.mesh import MeshHDF5Writer
+
+        phonon = self._get_phonon()
+        phonon.set_mesh([4, 4, 4], is_eigenvectors=True)
+        _, _, mesh_freqs, mesh_eigvecs = phonon.get_mesh()
+
+        filename = os.path.join(tempfile.mkdtemp(), "mesh.hdf5")
+        phonon.set_iter_mesh([4, 4, 4], is_eigenvectors=True, block_size=2)
+        imesh = phonon.get_iter_mesh()
+        writer = MeshHDF5Writer(imesh, filename=filename, compression='gzip')
+        def interrupt(q_indices, f, e):
+            if q_indices[0] >= 2:
+                raise KeyboardInterrupt
+        imesh.add_consumer(writer)
+        imesh.add_consumer(interrupt)
+        self.assertRaises(KeyboardInterrupt, imesh.run)
+
+        phonon.set_iter_mesh([4, 4, 4], is_eigenvectors=True, block_size=2)
+        imesh = phonon.get_iter_mesh()
+        writer = MeshHDF5Writer(imesh, filename=filename, resume=True)
+        self.assertEqual(writer.get_num_finished_qpoints(), 4)
+        imesh.add_consumer(writer)
+        imesh.run(start=writer.get_num_finished_qpoints())
+
+        with h5py.File(filename, 'r') as f:
+            self.assertEqual(f.attrs['num_finished_qpoints'],
+                             len(mesh_freqs))
+            np.testing.assert_allclose(mesh_freqs, f['frequency'][:])
+            np.testing.assert_allclose(mesh_eigvecs, f['eigenvector'][:])
+        os.remove(filename)
+
+    def testMeshHDF5WriterNotResumable(self):
+        import tempfile
+        import h5py
+        from phonopy.phonon.mesh import MeshHDF5Writer
+
+        phonon = self._get_phonon()
+        phonon.set_group_velocity()
+        group_velocity = phonon._group_velocity
+        filename = os.path.join(tempfile.mkdtemp(), "mesh.hdf5")
+
+        def write_partly(is_eigenvectors, gv, block_size):
+            phonon.set_iter_mesh([4, 4, 4], is_eigenvectors=is_eigenvectors,
+                                 block_size=block_size)
+            imesh = phonon.get_iter_mesh()
+            writer = MeshHDF5Writer(imesh, filename=filename,
+                                    group_velocity=gv)
+            def interrupt(q_indices, f, e):
+                if q_indices[0] >= 2:
+                    raise KeyboardInterrupt
+            imesh.add_consumer(writer)
+            imesh.add_consumer(interrupt)
+            self.assertRaises(KeyboardInterrupt, imesh.run)
+
+        def resume(is_eigenvectors, gv, block_size):
+            phonon.set_iter_mesh([4, 4, 4], is_eigenvectors=is_eigenvectors,
+                                 block_size=block_size)
+            imesh = phonon.get_iter_mesh()
+            writer = MeshHDF5Writer(imesh, filename=filename,
+                                    group_velocity=gv, resume=True)
+            num_finished = writer.get_num_finished_qpoints()
+            imesh.add_consumer(writer)
+            imesh.run(start=num_finished)
+            with h5py.File(filename, 'r') as f:
+                self.assertEqual('eigenvector' in f, is_eigenvectors)
+                self.assertEqual('group_velocity' in f, gv is not None)
+                self.assertEqual(f.attrs['num_finished_qpoints'],
+                                 len(imesh.get_qpoints()))
+            return num_finished
+
+        sys.stdout = StringIO()
+        try:
+            settings = ((True, group_velocity, 2),
+                        (False, group_velocity, 2),
+                        (True, None, 2),
+                        (True, group_velocity, 3))
+            for setting in settings:
+                write_partly(True, group_velocity, 2)
+                num_finished = resume(*setting)
+                if setting == settings[0]:
+                    self.assertEqual(num_finished, 4)
+                else:
+                    self.assertEqual(num_finished, 0)
+            write_partly(False, None, 2)
+            self.assertEqual(resume(True, group_velocity, 2), 0)
+        finally:
+            sys.stdout = sys.__stdout__
+        os.remove(filename)
+
+    def _assert_eigenvectors(self, freqs, eigvecs, eigvecs_ref):
+        """Compare projectors onto (degenerate) eigenspaces
+
+        Eigenvectors are determined only up to phases and unitary
+        rotations in degenerate subspaces.
+
+        """
+        for f, e, e_ref in zip(freqs, eigvecs, eigvecs_ref):
+            i = 0
+            while i < len(f):
+                j = i + 1
+                while j < len(f) and abs(f[j] - f[i]) < 1e-5:
+                    j += 1
+                proj = np.dot(e[:, i:j], e[:, i:j].T.conj())
+                proj_ref = np.dot(e_ref[:, i:j], e_ref[:, i:j].T.conj())
+                np.testing.assert_allclose(proj, proj_ref, atol=1e-8)
+                i = j
 
     def _get_phonon(self):
         cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
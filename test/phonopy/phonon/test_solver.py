@@ -0,0 +1,126 @@
+import unittest
+import os
+import numpy as np
+from phonopy import Phonopy
+from phonopy.interface.vasp import read_vasp
+from phonopy.file_IO import parse_FORCE_SETS, parse_BORN
+from phonopy.phonon.solver import get_phonons_at_qpoints
+from phonopy.units import VaspToTHz
+
+data_dir = os.path.dirname(os.path.abspath(__file__))
+
+qpoints = [[0, 0, 0],
+           [0.1, 0.2, 0.3],
+           [0.5, 0, 0.5],
+           [0.25, 0.25, 0.25],
+           [0.5, 0.5, 0.5]]
+
+class TestSolver(unittest.TestCase):
+    def setUp(self):
+        pass
+
+    def tearDown(self):
+        pass
+
+    def test_get_phonons_at_qpoints(self):
+        self._compare(self._get_phonon())
+
+    def test_get_phonons_at_qpoints_Wang(self):
+        self._compare(self._get_phonon(nac_method='wang'))
+
+    def test_get_phonons_at_qpoints_Gonze(self):
+        self._compare(self._get_phonon(nac_method='gonze'))
+
+    def test_get_phonons_at_qpoints_per_qpoint(self):
+        for nac_method in (None, 'wang', 'gonze'):
+            self._compare_per_qpoint(self._get_phonon(nac_method=nac_method))
+
+    def test_get_phonons_at_qpoints_block_size(self):
+        phonon = self._get_phonon(nac_method='gonze')
+        dynmat = phonon.get_dynamical_matrix()
+        num_band = len(phonon.get_primitive().get_masses()) * 3
+        freqs = np.zeros((len(qpoints), num_band), dtype='double')
+        eigvecs = np.zeros((len(qpoints), num_band, num_band),
+                           dtype='complex128')
+        get_phonons_at_qpoints(freqs, eigvecs, dynmat, qpoints, VaspToTHz)
+        for block_size in (1, 2, 3):
+            f = np.zeros_like(freqs)
+            e = np.zeros_like(eigvecs)
+            get_phonons_at_qpoints(f, e, dynmat, qpoints, VaspToTHz,
+                                   block_size=block_size)
+            np.testing.assert_array_equal(freqs, f)
+            np.testing.assert_array_equal(eigvecs, e)
+
+    def _compare_per_qpoint(self, phonon):
+        """Results at a q-point don't depend on the other q-points"""
+        dynmat = phonon.get_dynamical_matrix()
+        num_band = len(phonon.get_primitive().get_masses()) * 3
+        freqs = np.zeros((len(qpoints), num_band), dtype='double')
+        eigvecs = np.zeros((len(qpoints), num_band, num_band),
+                           dtype='complex128')
+        get_phonons_at_qpoints(freqs, eigvecs, dynmat, qpoints, VaspToTHz)
+        for i, q in enumerate(qpoints):
+            f = np.zeros((1, num_band), dtype='double')
+            e = np.zeros((1, num_band, num_band), dtype='complex128')
+            get_phonons_at_qpoints(f, e, dynmat, [q], VaspToTHz)
+            np.testing.assert_array_equal(freqs[i], f[0])
+            np.testing.assert_array_equal(eigvecs[i], e[0])
+
+    def _compare(self, phonon):
+        dynmat = phonon.get_dynamical_matrix()
+        q_direction = [1, 0, 0]
+        num_band = len(phonon.get_primitive().get_masses()) * 3
+        freqs = np.zeros((len(qpoints), num_band), dtype='double')
+        eigvecs = np.zeros((len(qpoints), num_band, num_band),
+                           dtype='complex128')
+        get_phonons_at_qpoints(freqs,
+                               eigvecs,
+                               dynmat,
+                               qpoints,
+                               VaspToTHz,
+                               nac_q_direction=q_direction)
+        freqs_only = np.zeros_like(freqs)
+        get_phonons_at_qpoints(freqs_only,
+                               None,
+                               dynmat,
+                               qpoints,
+                               VaspToTHz,
+                               nac_q_direction=q_direction)
+        np.testing.assert_allclose(freqs, freqs_only, atol=1e-10)
+
+        for q, f, e in zip(qpoints, freqs, eigvecs):
+            if dynmat.is_nac() and (np.abs(q) < 1e-5).all():
+                dynmat.set_dynamical_matrix(q, q_direction=q_direction)
+            else:
+                dynmat.set_dynamical_matrix(q)
+            dm = dynmat.get_dynamical_matrix()
+            eigvals = np.linalg.eigvalsh(dm)
+            np.testing.assert_allclose(
+                f, np.sqrt(np.abs(eigvals)) * np.sign(eigvals) * VaspToTHz,
+                atol=1e-8)
+            np.testing.assert_allclose(np.dot(dm, e),
+                                       e * (eigvals[None, :]), atol=1e-10)
+
+    def _get_phonon(self, nac_method=None):
+        cell = read_vasp(os.path.join(data_dir, "../POSCAR_NaCl"))
+        phonon = Phonopy(cell,
+                         np.diag([2, 2, 2]),
+                         primitive_matrix=[[0, 0.5, 0.5],
+                                           [0.5, 0, 0.5],
+                                           [0.5, 0.5, 0]])
+        filename = os.path.join(data_dir, "../FORCE_SETS_NaCl")
+        force_sets = parse_FORCE_SETS(filename=filename)
+        phonon.set_displacement_dataset(force_sets)
+        phonon.produce_force_constants()
+        if nac_method is not None:
+            filename_born = os.path.join(data_dir, "../BORN_NaCl")
+            nac_params = parse_BORN(phonon.get_primitive(),
+                                    filename=filename_born)
+            nac_params['method'] = nac_method
+            phonon.set_nac_params(nac_params)
+        return phonon
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestSolver)
+    unittest.TextTestRunner(verbosity=2).run(suite)
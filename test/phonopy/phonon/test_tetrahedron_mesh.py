@@ -11,7 +11,12 @@ from phonopy.file_IO import parse_FORCE_SETS, parse_BORN
 from phonopy.structure.symmetry import Symmetry
 from phonopy.structure.spglib import get_stabilized_reciprocal_mesh
 from phonopy.structure.tetrahedron_method import TetrahedronMethod
-from phonopy.phonon.tetrahedron_mesh import TetrahedronMesh
+from phonopy.phonon.tetrahedron_mesh import (TetrahedronMesh,
+                                             get_tetrahedra_vertices,
+                                             get_tetrahedra_frequencies,
+                                             get_gp_ir_index)
+from phonopy.phonon.dos import (run_tetrahedron_method_dos,
+                                run_tetrahedron_method_dos_with_vertices)
 import os
 data_dir=os.path.dirname(os.path.abspath(__file__))
 
@@ -65,6 +70,103 @@ class TestTetrahedronMesh(unittest.TestCase):
         dos_comp = np.transpose([freq_points, dos]).reshape(10, 8)
         self.assertTrue(np.abs(dos_comp - data).all() < 1e-5)
 
+    def test_Amm2_tetrahedron_method_dos(self):
+        phonon = self._get_phonon("Amm2",
+                                  [3, 2, 2],
+                                  [[1, 0, 0],
+                                   [0, 0.5, -0.5],
+                                   [0, 0.5, 0.5]])
+        phonon.set_mesh([11, 11, 11])
+        phonon.set_total_DOS(tetrahedron_method=True)
+        _, dos = phonon.get_total_DOS()
+        total_dos = phonon._total_dos
+        total_dos._openmp_thm = False
+        total_dos.run()
+        _, dos_py = total_dos.get_dos()
+        np.testing.assert_allclose(dos, dos_py, atol=1e-10)
+
+    def test_Amm2_tetrahedra_vertices(self):
+        phonon = self._get_phonon("Amm2",
+                                  [3, 2, 2],
+                                  [[1, 0, 0],
+                                   [0, 0.5, -0.5],
+                                   [0, 0.5, 0.5]])
+        mesh = np.array([5, 5, 5], dtype='intc')
+        phonon.set_mesh(mesh)
+        frequencies = phonon.get_mesh()[2]
+        (grid_address,
+         ir_grid_points,
+         grid_mapping_table) = phonon.get_mesh_grid_info()
+        reciprocal_lattice = np.linalg.inv(
+            phonon.get_primitive().get_cell())
+        tm = TetrahedronMethod(reciprocal_lattice, mesh=mesh)
+        relative_grid_address = tm.get_tetrahedra()
+        gp_ir_index = get_gp_ir_index(grid_mapping_table, ir_grid_points)
+        vertices = {}
+        for lang in ('C', 'Py'):
+            vertices[lang] = get_tetrahedra_vertices(relative_grid_address,
+                                                     mesh,
+                                                     ir_grid_points,
+                                                     grid_address,
+                                                     gp_ir_index,
+                                                     lang=lang)
+        np.testing.assert_array_equal(vertices['C'], vertices['Py'])
+        for i, gp in enumerate(ir_grid_points):
+            t_freqs = get_tetrahedra_frequencies(gp,
+                                                 mesh,
+                                                 grid_address,
+                                                 relative_grid_address,
+                                                 gp_ir_index,
+                                                 frequencies)
+            np.testing.assert_allclose(
+                t_freqs, frequencies[vertices['C'][i]].transpose(2, 0, 1))
+
+    def test_Amm2_run_tetrahedron_method_dos(self):
+        phonon = self._get_phonon("Amm2",
+                                  [3, 2, 2],
+                                  [[1, 0, 0],
+                                   [0, 0.5, -0.5],
+                                   [0, 0.5, 0.5]])
+        mesh = np.array([5, 5, 5], dtype='intc')
+        phonon.set_mesh(mesh)
+        _, weights, frequencies, _ = phonon.get_mesh()
+        (grid_address,
+         ir_grid_points,
+         grid_mapping_table) = phonon.get_mesh_grid_info()
+        reciprocal_lattice = np.linalg.inv(
+            phonon.get_primitive().get_cell())
+        tm = TetrahedronMethod(reciprocal_lattice, mesh=mesh)
+        relative_grid_address = tm.get_tetrahedra()
+        gp_ir_index = get_gp_ir_index(grid_mapping_table, ir_grid_points)
+        vertices = get_tetrahedra_vertices(relative_grid_address,
+                                           mesh,
+                                           ir_grid_points,
+                                           grid_address,
+                                           gp_ir_index)
+        freq_points = np.linspace(0, np.max(frequencies), 20)
+        dos = run_tetrahedron_method_dos(mesh,
+                                         freq_points,
+                                         frequencies,
+                                         grid_address,
+                                         grid_mapping_table,
+                                         relative_grid_address)
+        dos_vertices = run_tetrahedron_method_dos_with_vertices(
+            mesh, freq_points, frequencies, weights, vertices)
+        np.testing.assert_allclose(dos, dos_vertices, atol=1e-12)
+
+        self.assertRaises(ValueError,
+                          run_tetrahedron_method_dos,
+                          mesh,
+                          freq_points,
+                          frequencies[:-1],
+                          grid_address,
+                          grid_mapping_table,
+                          relative_grid_address)
+        self.assertRaises(ValueError,
+                          run_tetrahedron_method_dos_with_vertices,
+                          mesh, freq_points, frequencies, weights[:-1],
+                          vertices)
+
     def _show(self, freq_points, dos):
         data = []
         for f, d in zip(freq_points, dos):
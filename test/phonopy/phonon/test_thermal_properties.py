@@ -0,0 +1,60 @@
+import unittest
+import numpy as np
+import phonopy._phonopy as phonoc
+
+KB = 8.6173382568083159E-05
+
+def get_thermal_properties_ref(temperatures, freqs, weights):
+    """Thermal properties by the formulae of the previous C kernel"""
+    tp = np.zeros((len(temperatures), 3), dtype='double')
+    for i, t in enumerate(temperatures):
+        if not t > 0:
+            continue
+        for f_q, w in zip(freqs, weights):
+            f = f_q[f_q > 0]
+            val = f / (2 * KB * t)
+            x = f / (KB * t)
+            tp[i, 0] += np.sum(KB * t * np.log(1 - np.exp(-x))) * w
+            tp[i, 1] += np.sum(1 / (2 * t) * f * np.cosh(val) / np.sinh(val)
+                               - KB * np.log(2 * np.sinh(val))) * w
+            tp[i, 2] += np.sum(KB * np.exp(x) * (x / (np.exp(x) - 1)) ** 2) * w
+    return tp / np.sum(weights)
+
+
+class TestThermalProperties(unittest.TestCase):
+    def setUp(self):
+        np.random.seed(0)
+        self._temperatures = np.arange(0, 1001, 50, dtype='double')
+        self._freqs = np.array(np.random.rand(100, 6) * 0.08 - 0.002,
+                               dtype='double', order='C')
+        self._weights = np.array(np.random.randint(1, 49, size=100),
+                                 dtype='intc')
+
+    def tearDown(self):
+        pass
+
+    def test_thermal_properties(self):
+        props = self._run()
+        props_ref = get_thermal_properties_ref(self._temperatures,
+                                               self._freqs,
+                                               self._weights)
+        np.testing.assert_allclose(props, props_ref, rtol=1e-10, atol=1e-16)
+
+    def test_thermal_properties_reproducible(self):
+        props = self._run()
+        for i in range(5):
+            np.testing.assert_array_equal(props, self._run())
+
+    def _run(self):
+        props = np.zeros((len(self._temperatures), 3),
+                         dtype='double', order='C')
+        phonoc.thermal_properties(props,
+                                  self._temperatures,
+                                  self._freqs,
+                                  self._weights)
+        return props
+
+
+if __name__ == '__main__':
+    suite = unittest.TestLoader().loadTestsFromTestCase(TestThermalProperties)
+    unittest.TextTestRunner(verbosity=2).run(suite)
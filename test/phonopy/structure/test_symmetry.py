@@ -4,6 +4,9 @@ import numpy as np
 import time
 
 from phonopy.structure.symmetry import Symmetry
+from phonopy.structure.spglib import (SymmetryContext, get_symmetry_dataset,
+                                      get_supercell_symmetry)
+from phonopy.structure.atoms import PhonopyAtoms
 from phonopy.structure.cells import get_supercell
 from phonopy.interface.phonopy_yaml import get_unitcell_from_phonopy_yaml
 import os
@@ -68,6 +71,143 @@ class TestSymmetry(unittest.TestCase):
         self.assertTrue(len_sym_nonspin == len_sym_withspin)
         self.assertFalse(len_sym_nonspin == len_sym_brokenspin)
 
+    def test_symmetry_context(self):
+        symprec = 1e-5
+        cell = get_unitcell_from_phonopy_yaml(
+            os.path.join(data_dir,"../NaCl.yaml"))
+        scell = get_supercell(cell, np.diag([2, 2, 2]), symprec=symprec)
+        numbers = scell.get_atomic_numbers()
+        numbers[0] = 3
+        context = SymmetryContext(symprec=symprec)
+        for strain in (np.eye(3),
+                       np.eye(3) * 1.01,
+                       np.diag([1.01, 1, 1]),
+                       np.diag([1.01, 1.01, 1.01])):
+            for nums in (scell.get_atomic_numbers(), numbers):
+                scell_strained = PhonopyAtoms(
+                    cell=np.dot(scell.get_cell(), strain),
+                    scaled_positions=scell.get_scaled_positions(),
+                    numbers=nums)
+                symmetry = Symmetry(scell_strained, symprec=symprec)
+                symmetry_ctx = Symmetry(scell_strained,
+                                        symprec=symprec,
+                                        symmetry_context=context)
+                ds = symmetry.get_dataset()
+                ds_ctx = symmetry_ctx.get_dataset()
+                for key in ('number', 'hall_number', 'wyckoffs'):
+                    self.assertEqual(ds[key], ds_ctx[key])
+                for key in ('transformation_matrix', 'origin_shift',
+                            'rotations', 'translations', 'equivalent_atoms',
+                            'std_lattice', 'std_types', 'std_positions'):
+                    np.testing.assert_allclose(ds[key], ds_ctx[key],
+                                               atol=1e-8)
+
+    def test_symmetry_context_hint(self):
+        cell = get_unitcell_from_phonopy_yaml(
+            os.path.join(data_dir, "Si-conv.yaml"))
+        context = SymmetryContext()
+        # Fd-3m origin choice 2 instead of the default 525
+        context.set_hint(hall_number=526)
+        for strain in (np.eye(3), np.eye(3) * 1.01):
+            scell = PhonopyAtoms(cell=np.dot(cell.get_cell(), strain),
+                                 scaled_positions=cell.get_scaled_positions(),
+                                 numbers=cell.get_atomic_numbers())
+            self.assertEqual(
+                context.get_symmetry_dataset(scell)['hall_number'], 526)
+        context.set_hint()
+        for strain in (np.eye(3) * 1.02, np.eye(3) * 1.03):
+            scell = PhonopyAtoms(cell=np.dot(cell.get_cell(), strain),
+                                 scaled_positions=cell.get_scaled_positions(),
+                                 numbers=cell.get_atomic_numbers())
+            self.assertEqual(
+                context.get_symmetry_dataset(scell)['hall_number'],
+                get_symmetry_dataset(scell)['hall_number'])
+
+    def test_phonopy_unitcell_symmetry(self):
+        from phonopy import Phonopy
+        cell = get_unitcell_from_phonopy_yaml(
+            os.path.join(data_dir, "Si-conv.yaml"))
+        phonon = Phonopy(cell, np.diag([2, 2, 2]))
+        self.assertTrue(phonon.get_symmetry()._map_operations is None)
+        phonon_u = Phonopy(cell, np.diag([2, 2, 2]),
+                           use_unitcell_symmetry=True)
+        self.assertTrue(phonon_u.get_symmetry()._map_operations is not None)
+        self.assertEqual(len(phonon.get_symmetry().get_map_operations()),
+                         len(phonon_u.get_symmetry().get_map_operations()))
+
+    def test_supercell_symmetry(self):
+        symprec = 1e-5
+        cell = get_unitcell_from_phonopy_yaml(
+            os.path.join(data_dir,"../NaCl.yaml"))
+        # Whether all unit cell operations are kept and the dataset is
+        # made from unit cell symmetry instead of the full search
+        for smat, is_kept in ((np.diag([2, 2, 2]), True),
+                              (np.diag([2, 2, 3]), False),
+                              ([[-1, 1, 1], [1, -1, 1], [1, 1, -1]], True),
+                              ([[1, 1, 0], [0, 1, 0], [0, 0, 1]], True),
+                              ([[0, 1, 1], [1, 0, 1], [1, 1, 0]], True)):
+            scell = get_supercell(cell, smat, symprec=symprec)
+            symmetry = Symmetry(scell, symprec=symprec)
+            symmetry_u = Symmetry(scell, symprec=symprec, unitcell=cell)
+            self.assertEqual(symmetry_u._map_operations is not None, is_kept)
+            ds = symmetry.get_dataset()
+            ds_u = symmetry_u.get_dataset()
+            for key in ('number', 'hall_number', 'wyckoffs'):
+                self.assertEqual(ds[key], ds_u[key])
+            np.testing.assert_array_equal(ds['equivalent_atoms'],
+                                          ds_u['equivalent_atoms'])
+            self.assertEqual(len(ds['rotations']), len(ds_u['rotations']))
+            ops = set()
+            for r, t in zip(ds['rotations'], ds['translations']):
+                ops.add(self._get_operation_key(r, t))
+            for r, t in zip(ds_u['rotations'], ds_u['translations']):
+                self.assertTrue(self._get_operation_key(r, t) in ops)
+
+            positions = scell.get_scaled_positions()
+            map_ops = symmetry_u.get_map_operations()
+            map_atoms = symmetry_u.get_map_atoms()
+            for i, (op_i, atom_i) in enumerate(zip(map_ops, map_atoms)):
+                r_pos = (np.dot(ds_u['rotations'][op_i], positions[i]) +
+                         ds_u['translations'][op_i])
+                diff = positions[atom_i] - r_pos
+                diff -= np.rint(diff)
+                self.assertTrue((np.abs(diff) < symprec).all())
+
+    def test_supercell_symmetry_operations(self):
+        """Supercells where part of the unit cell operations are lost"""
+        symprec = 1e-5
+        cell = get_unitcell_from_phonopy_yaml(
+            os.path.join(data_dir,"../NaCl.yaml"))
+        dataset = get_symmetry_dataset(cell, symprec=symprec)
+        for smat, num_ops in (([[2, 1, 0], [0, 1, 0], [0, 0, 1]], 128),
+                              ([[1, 1, 0], [0, 1, 0], [0, 0, 1]], 192),
+                              ([[5, 1, 0], [0, 5, 1], [1, 0, 5]], 3024)):
+            scell = get_supercell(cell, smat, symprec=symprec)
+            sym = get_supercell_symmetry(cell, dataset, scell, smat, symprec)
+            self.assertTrue(sym is not None)
+            self.assertEqual(len(sym['rotations']), num_ops)
+            ds = get_symmetry_dataset(scell, symprec=symprec)
+            self.assertEqual(len(ds['rotations']), num_ops)
+            ops = set()
+            for r, t in zip(ds['rotations'], ds['translations']):
+                ops.add(self._get_operation_key(r, t))
+            for r, t in zip(sym['rotations'], sym['translations']):
+                self.assertTrue(self._get_operation_key(r, t) in ops)
+            np.testing.assert_array_equal(ds['equivalent_atoms'],
+                                          sym['equivalent_atoms'])
+
+            positions = scell.get_scaled_positions()
+            for i, op_i in enumerate(sym['map_operations']):
+                r_pos = (np.dot(sym['rotations'][op_i], positions[i]) +
+                         sym['translations'][op_i])
+                diff = positions[sym['equivalent_atoms'][i]] - r_pos
+                diff -= np.rint(diff)
+                self.assertTrue((np.abs(diff) < symprec).all())
+
+    def _get_operation_key(self, r, t):
+        t_mod = np.rint((t - np.rint(t)) * 1e6).astype(int) % 1000000
+        return tuple(r.ravel()) + tuple(t_mod)
+
 if __name__ == '__main__':
     suite = unittest.TestLoader().loadTestsFromTestCase(TestSymmetry)
     unittest.TextTestRunner(verbosity=2).run(suite)